@@ -6,12 +6,34 @@
  * @date 17.05.2020
  */
  
+#define _POSIX_C_SOURCE 200809L
+
 #include "gamma.h"
 #include "input.h"
+#include "latency.h"
+#include "checkpoint.h"
+#include "events.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Największa liczba ruchów wykonywanych razem funkcją @ref gamma_moves.
+ */
+#define WINDOW 1024
+
+/**
+ * Struktura przechowująca ruchy czekające na wykonanie.
+ */
+struct window {
+  uint32_t threads; ///<liczba wątków wykonujących ruchy
+  uint64_t count; ///<liczba czekających ruchów
+  struct gamma_move_args moves[WINDOW]; ///<czekające ruchy
+  bool results[WINDOW]; ///<wyniki ruchów
+};
 
 /** @brief Sprawdza czy znak oznacza pewną komenę.
  * Sprawdza czy znak @p c jest poprawnym początkiem polecenia w trybie wsadowym.
@@ -20,21 +42,121 @@
  * wartość @p false w przeciwnym przyapdku.
  */
 static bool command(int c) {
-  if (c == 'm' || c == 'g' || c == 'b' || c == 'f' || c == 'q' || c == 'p')
+  if (c == 'm' || c == 'g' || c == 'b' || c == 'f' || c == 'q' || c == 'p'
+      || c == 's')
     return true;
   return false;
 }
 
+/** @brief Wypisuje statystyki silnika.
+ * Dla każdej funkcji interfejsu wypisuje wiersz z jej nazwą, liczbą wywołań,
+ * liczbą odwiedzonych pól, liczbą kroków w drzewach obszarów i liczbą
+ * próbnych złotych ruchów.
+ * @param[in] g     – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli statystyki zostały wypisane, a @p false,
+ * gdy silnik skompilowano bez statystyk.
+ */
+static bool print_stats(gamma_t* g) {
+  uint64_t value;
+  if (gamma_counter(g, gamma_api_move, gamma_counter_calls, &value) == false)
+    return false;
+  
+  for (int i = 0; gamma_api_name((enum gamma_api)i) != NULL; i++) {
+    printf("%s", gamma_api_name((enum gamma_api)i));
+    for (int j = 0; gamma_counter(g, (enum gamma_api)i, (enum gamma_counter)j,
+                                  &value) == true; j++)
+      printf(" %lu", value);
+    printf("\n");
+  }
+  return true;
+}
+
+/** @brief Podaje bieżący czas, jeśli pomiary są włączone.
+ * @param[in] l     – wskaźnik na histogramy czasów lub @p NULL.
+ * @return Czas w nanosekundach lub @p 0, jeśli @p l ma wartość @p NULL.
+ */
+static uint64_t tick(latency_t* l) {
+  if (l == NULL) return 0;
+  return latency_now();
+}
+
+/** @brief Zapisuje czasy wczytania i wykonania polecenia.
+ * @param[in, out] l  – wskaźnik na histogramy czasów lub @p NULL,
+ * @param[in] c       – znak polecenia,
+ * @param[in] begin   – czas wczytania pierwszego znaku wiersza,
+ * @param[in] parsed  – czas zakończenia wczytywania wiersza,
+ * @param[in] done    – czas zakończenia wykonania polecenia.
+ */
+static void measure(latency_t* l, int c, uint64_t begin, uint64_t parsed,
+                    uint64_t done) {
+  if (l == NULL) return;
+  latency_record(l, 0, parsed - begin);
+  latency_record(l, c, done - parsed);
+}
+
+/** @brief Wczytuje liczbę wątków.
+ * @return Wartość zmiennej środowiskowej @p GAMMA_THREADS ograniczona do
+ * liczby dostępnych procesorów lub @p 1, jeśli nie jest ustawiona lub nie
+ * jest liczbą dodatnią.
+ */
+static uint32_t threads() {
+  const char* value = getenv("GAMMA_THREADS");
+  if (value == NULL) return 1;
+  char* end;
+  unsigned long result = strtoul(value, &end, 10);
+  if (*end != '\0' || result == 0) return 1;
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  if (online < 1) return 1;
+  if (result > (unsigned long)online) result = (unsigned long)online;
+  return (uint32_t)result;
+}
+
+/** @brief Wykonuje czekające ruchy.
+ * Wykonuje ruchy funkcją @ref gamma_moves i wypisuje ich wyniki oraz
+ * zdarzenia udanych ruchów.
+ * @param[in, out] w  – wskaźnik na czekające ruchy,
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] e  – wskaźnik na strumień zdarzeń lub @p NULL.
+ */
+static void flush(struct window* w, gamma_t* g, events_t* e) {
+  if ((*w).count == 0) return;
+  gamma_moves(g, (*w).moves, (*w).count, (*w).results, (*w).threads);
+  for (uint64_t i = 0; i < (*w).count; i++) {
+    printf("%d\n", (int)(*w).results[i]);
+    if ((*w).results[i] == true) {
+      events_move(e, (*w).moves[i].player, (*w).moves[i].x, (*w).moves[i].y,
+                  0);
+    }
+  }
+  (*w).count = 0;
+}
+
 void batch(unsigned long long* line, gamma_t** g) {
   bool eof = false;
+  latency_t* l = latency_start();
+  checkpoint_t* cp = checkpoint_start(*line);
+  events_t* e = events_start(*g);
+  // Pomiary czasu dotyczą pojedynczych poleceń, więc wtedy nie czekam.
+  struct window* w = NULL;
+  if (l == NULL && threads() > 1) w = malloc(sizeof(struct window));
+  if (w != NULL) {
+    (*w).threads = threads();
+    (*w).count = 0;
+  }
   
   while (eof == false) {
     int c = getchar();
+    // Czekanie na wiersz nie jest czasem wczytania polecenia, więc pomiar
+    // zaczyna się dopiero po pierwszym znaku. Pozostałe znaki wiersza są
+    // zwykle już w buforze wejścia.
+    uint64_t begin = tick(l);
     (*line)++;
     
     if (command(c) == false) {
-      if (c != '#' && c != '\n' && c != EOF)
+      if (c != '#' && c != '\n' && c != EOF) {
+        if (w != NULL) flush(w, *g, e);
         line_error(*line);
+      }
       read_line(&eof, c);
     }
     
@@ -42,7 +164,7 @@ void batch(unsigned long long* line, gamma_t** g) {
       if (c == 'm' || c == 'g') {
         bool eol = false;
         bool valid = true;
-        uint32_t player, x, y;
+        uint32_t player = 0, x = 0, y = 0;
         
         int next_int = getchar();
         next_int = read_parameter(&eof, &eol, &valid,
@@ -60,19 +182,32 @@ void batch(unsigned long long* line, gamma_t** g) {
           }
         }
         
-        if (valid == true) {
-          if (c == 'm') printf("%d\n",(int)(gamma_move((*g), player, x, y)));
-          if (c == 'g') printf("%d\n",(int)gamma_golden_move((*g), player, x, y));
+        if (valid == true && c == 'm' && w != NULL) {
+          (*w).moves[(*w).count++] = (struct gamma_move_args){player, x, y};
+          if ((*w).count == WINDOW) flush(w, *g, e);
+        }
+        else if (valid == true) {
+          if (w != NULL) flush(w, *g, e);
+          uint32_t previous = c == 'g' ? events_before(e, *g, x, y) : 0;
+          uint64_t parsed = tick(l);
+          bool result = c == 'm' ? gamma_move((*g), player, x, y)
+                                 : gamma_golden_move((*g), player, x, y);
+          measure(l, c, begin, parsed, tick(l));
+          printf("%d\n", (int)result);
+          if (result == true) events_move(e, player, x, y, previous);
         }
         else {
+          if (w != NULL) flush(w, *g, e);
           line_error(*line);
         }
       }
       
+      if (c != 'm' && c != 'g' && w != NULL) flush(w, *g, e);
+      
       if (c == 'b' || c == 'f' || c == 'q') {
         bool eol = false;
         bool valid = true;
-        uint32_t player;
+        uint32_t player = 0;
         
         int next_int = getchar();
         next_int = read_parameter(&eof, &eol, &valid,
@@ -87,16 +222,20 @@ void batch(unsigned long long* line, gamma_t** g) {
         }
         
         if (valid == true) {
-          if (c == 'b') printf("%lu\n", gamma_busy_fields((*g), player));
-          if (c == 'f') printf("%lu\n", gamma_free_fields((*g), player));
-          if (c == 'q') printf("%d\n", (int)gamma_golden_possible((*g), player));
+          uint64_t parsed = tick(l);
+          uint64_t result;
+          if (c == 'b') result = gamma_busy_fields((*g), player);
+          else if (c == 'f') result = gamma_free_fields((*g), player);
+          else result = (uint64_t)gamma_golden_possible((*g), player);
+          measure(l, c, begin, parsed, tick(l));
+          printf("%lu\n", result);
         }
         else {
           line_error(*line);
         }
       }
       
-      if (c == 'p') {
+      if (c == 'p' || c == 's') {
         bool valid = true;
         bool eol = false;
         char temp = read_empty(&eof, &eol, &valid, getchar());
@@ -104,8 +243,15 @@ void batch(unsigned long long* line, gamma_t** g) {
           read_line(&eof, temp);
           valid = false;
         }
-        if (valid == true) {
+        if (valid == true && c == 's') {
+          uint64_t parsed = tick(l);
+          if (print_stats((*g)) == false) line_error(*line);
+          measure(l, c, begin, parsed, tick(l));
+        }
+        else if (valid == true) {
+          uint64_t parsed = tick(l);
           char* p = gamma_board((*g));
+          measure(l, c, begin, parsed, tick(l));
           
           if (p != NULL) printf("%s", p);
           else line_error(*line);
@@ -117,5 +263,13 @@ void batch(unsigned long long* line, gamma_t** g) {
         }
       }
     }
+    // Punkt kontrolny opisuje tylko wykonane wiersze.
+    if (eof == false && (w == NULL || (*w).count == 0))
+      checkpoint_tick(cp, (*g), *line);
   } 
+  if (w != NULL) flush(w, *g, e);
+  free(w);
+  events_finish(e);
+  checkpoint_finish(cp);
+  latency_finish(l);
 }
\ No newline at end of file
@@ -18,6 +18,17 @@
  * Jeśli wiersz zawiera poprawne polecenie, wykonuje odpowiednią funkcję
  * i wypisuje jej wynik na standardowe wyjście. 
  * Wartość @p false wypisuje jako @p 0, a wartość @p true jako @p 1.
+ * Jeśli ustawiono zmienną środowiskową @p GAMMA_LATENCY, mierzy czasy
+ * wczytania i wykonania poprawnych poleceń i po znaku @p EOF wypisuje ich
+ * percentyle, patrz @ref latency.h.
+ * Jeśli ustawiono zmienną środowiskową @p GAMMA_CHECKPOINT, co pewien czas
+ * zapisuje punkt kontrolny, patrz @ref checkpoint.h.
+ * Jeśli zmienna środowiskowa @p GAMMA_THREADS ma wartość większą od jednego,
+ * kolejne polecenia @p m są zbierane i wykonywane razem przez tyle wątków
+ * funkcją @ref gamma_moves przed następnym poleceniem innego rodzaju lub
+ * błędnym wierszem; wyniki są takie same jak przy wykonywaniu po kolei.
+ * Jeśli ustawiono zmienną środowiskową @p GAMMA_EVENTS, wypisuje zdarzenie
+ * po każdym udanym ruchu, patrz @ref events.h.
  * @param[in, out] line   – wskaźnik na numer aktualnej linii wejścia,
  * @param[in, out] g      – wskaźnik na wskaźnik na strukturę przechowującą 
  *                          stan gry.
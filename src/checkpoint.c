@@ -0,0 +1,224 @@
+/** @file
+ * Implementacja modułu zapisującego punkty kontrolne trybu wsadowego.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/**
+ * Napis rozpoczynający opis położenia w plikach.
+ */
+#define RECORD_MAGIC "GAMMACKP"
+
+/**
+ * Domyślna liczba wierszy między punktami kontrolnymi.
+ */
+#define DEFAULT_EVERY 1000000
+
+/**
+ * Struktura przechowująca ustawienia i stan zapisu punktów kontrolnych.
+ */
+struct checkpoint {
+  const char* path; ///<nazwa pliku punktu kontrolnego
+  unsigned long long every; ///<liczba wierszy między zapisami lub zero
+  uint64_t seconds; ///<liczba sekund między zapisami lub zero
+  unsigned long long last_line; ///<numer wiersza z ostatniej próby zapisu
+  uint64_t last_time; ///<czas ostatniej próby zapisu w sekundach
+  pid_t writer; ///<proces zapisujący punkt kontrolny lub @p -1
+};
+
+/** @brief Opis położenia w plikach.
+ * Zapisywany w pliku punktu kontrolnego zaraz za stanem gry.
+ */
+struct record {
+  char magic[8]; ///<napis @ref RECORD_MAGIC
+  int64_t input; ///<położenie w standardowym wejściu
+  uint64_t line; ///<numer ostatnio wczytanego wiersza wejścia
+  int64_t output; ///<długość standardowego wyjścia lub @p -1
+  int64_t errors; ///<długość standardowego wyjścia diagnostycznego lub @p -1
+  uint64_t checksum; ///<suma kontrolna poprzednich pól
+};
+
+/** @brief Liczy sumę kontrolną opisu położenia.
+ * @param[in] r       – wskaźnik na opis położenia.
+ * @return Suma kontrolna wszystkich pól poza ostatnim.
+ */
+static uint64_t record_checksum(const struct record* r) {
+  const unsigned char* bytes = (const unsigned char*)r;
+  uint64_t sum = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < offsetof(struct record, checksum); i++)
+    sum = (sum ^ bytes[i]) * 0x100000001b3ULL;
+  return sum;
+}
+
+/** @brief Podaje bieżący czas.
+ * @return Czas zegara monotonicznego w sekundach.
+ */
+static uint64_t now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec;
+}
+
+/** @brief Wczytuje liczbę ze zmiennej środowiskowej.
+ * @param[in] name    – nazwa zmiennej środowiskowej.
+ * @return Wartość zmiennej lub zero, jeśli nie jest ustawiona lub nie jest
+ * liczbą.
+ */
+static unsigned long long from_environment(const char* name) {
+  const char* value = getenv(name);
+  if (value == NULL) return 0;
+  char* end;
+  unsigned long long result = strtoull(value, &end, 10);
+  return *end == '\0' ? result : 0;
+}
+
+/** @brief Podaje długość pliku wyjściowego.
+ * Opróżnia bufor pliku @p f.
+ * @param[in] f       – plik wyjściowy.
+ * @return Położenie w pliku lub @p -1, jeśli @p f nie jest zwykłym plikiem.
+ */
+static int64_t output_length(FILE* f) {
+  struct stat s;
+  fflush(f);
+  if (fstat(fileno(f), &s) != 0 || S_ISREG(s.st_mode) == false) return -1;
+  return (int64_t)ftello(f);
+}
+
+/** @brief Zapisuje punkt kontrolny.
+ * Wykonywana w procesie potomnym.
+ * @param[in] c       – wskaźnik na strukturę przechowującą ustawienia zapisu,
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] r       – wskaźnik na opis położenia w plikach.
+ * @return Wartość @p true, jeśli się udało, a @p false w przeciwnym przypadku.
+ */
+static bool write_checkpoint(checkpoint_t* c, gamma_t* g, struct record* r) {
+  size_t length = strlen((*c).path);
+  char* temporary = malloc(length + sizeof(".tmp"));
+  if (temporary == NULL) return false;
+  memcpy(temporary, (*c).path, length);
+  memcpy(temporary + length, ".tmp", sizeof(".tmp"));
+
+  bool result = false;
+  int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd >= 0) {
+    result = gamma_save(g, fd)
+             && write(fd, r, sizeof(struct record)) == sizeof(struct record)
+             && fsync(fd) == 0;
+    result = close(fd) == 0 && result;
+    result = result && rename(temporary, (*c).path) == 0;
+    if (result == false) unlink(temporary);
+  }
+  free(temporary);
+  return result;
+}
+
+checkpoint_t* checkpoint_start(unsigned long long line) {
+  const char* path = getenv("GAMMA_CHECKPOINT");
+  if (path == NULL || strcmp(path, "") == 0) return NULL;
+
+  checkpoint_t* c = malloc(sizeof(checkpoint_t));
+  if (c == NULL) return NULL;
+  (*c).path = path;
+  (*c).every = from_environment("GAMMA_CHECKPOINT_EVERY");
+  (*c).seconds = from_environment("GAMMA_CHECKPOINT_SECONDS");
+  if ((*c).every == 0 && (*c).seconds == 0) (*c).every = DEFAULT_EVERY;
+  (*c).last_line = line;
+  (*c).last_time = (*c).seconds != 0 ? now() : 0;
+  (*c).writer = -1;
+  return c;
+}
+
+void checkpoint_tick(checkpoint_t* c, gamma_t* g, unsigned long long line) {
+  if (c == NULL) return;
+  bool due = (*c).every != 0 && line - (*c).last_line >= (*c).every;
+  if (due == false && (*c).seconds != 0)
+    due = now() - (*c).last_time >= (*c).seconds;
+  if (due == false) return;
+
+  (*c).last_line = line;
+  if ((*c).seconds != 0) (*c).last_time = now();
+  if ((*c).writer > 0) {
+    if (waitpid((*c).writer, NULL, WNOHANG) == 0) return; // Zapis trwa.
+    (*c).writer = -1;
+  }
+
+  struct record r;
+  memcpy(r.magic, RECORD_MAGIC, sizeof(r.magic));
+  r.input = (int64_t)ftello(stdin);
+  if (r.input < 0) return; // Wejście nie jest plikiem.
+  r.line = line;
+  r.output = output_length(stdout);
+  r.errors = output_length(stderr);
+  r.checksum = record_checksum(&r);
+
+  pid_t pid = fork();
+  if (pid == 0) _exit(write_checkpoint(c, g, &r) == true ? 0 : 1);
+  if (pid > 0) (*c).writer = pid;
+}
+
+void checkpoint_finish(checkpoint_t* c) {
+  if (c == NULL) return;
+  if ((*c).writer > 0) {
+    while (waitpid((*c).writer, NULL, 0) < 0 && errno == EINTR) {}
+  }
+  free(c);
+}
+
+/** @brief Przywraca długość pliku wyjściowego.
+ * Skraca plik @p f do długości @p length i ustawia w nim położenie, jeśli
+ * plik jest zwykłym plikiem o długości co najmniej @p length. W przeciwnym
+ * przypadku nic nie robi.
+ * @param[in] f       – plik wyjściowy,
+ * @param[in] length  – długość pliku w chwili zapisu punktu kontrolnego lub
+ *                      @p -1.
+ */
+static void restore_output(FILE* f, int64_t length) {
+  struct stat s;
+  if (length < 0 || fstat(fileno(f), &s) != 0 || S_ISREG(s.st_mode) == false
+      || s.st_size < length) return;
+  if (ftruncate(fileno(f), (off_t)length) == 0)
+    fseeko(f, (off_t)length, SEEK_SET);
+}
+
+gamma_t* checkpoint_resume(unsigned long long* line) {
+  const char* path = getenv("GAMMA_CHECKPOINT");
+  if (path == NULL || strcmp(path, "") == 0) return NULL;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  gamma_t* g = gamma_load(fd);
+  struct record r;
+  bool valid = g != NULL && read(fd, &r, sizeof(r)) == sizeof(r)
+               && memcmp(r.magic, RECORD_MAGIC, sizeof(r.magic)) == 0
+               && r.checksum == record_checksum(&r)
+               && fseeko(stdin, (off_t)r.input, SEEK_SET) == 0;
+  close(fd);
+  if (valid == false) {
+    gamma_delete(g);
+    return NULL;
+  }
+
+  restore_output(stdout, r.output);
+  restore_output(stderr, r.errors);
+  *line = r.line;
+  return g;
+}
@@ -0,0 +1,71 @@
+/** @file
+ * Interfejs modułu zapisującego punkty kontrolne trybu wsadowego.
+ * Punkty kontrolne są włączane zmienną środowiskową @p GAMMA_CHECKPOINT,
+ * której wartością jest nazwa pliku punktu kontrolnego. Zmienna
+ * @p GAMMA_CHECKPOINT_EVERY podaje, co ile wierszy wejścia, a zmienna
+ * @p GAMMA_CHECKPOINT_SECONDS, co ile sekund zapisywany jest punkt kontrolny;
+ * jeśli żadna z nich nie jest ustawiona, punkt kontrolny jest zapisywany co
+ * milion wierszy. Punkt kontrolny zawiera stan gry zapisany funkcją
+ * @ref gamma_save, położenie w pliku wejściowym, numer wiersza i długości
+ * plików wyjściowych, więc wejście musi być plikiem, a nie potokiem.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "gamma.h"
+
+/**
+ * Typ przechowujący ustawienia i stan zapisu punktów kontrolnych.
+ */
+typedef struct checkpoint checkpoint_t;
+
+/** @brief Rozpoczyna zapisywanie punktów kontrolnych.
+ * Jeśli ustawiono zmienną środowiskową @p GAMMA_CHECKPOINT, tworzy strukturę
+ * przechowującą ustawienia zapisu.
+ * @param[in] line    – numer ostatnio wczytanego wiersza wejścia.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, gdy punkty kontrolne
+ * są wyłączone lub nie udało się zaalokować pamięci.
+ */
+checkpoint_t* checkpoint_start(unsigned long long line);
+
+/** @brief Zapisuje punkt kontrolny, jeśli nadszedł jego czas.
+ * Wywoływana po wykonaniu każdego wiersza wejścia. Punkt kontrolny zapisuje
+ * proces potomny utworzony funkcją @p fork, który widzi niezmienioną kopię
+ * pamięci, więc rozgrywka toczy się dalej bez czekania na zapis. Plik jest
+ * zapisywany pod tymczasową nazwą i dopiero potem przemianowywany, więc
+ * zawsze zawiera cały najnowszy punkt kontrolny. Jeśli poprzedni zapis jeszcze
+ * trwa lub wejście nie jest plikiem, punkt kontrolny jest pomijany.
+ * Nic nie robi, jeśli wskaźnik @p c ma wartość @p NULL.
+ * @param[in, out] c  – wskaźnik na strukturę przechowującą ustawienia zapisu,
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] line    – numer ostatnio wczytanego wiersza wejścia.
+ */
+void checkpoint_tick(checkpoint_t* c, gamma_t* g, unsigned long long line);
+
+/** @brief Kończy zapisywanie punktów kontrolnych.
+ * Czeka na zakończenie trwającego zapisu i usuwa strukturę wskazywaną przez
+ * @p c. Nic nie robi, jeśli wskaźnik ten ma wartość @p NULL.
+ * @param[in] c       – wskaźnik na strukturę przechowującą ustawienia zapisu.
+ */
+void checkpoint_finish(checkpoint_t* c);
+
+/** @brief Wznawia rozgrywkę z punktu kontrolnego.
+ * Wczytuje stan gry z pliku wskazanego zmienną środowiskową
+ * @p GAMMA_CHECKPOINT, ustawia standardowe wejście za ostatnim wykonanym
+ * wierszem, a standardowe wyjście i standardowe wyjście diagnostyczne, jeśli
+ * są plikami o długości co najmniej takiej jak w chwili zapisu, skraca do tej
+ * długości. Dzięki temu wyniki i numery wierszy w komunikatach
+ * @p "ERROR line" są kontynuowane dokładnie od miejsca zapisu.
+ * @param[out] line   – wskaźnik na numer ostatnio wczytanego wiersza wejścia.
+ * @return Wskaźnik na wczytany stan gry lub @p NULL, jeśli nie ustawiono
+ * zmiennej środowiskowej, punkt kontrolny jest niepoprawny lub nie udało się
+ * ustawić standardowego wejścia.
+ */
+gamma_t* checkpoint_resume(unsigned long long* line);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,144 @@
+/** @file
+ * Implementacja modułu wypisującego strumień zdarzeń trybu wsadowego.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "events.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+/**
+ * Napis rozpoczynający binarny strumień zdarzeń.
+ */
+#define EVENTS_MAGIC "GAMMAEVT"
+
+/**
+ * Struktura przechowująca ustawienia i stan strumienia zdarzeń.
+ */
+struct events {
+  FILE* out; ///<plik wyjściowy
+  bool binary; ///<czy zdarzenia są zapisywane binarnie
+  uint64_t seq; ///<numer ostatniego zdarzenia
+  bool failed; ///<czy któryś zapis się nie powiódł
+};
+
+/** @brief Zgłasza błąd strumienia zdarzeń.
+ * Wypisuje na standardowe wyjście diagnostyczne komunikat
+ * @p "EVENTS ERROR", odróżnialny od komunikatów o błędnych wierszach.
+ */
+static void report(void) {
+  fprintf(stderr, "EVENTS ERROR\n");
+}
+
+/** @brief Otwiera plik wyjściowy strumienia.
+ * Wartość postaci @p "&n" oznacza otwarty już deskryptor @p n, przy czym
+ * @p n musi być większe od @p 2, bo standardowe wyjścia są zajęte przez
+ * odpowiedzi i komunikaty o błędach. Każda inna wartość poza @p "-" jest
+ * nazwą pliku.
+ * @param[in] path    – wartość zmiennej środowiskowej @p GAMMA_EVENTS,
+ * @param[in] binary  – czy zdarzenia są zapisywane binarnie.
+ * @return Wskaźnik na otwarty plik lub @p NULL, jeśli wartość jest
+ * niepoprawna lub nie udało się otworzyć pliku.
+ */
+static FILE* open_output(const char* path, bool binary) {
+  if (strcmp(path, "-") == 0) return NULL;
+  if (path[0] != '&') return fopen(path, binary == true ? "wb" : "w");
+
+  char* end;
+  errno = 0;
+  long fd = strtol(path + 1, &end, 10);
+  if (path[1] < '0' || path[1] > '9' || *end != '\0' || errno != 0
+      || fd <= 2 || fd > INT32_MAX)
+    return NULL;
+  return fdopen((int)fd, binary == true ? "wb" : "w");
+}
+
+/** @brief Sprawdza, czy plansza jest pusta.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli żaden gracz nie ma pionka na planszy,
+ * a @p false w przeciwnym przypadku.
+ */
+static bool empty(gamma_t* g) {
+  for (uint32_t p = 1; p <= get_players(g); p++) {
+    if (gamma_busy_fields(g, p) > 0) return false;
+  }
+  return true;
+}
+
+events_t* events_start(gamma_t* g) {
+  const char* path = getenv("GAMMA_EVENTS");
+  if (path == NULL || strcmp(path, "") == 0 || g == NULL) return NULL;
+
+  events_t* e = malloc(sizeof(events_t));
+  if (e == NULL) return NULL;
+  const char* format = getenv("GAMMA_EVENTS_FORMAT");
+  (*e).binary = format != NULL && strcmp(format, "binary") == 0;
+  (*e).seq = 0;
+  (*e).failed = false;
+  (*e).out = open_output(path, (*e).binary);
+  if ((*e).out == NULL) {
+    report();
+    free(e);
+    return NULL;
+  }
+
+  if ((*e).binary == true) {
+    struct events_header h = {0};
+    memcpy(h.magic, EVENTS_MAGIC, sizeof(h.magic));
+    h.width = get_width(g);
+    h.height = get_height(g);
+    h.players = get_players(g);
+    if (fwrite(&h, sizeof(h), 1, (*e).out) != 1) (*e).failed = true;
+  }
+  else if (fprintf((*e).out, "EVENTS %" PRIu32 " %" PRIu32 " %" PRIu32
+                   "\n", get_width(g), get_height(g), get_players(g)) < 0) {
+    (*e).failed = true;
+  }
+
+  if (empty(g) == false) {
+    for (uint32_t y = 0; y < get_height(g); y++) {
+      for (uint32_t x = 0; x < get_width(g); x++) {
+        uint32_t player = player_on_position(g, x, y);
+        if (player != 0) events_move(e, player, x, y, 0);
+      }
+    }
+  }
+  return e;
+}
+
+uint32_t events_before(events_t* e, gamma_t* g, uint32_t x, uint32_t y) {
+  if (e == NULL || x >= get_width(g) || y >= get_height(g)) return 0;
+  return player_on_position(g, x, y);
+}
+
+void events_move(events_t* e, uint32_t player, uint32_t x, uint32_t y,
+                 uint32_t previous) {
+  if (e == NULL || (*e).failed == true) return;
+  (*e).seq++;
+  if ((*e).binary == true) {
+    struct events_record r = {(*e).seq, x, y, player, previous};
+    if (fwrite(&r, sizeof(r), 1, (*e).out) != 1) (*e).failed = true;
+  }
+  else if (fprintf((*e).out, "%" PRIu64 " %" PRIu32 " %" PRIu32 " %" PRIu32
+                   " %" PRIu32 "\n", (*e).seq, x, y, player, previous) < 0) {
+    (*e).failed = true;
+  }
+}
+
+void events_finish(events_t* e) {
+  if (e == NULL) return;
+  if (fflush((*e).out) != 0 || ferror((*e).out) != 0) (*e).failed = true;
+  if (fclose((*e).out) != 0) (*e).failed = true;
+  if ((*e).failed == true) report();
+  free(e);
+}
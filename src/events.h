@@ -0,0 +1,110 @@
+/** @file
+ * Interfejs modułu wypisującego strumień zdarzeń trybu wsadowego.
+ * Strumień jest włączany zmienną środowiskową @p GAMMA_EVENTS, której
+ * wartością jest nazwa pliku lub napis @p "&n" oznaczający otwarty już
+ * deskryptor @p n większy od @p 2. Strumień nigdy nie trafia na standardowe
+ * wyjście diagnostyczne, żeby nie mieszać zdarzeń z komunikatami o błędnych
+ * wierszach. Strumień pozwala odtwarzać planszę przyrostowo, bez pobierania
+ * jej całej poleceniem @p p po każdym ruchu.
+ *
+ * Jeśli nie udało się otworzyć pliku lub zapisać któregoś zdarzenia,
+ * na standardowe wyjście diagnostyczne jest wypisywany jeden komunikat
+ * @p "EVENTS ERROR", a kolejne zdarzenia są pomijane.
+ *
+ * Strumień zaczyna się nagłówkiem z wymiarami planszy i liczbą graczy, po
+ * którym następuje po jednym zdarzeniu na każde zmienione pole: numer
+ * kolejny zdarzenia liczony od @p 1, współrzędne pola, nowy i poprzedni numer
+ * gracza na polu. Jeśli zmienna środowiskowa @p GAMMA_EVENTS_FORMAT ma
+ * wartość @p "binary", nagłówek jest strukturą @ref events_header,
+ * a zdarzenia strukturami @ref events_record, zapisanymi w kolejności bajtów
+ * komputera. W przeciwnym przypadku nagłówek jest wierszem
+ * @p "EVENTS width height players", a zdarzenie wierszem
+ * @p "seq x y player previous".
+ *
+ * Jeśli w chwili rozpoczęcia plansza nie jest pusta, na przykład po
+ * wznowieniu z punktu kontrolnego, za nagłówkiem następują zdarzenia
+ * opisujące wszystkie zajęte pola z poprzednim numerem gracza @p 0.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "gamma.h"
+
+/**
+ * Typ przechowujący ustawienia i stan strumienia zdarzeń.
+ */
+typedef struct events events_t;
+
+/**
+ * Nagłówek binarnego strumienia zdarzeń.
+ */
+struct events_header {
+  char magic[8]; ///<napis @p "GAMMAEVT"
+  uint32_t width; ///<szerokość planszy
+  uint32_t height; ///<wysokość planszy
+  uint32_t players; ///<liczba graczy
+  uint32_t unused; ///<zero
+};
+
+/**
+ * Zdarzenie binarnego strumienia zdarzeń.
+ */
+struct events_record {
+  uint64_t seq; ///<numer kolejny zdarzenia
+  uint32_t x; ///<numer kolumny pola
+  uint32_t y; ///<numer wiersza pola
+  uint32_t player; ///<nowy numer gracza na polu
+  uint32_t previous; ///<poprzedni numer gracza na polu lub @p 0
+};
+
+/** @brief Rozpoczyna strumień zdarzeń.
+ * Jeśli zmienna środowiskowa @p GAMMA_EVENTS ma niepustą wartość, otwiera
+ * plik wyjściowy i wypisuje nagłówek oraz zajęte pola planszy gry @p g.
+ * Jeśli wartość jest niepoprawna lub pliku nie udało się otworzyć, wypisuje
+ * komunikat @p "EVENTS ERROR".
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, gdy strumień jest
+ * wyłączony lub nie udało się otworzyć pliku albo zaalokować pamięci.
+ */
+events_t* events_start(gamma_t* g);
+
+/** @brief Podaje numer gracza na polu przed ruchem.
+ * Wywoływana przed złotym ruchem, żeby zdarzenie zawierało poprzedni numer
+ * gracza na polu.
+ * @param[in] e       – wskaźnik na strukturę przechowującą stan strumienia
+ *                      lub @p NULL,
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Numer gracza na polu (@p x, @p y) lub @p 0, jeśli pole jest wolne,
+ * nie należy do planszy lub @p e ma wartość @p NULL.
+ */
+uint32_t events_before(events_t* e, gamma_t* g, uint32_t x, uint32_t y);
+
+/** @brief Wypisuje zdarzenie.
+ * Wywoływana po każdym udanym ruchu. Nic nie robi, jeśli wskaźnik @p e ma
+ * wartość @p NULL.
+ * @param[in, out] e  – wskaźnik na strukturę przechowującą stan strumienia,
+ * @param[in] player  – nowy numer gracza na polu,
+ * @param[in] x       – numer kolumny pola,
+ * @param[in] y       – numer wiersza pola,
+ * @param[in] previous – poprzedni numer gracza na polu lub @p 0.
+ */
+void events_move(events_t* e, uint32_t player, uint32_t x, uint32_t y,
+                 uint32_t previous);
+
+/** @brief Kończy strumień zdarzeń.
+ * Zapisuje zbuforowane zdarzenia, zamyka plik wyjściowy i usuwa strukturę
+ * wskazywaną przez @p e. Jeśli któryś zapis się nie powiódł, wypisuje
+ * komunikat @p "EVENTS ERROR". Nic nie robi, jeśli wskaźnik @p e ma wartość
+ * @p NULL.
+ * @param[in] e       – wskaźnik na strukturę przechowującą stan strumienia.
+ */
+void events_finish(events_t* e);
+
+#endif /* EVENTS_H */
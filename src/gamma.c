@@ -6,21 +6,87 @@
  * @date 17.04.2020
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "gamma.h"
+#include "random.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <assert.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Liczba bitów indeksu pola wyznaczających jego pozycję w kafelku.
+ */
+#define TILE_BITS 8
+
+/**
+ * Liczba pól w jednym kafelku planszy.
+ */
+#define TILE_CELLS ((uint64_t)1 << TILE_BITS)
+
+/**
+ * Największa liczba graczy, których pola są liczone w jednym kafelku.
+ */
+#define TILE_OWNERS 16
+
+/**
+ * Liczba funkcji interfejsu, dla których zbierane są statystyki.
+ */
+#define API_COUNT (gamma_api_legal_golden_moves + 1)
+
+#ifdef GAMMA_STATS
+/**
+ * Zaznacza wywołanie funkcji interfejsu @p api; praca wykonana do następnego
+ * wywołania jest przypisywana tej funkcji.
+ */
+#define STATS_CALL(g, api) \
+  ((*(g)).current = (api), (*(g)).stats[(api)].calls++)
+/**
+ * Zwiększa o @p n licznik @p counter bieżącej funkcji interfejsu.
+ */
+#define STATS_ADD(g, counter, n) \
+  ((*(g)).stats[(*(g)).current].counter += (n))
+#else
+/**
+ * Bez makra @p GAMMA_STATS statystyki nie są zbierane.
+ */
+#define STATS_CALL(g, api) ((void)0)
+/**
+ * Bez makra @p GAMMA_STATS statystyki nie są zbierane.
+ */
+#define STATS_ADD(g, counter, n) ((void)0)
+#endif
 
 /**
- * Struktura przechowująca stan pola.
+ * Struktura przechowująca liczniki jednej funkcji interfejsu, patrz
+ * @ref gamma_counter.
+ */
+struct counters {
+  uint64_t calls; ///<liczba wywołań
+  uint64_t cells_visited; ///<liczba pól odwiedzonych w obszarach
+  uint64_t find_hops; ///<liczba kroków w górę drzew obszarów
+  uint64_t trial_moves; ///<liczba próbnych złotych ruchów
+};
+
+/** @brief Struktura przechowująca stan pola.
+ * Ruch czyta głównie numery graczy na sąsiednich polach, więc rozmiary
+ * obszaru leżą osobno, patrz @ref region, a pole zajmuje 16 bajtów.
  */
 struct field {
-  struct field* rep; ///<adres reprezentanta
+  uint64_t rep; ///<indeks reprezentanta
   uint32_t player; ///<numer gracza
   bool visited; ///<informacja, czy zostało przetworzone przez funkcję @ref dfs
 };
@@ -30,14 +96,407 @@ struct field {
  */
 typedef struct field field_t;
 
+/**
+ * Struktura przechowująca rozmiary obszaru, ważne tylko dla reprezentanta.
+ */
+struct region {
+  uint64_t size; ///<liczba pól obszaru
+  uint64_t boundary; ///<liczba par sąsiednich pól obszaru i wolnych
+};
+
+/** @brief Struktura przechowująca kafelek planszy.
+ * Plansza jest podzielona na prostokątne kafelki po @ref TILE_CELLS pól,
+ * patrz @ref layout. Kafelek liczy też pola co najwyżej @ref TILE_OWNERS
+ * graczy (pola spoza planszy są liczone jako wolne). Gracz zaczyna być
+ * liczony tylko wtedy, gdy wszystkie pola kafelka są policzone, więc jego
+ * liczba pól jest zawsze dokładna. Kafelek może leżeć w tablicach kafelków
+ * kilku kopii gry utworzonych funkcją @ref gamma_clone; jest kopiowany
+ * dopiero przy pierwszym zapisie.
+ */
+struct tile {
+  atomic_uint_fast32_t refs; ///<liczba tablic kafelków zawierających kafelek
+  uint32_t owners_count; ///<liczba liczonych graczy
+  uint32_t owners[TILE_OWNERS]; 
+  ///<numery liczonych graczy (@p 0 dla wolnych pól)
+  uint16_t counts[TILE_OWNERS]; ///<liczby pól kolejnych graczy z @p owners
+  uint16_t uncounted; ///<liczba pól graczy, którzy nie są liczeni
+  uint64_t taken[TILE_CELLS / 64]; 
+  ///<bitmapa pól, które były zajęte od inicjacji kafelka
+  field_t cells[TILE_CELLS]; ///<pola kafelka
+  struct region regions[TILE_CELLS]; 
+  ///<rozmiary obszarów, których reprezentantami są kolejne pola kafelka
+};
+
+/** @brief Struktura opisująca podział planszy na kafelki.
+ * Kafelek ma 2^@p width_bits kolumn i 2^@p height_bits wierszy, przy czym
+ * @p width_bits + @p height_bits = @ref TILE_BITS. Kafelki są numerowane
+ * wierszami, a pola wewnątrz kafelka w kolejności Mortona (bity kolumny
+ * i wiersza na przemian), więc sąsiednie pola leżą zwykle blisko siebie
+ * w pamięci niezależnie od kierunku.
+ */
+struct layout {
+  uint32_t width_bits; ///<logarytm szerokości kafelka
+  uint32_t height_bits; ///<logarytm wysokości kafelka
+  uint64_t tiles_in_row; ///<liczba kafelków w wierszu kafelków
+  uint64_t* column_code; 
+  ///<części indeksów pól wyznaczone przez numer kolumny, dla każdej kolumny
+  uint64_t* row_code; 
+  ///<części indeksów pól wyznaczone przez numer wiersza, dla każdego wiersza
+  uint8_t column_of[TILE_CELLS]; 
+  ///<numer kolumny w kafelku pola o danym indeksie w kafelku
+  uint8_t row_of[TILE_CELLS]; 
+  ///<numer wiersza w kafelku pola o danym indeksie w kafelku
+  uint32_t column_mask; ///<bity pozycji w kafelku wyznaczane przez kolumnę
+  uint32_t row_mask; ///<bity pozycji w kafelku wyznaczane przez wiersz
+};
+
+/** @brief Struktura opisująca sąsiadów pola.
+ * Sąsiedzi są zapisani w kolejności: lewy, prawy, dolny, górny, z pominięciem
+ * tych spoza planszy. Ruch zmienia tylko swoje pole, więc sąsiedzi wyznaczeni
+ * na jego początku pozostają aktualni do końca ruchu.
+ */
+struct around {
+  uint64_t centre; ///<indeks pola
+  uint64_t id[4]; ///<indeksy sąsiadów
+  uint32_t x[4]; ///<numery kolumn sąsiadów
+  uint32_t y[4]; ///<numery wierszy sąsiadów
+  uint32_t player[4]; ///<numery graczy na polach sąsiadów
+  uint32_t count; ///<liczba sąsiadów
+};
+
+/** @brief Struktura opisująca blok kafelków.
+ * Kafelki nowej planszy leżą w jednym bloku: w pamięci zaalokowanej razem
+ * z tą strukturą albo, dla planszy utworzonej funkcją @ref gamma_new_file,
+ * we współdzielonym odwzorowaniu pliku. Kafelki planszy wczytanej funkcją
+ * @ref gamma_load leżą w prywatnym odwzorowaniu pliku, więc zapis kopiuje
+ * tylko zmienianą stronę, a plik się nie zmienia.
+ * Kafelki z bloku nigdy nie są zwalniane pojedynczo, a blok jest usuwany
+ * razem z ostatnią korzystającą z niego grą. Kopie kafelków tworzone przy
+ * zapisie są alokowane osobno. Kopia gry korzysta z bloku oryginału, więc
+ * dopóki z bloku korzysta więcej niż jedna gra, kafelki mogą być
+ * współdzielone.
+ */
+struct block {
+  atomic_uint_fast32_t refs; ///<liczba gier korzystających z bloku
+  void* address; ///<początek kafelków
+  size_t length; ///<długość kafelków w bajtach
+  bool file; ///<informacja, czy kafelki są odwzorowane z pliku
+};
+
+/** @brief Struktura przechowująca tablicę kafelków planszy.
+ * Kopia gry utworzona funkcją @ref gamma_clone korzysta z tablicy oryginału,
+ * więc jej utworzenie nie zależy od liczby kafelków. Gra, która zmienia
+ * planszę, najpierw tworzy własną tablicę, patrz @ref own_tiles; kafelki
+ * pozostają wtedy współdzielone.
+ */
+struct directory {
+  atomic_uint_fast32_t refs; ///<liczba gier korzystających z tablicy
+  struct tile* tiles[]; ///<kafelki planszy
+};
+
+/**
+ * Struktura przechowująca liczbę obszarów gracza o danym rozmiarze.
+ */
+struct size_count {
+  uint64_t size; ///<liczba pól obszarów
+  uint32_t player; ///<numer gracza lub @p 0 dla wolnego miejsca
+  uint32_t count; ///<liczba obszarów
+};
+
+/** @brief Struktura przechowująca rozmiary obszarów graczy.
+ * Tablica z haszowaniem otwartym zliczająca obszary każdego gracza według
+ * rozmiaru. Dzięki niej po złotym ruchu, który podzielił największy obszar
+ * gracza, wystarczy sprawdzić mniejsze rozmiary, zamiast przeglądać
+ * planszę, patrz @ref add_size. Miejsca z zerową liczbą obszarów są usuwane
+ * dopiero przy powiększaniu tablicy, a to odbywa się tylko przed ruchem,
+ * patrz @ref sizes_reserve, więc cofnięcie zmian ruchu nie alokuje pamięci.
+ * Kopia gry utworzona funkcją @ref gamma_clone korzysta z tablicy oryginału,
+ * dopóki któraś z gier jej nie zmieni.
+ */
+struct sizes {
+  atomic_uint_fast32_t refs; ///<liczba gier korzystających z tablicy
+  uint64_t capacity; ///<liczba miejsc, potęga dwójki
+  uint64_t used; ///<liczba zajętych miejsc
+  struct size_count slots[]; ///<miejsca tablicy
+};
+
+/**
+ * Najwięcej tylu nowych rozmiarów obszarów może pojawić się w jednym ruchu.
+ */
+#define SIZE_KEYS 16
+
+/**
+ * Początkowa liczba miejsc tablicy rozmiarów obszarów; przy niej pierwsze
+ * ruchy nie wymagają powiększania tablicy.
+ */
+#define SIZE_SLOTS (4 * SIZE_KEYS)
+
+/**
+ * Najwięcej tylu zmian liczb obszarów o danym rozmiarze zostaje po jednym
+ * zwykłym ruchu, gdy zmiany przeciwnego znaku się znoszą, patrz @ref log_size.
+ */
+#define SIZE_CHANGES 6
+
+/**
+ * Struktura przechowująca zmianę liczby obszarów gracza o danym rozmiarze.
+ */
+struct size_change {
+  uint64_t size; ///<liczba pól obszarów
+  uint32_t player; ///<numer gracza lub @p 0 dla pustego wpisu
+  int32_t delta; ///<zmiana liczby obszarów, @p 1 lub @p -1
+};
+
+/**
+ * Przesunięcie kafelków względem początku bloku zaalokowanego w pamięci.
+ */
+#define BLOCK_OFFSET ((sizeof(struct block) + 63) / 64 * 64)
+
+/** @brief Struktura opisująca rozmiary tablic gry.
+ * Tablice gry leżą w jednym bloku pamięci zaraz za strukturą przechowującą
+ * stan gry, patrz @ref gamma_reset.
+ */
+struct capacity {
+  uint32_t players; ///<największa liczba graczy
+  uint64_t codes; ///<największa suma szerokości i wysokości planszy
+  uint64_t tiles; ///<największa liczba kafelków
+};
+
+/** @brief Rodzaj zmiany stanu gry.
+ * Typ wyliczeniowy określający, którą składową stanu gry zmienia wpis
+ * w dzienniku ruchów.
+ */
+enum change_kind {
+  changed_player,     ///<numer gracza na polu
+  changed_rep,        ///<reprezentant pola
+  changed_areas,      ///<liczba obszarów gracza
+  changed_fields,     ///<liczba pól gracza
+  changed_neighbours, ///<liczba wolnych sąsiadów gracza
+  changed_free,       ///<liczba wolnych pól na planszy
+  changed_golden,     ///<informacja o wykonaniu złotego ruchu
+  changed_size,       ///<liczba pól obszaru o danym reprezentancie
+  changed_boundary,   ///<liczba wolnych sąsiadów obszaru o danym reprezentancie
+  changed_largest,    ///<rozmiar największego obszaru gracza
+  changed_count       ///<liczba obszarów gracza o danym rozmiarze
+};
+
+/**
+ * Struktura przechowująca pojedynczą zmianę stanu gry.
+ */
+struct change {
+  enum change_kind kind; ///<rodzaj zmiany
+  uint64_t cell; 
+  ///<indeks zmienionego pola (dla zmian pola) lub rozmiar obszarów (dla
+  ///<zmiany @ref changed_count)
+  uint32_t player; ///<numer gracza (dla zmian liczników)
+  uint64_t old_value; ///<wartość przed zmianą
+  uint64_t new_value; ///<wartość po zmianie
+};
+
+/**
+ * Struktura przechowująca dziennik ruchów.
+ */
+struct journal {
+  struct change* changes; ///<tablica zapisanych zmian
+  uint64_t changes_count; ///<liczba zapisanych zmian
+  uint64_t changes_size; ///<rozmiar tablicy zmian
+  
+  uint64_t* moves; 
+  ///<tablica indeksów pierwszych zmian kolejnych ruchów w tablicy zmian
+  uint64_t moves_count; ///<liczba zapisanych ruchów (razem z cofniętymi)
+  uint64_t moves_size; ///<rozmiar tablicy ruchów
+  uint64_t done; ///<liczba zapisanych ruchów, które nie zostały cofnięte
+  
+  bool enabled; ///<informacja, czy dziennik jest włączony
+  bool trial; ///<informacja, czy trwa próbny ruch
+  bool failed; 
+  ///<informacja, czy w trakcie ruchu nie udało się wprowadzić zmiany
+};
+
+/**
+ * Najmniejsza liczba ruchów między klatkami kluczowymi historii ruchów.
+ */
+#define KEYFRAME_MOVES 1024
+
+/**
+ * Na tyle pól planszy przypada co najmniej jeden ruch między klatkami
+ * kluczowymi historii, więc zapisanie klatki kosztuje średnio stałą liczbę
+ * odczytów pól na ruch.
+ */
+#define KEYFRAME_CELLS 64
+
+/**
+ * Struktura przechowująca ciąg bajtów o zmiennej długości.
+ */
+struct bytes {
+  uint8_t* data; ///<tablica bajtów
+  uint64_t length; ///<liczba zapisanych bajtów
+  uint64_t size; ///<rozmiar tablicy
+};
+
+/** @brief Struktura przechowująca klatkę kluczową historii ruchów.
+ * Klatka opisuje planszę długościami serii pól tego samego gracza,
+ * w kolejności wierszy od wiersza @p 0, jako pary liczb: numer gracza
+ * (@p 0 dla wolnych pól) i długość serii. Za planszą leżą numery graczy,
+ * którzy wykonali już złoty ruch, jako różnice kolejnych numerów, zakończone
+ * zerem.
+ */
+struct keyframe {
+  uint64_t move; ///<liczba ruchów historii wykonanych przed klatką
+  uint64_t offset; ///<położenie w zapisie ruchów pierwszego ruchu po klatce
+  struct bytes data; ///<plansza i złote ruchy w postaci opisanej wyżej
+};
+
+/** @brief Struktura przechowująca historię ruchów.
+ * Udane ruchy są zapisywane jako liczby o zmiennej długości, po 7 bitów
+ * w bajcie: numer gracza razem z informacją, czy ruch był złoty, i różnice
+ * współrzędnych względem poprzedniego ruchu, przy czym pierwszy ruch po
+ * klatce kluczowej jest liczony względem pola (0, 0). Pierwsza klatka opisuje
+ * stan gry z chwili włączenia historii, patrz @ref gamma_history.
+ */
+struct history {
+  bool enabled; ///<informacja, czy historia jest włączona
+  struct bytes log; ///<zapis ruchów
+  uint64_t moves; ///<liczba zapisanych ruchów
+  uint32_t last_x; ///<numer kolumny ostatniego ruchu
+  uint32_t last_y; ///<numer wiersza ostatniego ruchu
+  struct keyframe* keyframes; ///<tablica klatek kluczowych
+  uint64_t keyframes_count; ///<liczba klatek kluczowych
+  uint64_t keyframes_size; ///<rozmiar tablicy klatek kluczowych
+};
+
+/**
+ * Największa liczba poziomów zbioru graczy, wystarczająca dla 2^32 graczy.
+ */
+#define ROSTER_LEVELS 6
+
+/** @brief Struktura przechowująca zbiór graczy, którzy mogą wykonać ruch.
+ * Zbiór jest drzewem bitmap: bit @p i poziomu @p 0 odpowiada graczowi
+ * o numerze @p i, a bit @p i wyższego poziomu jest ustawiony, gdy słowo @p i
+ * poziomu niższego jest niezerowe. Najwyższy poziom ma jedno słowo, więc
+ * dodanie i usunięcie gracza oraz znalezienie następnego kosztuje tyle kroków,
+ * ile jest poziomów. Gracza spoza zbioru nie ma potrzeby sprawdzać, patrz
+ * @ref may_move.
+ */
+struct roster {
+  uint64_t* words; ///<słowa kolejnych poziomów, od najniższego, lub @p NULL
+  uint64_t offset[ROSTER_LEVELS + 1];
+  ///<indeksy pierwszych słów kolejnych poziomów i liczba wszystkich słów
+  uint32_t levels; ///<liczba poziomów
+  uint32_t count; ///<liczba graczy w zbiorze
+};
+
+/** @brief Struktura przechowująca bitmapy pól.
+ * Bit numer @p i bitmapy (bit @p i % 64 słowa @p i / 64) odpowiada polu
+ * o numerze @p i w kolejności wierszy, patrz @ref position. Bitmapy są
+ * tworzone dopiero przy pierwszym użyciu, a potem aktualizowane przy każdej
+ * zmianie pola.
+ */
+struct bitboards {
+  uint64_t** of_player; 
+  ///<tablica bitmap pól kolejnych graczy (pod indeksem 0 bitmapa wolnych pól)
+  uint64_t* first_column; ///<bitmapa pól w pierwszej kolumnie planszy
+  uint64_t* last_column; ///<bitmapa pól w ostatniej kolumnie planszy
+};
+
+/** @brief Struktura synchronizująca odczyty z innych wątków.
+ * Licznik @p sequence jest nieparzysty, gdy trwa zmiana stanu gry, i rośnie
+ * o dwa z każdą zmianą, więc czytający stan gry powtarza odczyt, dopóki
+ * licznik przed odczytem i po nim nie jest tą samą liczbą parzystą (tak
+ * zwany seqlock). Każdy wiersz planszy ma znacznik, ustawiany na nową,
+ * większą wartość po każdej zmianie numeru gracza na polu w tym wierszu, więc
+ * przy powtórzonym odczycie planszy wystarczy ponownie przejrzeć wiersze
+ * o zmienionych znacznikach, patrz @ref gamma_concurrent.
+ */
+struct seqlock {
+  bool enabled; ///<informacja, czy odczyty z innych wątków są dozwolone
+  uint32_t depth; ///<liczba rozpoczętych i niezakończonych zmian stanu gry
+  atomic_uint_fast64_t sequence; ///<licznik zmian stanu gry
+  atomic_uint_fast64_t* row_stamps; ///<tablica znaczników wierszy planszy
+  uint64_t stamp; ///<ostatnio nadany znacznik wiersza
+};
+
+/** @brief Odczytuje daną czytaną przez inne wątki.
+ * Numery graczy na polach, wskaźniki na kafelki, liczniki graczy i liczbę
+ * wolnych pól inne wątki czytają pod ochroną licznika zmian, patrz
+ * @ref seqlock. Takie dane są zapisywane i odczytywane atomowo, bez
+ * wymuszania kolejności (kolejność zapewniają bariery licznika zmian), więc
+ * odczyt w trakcie zmiany nie jest wyścigiem, a jego wynik odrzuca funkcja
+ * @ref read_retry. Wątek, który jest właścicielem gry, może czytać te dane
+ * zwyczajnie. Pola nie mają typów atomowych, bo każda zmiana licznika byłaby
+ * wtedy kosztowną operacją atomową.
+ * @param[in] x       – dana.
+ */
+#define SHARED_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+/** @brief Zapisuje daną czytaną przez inne wątki.
+ * Patrz @ref SHARED_LOAD.
+ * @param[out] x      – dana,
+ * @param[in] v       – nowa wartość.
+ */
+#define SHARED_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+/**
+ * Liczba prób odczytu licznika zmian, po których czytający oddaje procesor.
+ */
+#define READ_SPINS 64
+
+/** @brief Struktura przechowująca wątki pomocnicze.
+ * Wątki czekają na kolejne fale ruchów funkcji @ref gamma_moves i pobierają
+ * ruchy z fali, dopóki się nie skończą. Każdy wątek wykonuje ruchy na własnym
+ * widoku gry, patrz @ref speculate.
+ */
+struct crew {
+  uint32_t count; ///<liczba wątków pomocniczych
+  pthread_t* threads; ///<tablica wątków pomocniczych
+  struct helper* helpers; ///<tablica opisów wątków pomocniczych
+  pthread_mutex_t lock; ///<blokada chroniąca pola poniżej
+  pthread_cond_t start; ///<sygnał rozpoczęcia fali lub zakończenia pracy
+  pthread_cond_t done; ///<sygnał zakończenia fali przez wszystkie wątki
+  uint64_t generation; ///<numer ostatnio rozpoczętej fali
+  uint32_t running; ///<liczba wątków pomocniczych wykonujących falę
+  bool finish; ///<informacja, czy wątki mają się zakończyć
+  
+  gamma_t* views; 
+  ///<tablica widoków gry; widok @p 0 należy do wątku wywołującego
+  const struct gamma_move_args* moves; ///<tablica wykonywanych ruchów
+  const uint64_t* order; ///<tablica numerów ruchów uporządkowanych falami
+  bool* results; ///<tablica wyników ruchów
+  struct size_change* size_log;
+  ///<tablica po @ref SIZE_CHANGES zmian rozmiarów obszarów kolejnych ruchów
+  uint64_t end; ///<indeks w @p order za ostatnim ruchem fali
+  atomic_uint_fast64_t next; ///<indeks w @p order następnego ruchu fali
+  
+  uint64_t* parent;
+  ///<tablica ojców kafelków w drzewach klas, patrz @ref speculate
+  uint64_t* last; ///<tablica numerów ostatnich fal klas kafelków
+  uint64_t classes;
+  ///<rozmiar tablic @p parent i @p last; poza funkcją @ref speculate każdy
+  ///<kafelek jest sam swoją klasą z falą @p 0
+};
+
+/**
+ * Struktura opisująca wątek pomocniczy.
+ */
+struct helper {
+  struct crew* crew; ///<wskaźnik na strukturę przechowującą wątki
+  uint32_t id; ///<numer widoku gry wątku
+};
+
 /**
  * Struktura przechowująca stan gry.
  */
 struct gamma {
-  field_t** tab; ///<tablica pól planszy
-  uint32_t width; ///<szerokość planszy
-  uint32_t height; ///<wysokość planszy
-  uint32_t players; ///<numba graczy
+  struct gamma_info info;
+  ///<wymiary planszy i liczba graczy, pierwsze pole, patrz @ref gamma_info
+  struct tile** tiles; ///<kafelki planszy z tablicy @p directory
+  uint64_t tiles_count; ///<liczba kafelków planszy
+  struct layout layout; ///<podział planszy na kafelki
+  struct block* block; ///<blok kafelków planszy
+  struct directory* directory; ///<tablica kafelków planszy
+  bool exclusive; 
+  ///<informacja, że plansza należy tylko do tej gry, patrz @ref exclusive
+  uint64_t* dirty; 
+  ///<bitmapa kafelków bloku, które mogą się różnić od kafelków pustej planszy
   uint32_t areas; ///<maksymalna liczba obszarów jednego gracza
   
   uint32_t* areas_of_player; 
@@ -50,524 +509,4203 @@ struct gamma {
   uint64_t* neighbours_of_player; 
   ///<tablica przechowująca liczbę wolnych pól sąsiadujących z polami danego gracze
   uint64_t free_fields; ///<aktualna liczba wolnych pól na planszy
+  uint64_t* largest_region; ///<tablica rozmiarów największych obszarów graczy
+  struct sizes* sizes; ///<rozmiary obszarów graczy
+  struct size_change* size_log;
+  ///<miejsce na zmiany rozmiarów obszarów bieżącego ruchu, jeśli gra jest
+  ///<widokiem funkcji @ref speculate, lub @p NULL
+  uint64_t hash; ///<skrót stanu gry, patrz @ref gamma_hash
+  struct bitboards boards; ///<bitmapy pól, patrz @ref gamma_legal_moves
   
-  uint32_t width_of_field; 
-  ///<szerokość jednego pola w tekstowej reprezentacji planszy
+  struct journal journal; ///<dziennik ruchów
+  struct history history; ///<historia ruchów, patrz @ref gamma_history
+  struct roster roster; ///<gracze, patrz @ref gamma_next_player
+  uint64_t* stuck; 
+  ///<dla każdego gracza numer stanu @p epoch, w którym nie miał złotego
+  ///<ruchu przy maksymalnej liczbie obszarów, lub @p 0
+  uint64_t epoch; 
+  ///<dodatni numer stanu gry, zwiększany, gdy złoty ruch mógł stać się
+  ///<możliwy
+  struct capacity capacity; ///<rozmiary tablic gry
+  struct seqlock seqlock; ///<synchronizacja odczytów z innych wątków
+  struct crew* crew; ///<wątki pomocnicze funkcji @ref gamma_moves lub @p NULL
+#ifdef GAMMA_STATS
+  struct counters stats[API_COUNT]; ///<statystyki, patrz @ref gamma_counter
+  enum gamma_api current; ///<ostatnio wywołana funkcja interfejsu
+#endif
 };
 
-void gamma_delete(gamma_t *g) {
-  if (g != NULL) {
-    for (uint32_t i = 0; i < (*g).height; i++) {
-      free((*g).tab[i]);
-    }
-    free((*g).tab);
-    
-    free((*g).areas_of_player);
-    free((*g).fields_of_player);
-    free((*g).golden_move);
-    free((*g).neighbours_of_player);
-    
-    free(g);
+// Funkcje z pliku gamma.h odczytują parametry gry spod adresu gry.
+_Static_assert(offsetof(struct gamma, info) == 0,
+               "pole info musi być pierwszym polem struktury gamma");
+
+/** @brief Podaje indeks pola.
+ * Bity indeksu powyżej @ref TILE_BITS są numerem kafelka, a pozostałe
+ * pozycją pola w kafelku, patrz @ref layout. Indeks jest sumą części
+ * wyznaczonych osobno przez kolumnę i wiersz, zapamiętanych w tablicach.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Indeks pola (@p x, @p y).
+ */
+static uint64_t cell_id(gamma_t* g, uint32_t x, uint32_t y) {
+  return (*g).layout.column_code[x] + (*g).layout.row_code[y];
+}
+
+/** @brief Podaje numer pola w kolejności wierszy.
+ * Odwraca funkcję @ref cell_id; pola numerowane wierszami, od wiersza @p 0,
+ * odpowiadają bitom bitmap pól.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola leżącego na planszy.
+ * @return Liczba @p y * @p width + @p x dla pola (@p x, @p y) o indeksie
+ * @p id.
+ */
+static uint64_t position(gamma_t* g, uint64_t id) {
+  struct layout* l = &((*g).layout);
+  uint64_t tile = id >> TILE_BITS;
+  uint64_t x = ((tile % (*l).tiles_in_row) << (*l).width_bits)
+               | (*l).column_of[id & (TILE_CELLS - 1)];
+  uint64_t y = ((tile / (*l).tiles_in_row) << (*l).height_bits)
+               | (*l).row_of[id & (TILE_CELLS - 1)];
+  return y * (uint64_t)(*g).info.width + x;
+}
+
+/** @brief Podaje pole do odczytu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola.
+ * @return Wskaźnik na pole o indeksie @p id. Przez ten wskaźnik nie wolno
+ * zmieniać pola.
+ */
+static field_t* cell(gamma_t* g, uint64_t id) {
+  return &((*(*g).tiles[id >> TILE_BITS]).cells[id & (TILE_CELLS - 1)]);
+}
+
+/** @brief Podaje rozmiary obszaru do odczytu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks reprezentanta obszaru.
+ * @return Wskaźnik na rozmiary obszaru. Przez ten wskaźnik nie wolno ich
+ * zmieniać.
+ */
+static struct region* region(gamma_t* g, uint64_t id) {
+  return &((*(*g).tiles[id >> TILE_BITS]).regions[id & (TILE_CELLS - 1)]);
+}
+
+/** @brief Podaje pole (@p x, @p y) do odczytu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wskaźnik na pole (@p x, @p y). Przez ten wskaźnik nie wolno
+ * zmieniać pola.
+ */
+static field_t* at(gamma_t* g, uint32_t x, uint32_t y) {
+  return cell(g, cell_id(g, x, y));
+}
+
+/** @brief Podaje numer gracza na polu (@p x, @p y).
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Numer gracza lub @p 0, jeśli pole jest wolne.
+ */
+static uint32_t owner(gamma_t* g, uint32_t x, uint32_t y) {
+  return (*at(g, x, y)).player;
+}
+
+/** @brief Dopisuje sąsiada pola.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] a  – wskaźnik na opis sąsiadów,
+ * @param[in] id      – indeks sąsiada,
+ * @param[in] x       – numer kolumny sąsiada,
+ * @param[in] y       – numer wiersza sąsiada.
+ */
+static void add_around(gamma_t* g, struct around* a, uint64_t id,
+                       uint32_t x, uint32_t y) {
+  uint32_t i = (*a).count++;
+  (*a).id[i] = id;
+  (*a).x[i] = x;
+  (*a).y[i] = y;
+  (*a).player[i] = (*cell(g, id)).player;
+}
+
+/** @brief Wyznacza sąsiadów pola.
+ * Indeks sąsiada z tego samego kafelka różni się od indeksu pola tylko bitami
+ * kolumny albo tylko bitami wiersza, więc wystarczy je zwiększyć lub
+ * zmniejszyć, nie sięgając do tablic z @ref layout. Pełne przeliczenie
+ * indeksu jest potrzebne tylko na brzegu kafelka.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new,
+ * @param[in] id      – indeks pola (@p x, @p y),
+ * @param[out] a      – wskaźnik na opis sąsiadów.
+ */
+static void gather(gamma_t* g, uint32_t x, uint32_t y, uint64_t id,
+                   struct around* a) {
+  uint64_t cm = (*g).layout.column_mask, rm = (*g).layout.row_mask;
+  uint64_t column = id & cm, row = id & rm, base = id & ~(cm | rm);
+  (*a).centre = id;
+  (*a).count = 0;
+  // Bity drugiej współrzędnej są przy zmniejszaniu zerami, a przy zwiększaniu
+  // jedynkami, więc pożyczka lub przeniesienie przechodzi przez nie dalej.
+  if (x > 0) {
+    add_around(g, a, column != 0 ? base | ((column - 1) & cm) | row 
+                                 : cell_id(g, x - 1, y), x - 1, y);
+  }
+  if (x < (*g).info.width - 1) {
+    add_around(g, a, column != cm ? base | (((column | ~cm) + 1) & cm) | row 
+                                  : cell_id(g, x + 1, y), x + 1, y);
+  }
+  if (y > 0) {
+    add_around(g, a, row != 0 ? base | column | ((row - 1) & rm) 
+                              : cell_id(g, x, y - 1), x, y - 1);
+  }
+  if (y < (*g).info.height - 1) {
+    add_around(g, a, row != rm ? base | column | (((row | ~rm) + 1) & rm) 
+                               : cell_id(g, x, y + 1), x, y + 1);
   }
 }
 
-/** @brief Liczy ilu znaków potrzeba do wypisania liczby.
- * Liczy ilu znaków potrzeba do wypisania liczby @p x w tekstowym opisie planszy.
- * @param[in] x       – liczba nieujemna.
- * @return Liczba znaków potrzebnych do wypisania liczby.
+/** @brief Sprawdza, czy wśród sąsiadów jest pole gracza.
+ * @param[in] a       – wskaźnik na opis sąsiadów,
+ * @param[in] player  – numer gracza lub @p 0 dla wolnego pola.
+ * @return Wartość @p true, jeśli któryś sąsiad należy do gracza @p player,
+ * @p false w przeciwnym wypadku.
  */
-static uint64_t number_of_characters(uint32_t x) {
-	if (x == 0) return 1;
-  
-	uint64_t num = 0;
-	while (x > 0) {
-		num++;
-		x /= 10;
-	}
-	return num;
+static bool adjacent(const struct around* a, uint32_t player) {
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    if ((*a).player[i] == player) return true;
+  }
+  return false;
 }
 
-gamma_t* gamma_new(uint32_t width, uint32_t height,
-                   uint32_t players, uint32_t areas) {
-  
-  if (width <= 0 || height <= 0 || players <= 0 || areas <= 0) return NULL;
- 
-  gamma_t* new = (gamma_t*)malloc(sizeof(gamma_t));
-  if (new == NULL) return NULL;
- 
-  (*new).tab = (field_t**) malloc(sizeof(field_t*) * height);
-  if ((*new).tab == NULL) {
-    free(new);
-    return NULL;
+/** @brief Liczy wolnych sąsiadów.
+ * @param[in] a       – wskaźnik na opis sąsiadów.
+ * @return Liczba wolnych pól wśród sąsiadów.
+ */
+static uint64_t free_count(const struct around* a) {
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    if ((*a).player[i] == 0) count++;
   }
-  
-  for (uint32_t i = 0; i < height; i++) {
-    (*new).tab[i] = (field_t*) malloc(sizeof(field_t) * width);
-    
-    if ((*new).tab[i] == NULL) {
-      for (uint32_t j = 0; j < i; j ++) {
-        free((*new).tab[j]);
-      }
-      free((*new).tab);
-      free(new);
-      return NULL;
+  return count;
+}
+
+/** @brief Podaje klucz pola zajętego przez gracza.
+ * Klucz składnika skrótu stanu gry odpowiadający temu, że pole o indeksie
+ * @p id jest zajęte przez gracza @p player.
+ * @param[in] id      – indeks pola,
+ * @param[in] player  – numer gracza lub @p 0 dla wolnego pola.
+ * @return Klucz pola; dla wolnego pola @p 0.
+ */
+static uint64_t field_key(uint64_t id, uint32_t player) {
+  if (player == 0) return 0;
+  return mix(mix(id) ^ (uint64_t)player);
+}
+
+/** @brief Podaje klucz wykonanego złotego ruchu.
+ * Klucz składnika skrótu stanu gry odpowiadający temu, że gracz @p player
+ * wykonał już złoty ruch.
+ * @param[in] player  – numer gracza.
+ * @return Klucz złotego ruchu gracza.
+ */
+static uint64_t golden_key(uint32_t player) {
+  return mix(~(uint64_t)player);
+}
+
+/** @brief Podaje liczbę słów bitmapy pól.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba 64-bitowych słów potrzebnych na bitmapę wszystkich pól.
+ */
+static uint64_t words_count(gamma_t* g) {
+  return ((uint64_t)(*g).info.width * (uint64_t)(*g).info.height + 63) >> 6;
+}
+
+/** @brief Aktualizuje bitmapy pól.
+ * Przenosi pole o numerze @p id z bitmapy gracza @p old_player do bitmapy
+ * gracza @p new_player, o ile bitmapy te zostały już utworzone.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – numer pola w kolejności wierszy,
+ * @param[in] old_player – poprzedni numer gracza na polu,
+ * @param[in] new_player – nowy numer gracza na polu.
+ */
+static void boards_update(gamma_t* g, uint64_t id, 
+                          uint32_t old_player, uint32_t new_player) {
+  uint64_t** b = (*g).boards.of_player;
+  if (b == NULL) return;
+  uint64_t bit = (uint64_t)1 << (id & 63);
+  if (b[old_player] != NULL) b[old_player][id >> 6] &= ~bit;
+  if (b[new_player] != NULL) b[new_player][id >> 6] |= bit;
+}
+
+/** @brief Zwalnia bitmapy pól.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void boards_free(gamma_t* g) {
+  if ((*g).boards.of_player != NULL) {
+    for (uint32_t i = 0; i <= (*g).info.players; i++) {
+      free((*g).boards.of_player[i]);
     }
   }
-  
-  for (uint32_t i = 0; i < height; i++) {
-    for (uint32_t j = 0; j < width; j++) {
-      ((*new).tab[i][j]).player = 0;
-      ((*new).tab[i][j]).rep = &((*new).tab[i][j]);
-      ((*new).tab[i][j]).visited = false;
-    }
+  free((*g).boards.of_player);
+  free((*g).boards.first_column);
+  free((*g).boards.last_column);
+  (*g).boards = (struct bitboards){0};
+}
+
+/** @brief Zwalnia kafelek.
+ * Zmniejsza licznik gier korzystających z kafelka i usuwa go z pamięci,
+ * jeśli nie korzysta z niego już żadna gra.
+ * @param[in] t       – wskaźnik na kafelek.
+ */
+static void tile_release(struct tile* t) {
+  if (atomic_fetch_sub(&((*t).refs), 1) == 1) free(t);
+}
+
+/** @brief Sprawdza, czy kafelek leży w bloku kafelków gry.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] t       – wskaźnik na kafelek planszy gry.
+ * @return Wartość @p true, jeśli tak, @p false w przeciwnym wypadku.
+ */
+static bool in_block(gamma_t* g, struct tile* t) {
+  struct block* m = (*g).block;
+  if (m == NULL) return false;
+  uintptr_t begin = (uintptr_t)(*m).address;
+  return (uintptr_t)t >= begin && (uintptr_t)t < begin + (*m).length;
+}
+
+/** @brief Zwalnia kafelek gry.
+ * Kafelki z bloku kafelków nie są zwalniane, zmniejszany jest tylko ich
+ * licznik gier.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] t       – wskaźnik na kafelek planszy gry.
+ */
+static void tile_drop(gamma_t* g, struct tile* t) {
+  if (in_block(g, t) == false) tile_release(t);
+  else atomic_fetch_sub(&((*t).refs), 1);
+}
+
+/** @brief Tworzy tablicę kafelków.
+ * Miejsca na kafelki nie są inicjowane.
+ * @param[in] size    – liczba miejsc na kafelki.
+ * @return Wskaźnik na utworzoną tablicę lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static struct directory* directory_new(uint64_t size) {
+  struct directory* d = malloc(sizeof(struct directory) 
+                               + sizeof(struct tile*) * size);
+  if (d == NULL) return NULL;
+  atomic_init(&((*d).refs), 1);
+  return d;
+}
+
+/** @brief Usuwa tablicę kafelków.
+ * Zmniejsza licznik gier korzystających z tablicy, a jeśli nie korzysta z niej
+ * już żadna gra, zwalnia jej kafelki i ją usuwa. Nic nie robi, jeśli wskaźnik
+ * @p d ma wartość @p NULL.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry, która
+ *                      korzystała z tablicy,
+ * @param[in] d       – wskaźnik na tablicę kafelków.
+ */
+static void directory_release(gamma_t* g, struct directory* d) {
+  if (d == NULL || atomic_fetch_sub(&((*d).refs), 1) > 1) return;
+  for (uint64_t i = 0; i < (*g).tiles_count; i++) tile_drop(g, (*d).tiles[i]);
+  free(d);
+}
+
+/** @brief Tworzy własną tablicę kafelków gry.
+ * Wywoływana przed pierwszym zapisem planszy, gdy tablica kafelków jest
+ * współdzielona z kopią gry. Kafelki nowej tablicy są nadal współdzielone.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool own_tiles(gamma_t* g) {
+  struct directory* old = (*g).directory;
+  struct directory* d = directory_new((*g).capacity.tiles);
+  if (d == NULL) return false;
+  for (uint64_t i = 0; i < (*g).tiles_count; i++) {
+    (*d).tiles[i] = (*old).tiles[i];
+    atomic_fetch_add(&((*(*d).tiles[i]).refs), 1);
   }
+  (*g).directory = d;
+  // Czytający z innych wątków muszą widzieć zawartość nowej tablicy.
+  __atomic_store_n(&((*g).tiles), (*d).tiles, __ATOMIC_RELEASE);
+  directory_release(g, old);
+  return true;
+}
+
+/** @brief Podpowiada systemowi, jak plansza będzie czytana.
+ * Ma znaczenie tylko dla planszy odwzorowanej z pliku: przy przeglądaniu
+ * całej planszy w kolejności pamięci system może czytać strony z wyprzedzeniem
+ * i szybciej je zwalniać, a przy ruchach nie powinien czytać stron, które nie
+ * będą potrzebne.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] advice  – @p POSIX_MADV_SEQUENTIAL lub @p POSIX_MADV_RANDOM.
+ */
+static void advise(gamma_t* g, int advice) {
+  if ((*g).block != NULL && (*(*g).block).file == true) 
+    posix_madvise((*(*g).block).address, (*(*g).block).length, advice);
+}
+
+/** @brief Sprawdza, czy stan gry mogą odczytywać inne wątki.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli odczyty z innych wątków są dozwolone,
+ * @p false w przeciwnym wypadku.
+ */
+static bool concurrent(gamma_t* g) {
+  return (*g).seqlock.enabled == true;
+}
+
+/** @brief Rozpoczyna zmianę stanu gry.
+ * Jeśli odczyty z innych wątków są dozwolone, ustawia nieparzystą wartość
+ * licznika zmian. Zmiany mogą być zagnieżdżone; licznik zmienia tylko
+ * najbardziej zewnętrzna.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void write_begin(gamma_t* g) {
+  struct seqlock* l = &((*g).seqlock);
+  if ((*l).enabled == false || (*l).depth++ > 0) return;
+  uint64_t s = atomic_load_explicit(&((*l).sequence), memory_order_relaxed);
+  atomic_store_explicit(&((*l).sequence), s + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+}
+
+/** @brief Kończy zmianę stanu gry.
+ * Odwraca funkcję @ref write_begin, ustawiając parzystą wartość licznika
+ * zmian po zakończeniu najbardziej zewnętrznej zmiany.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void write_end(gamma_t* g) {
+  struct seqlock* l = &((*g).seqlock);
+  if ((*l).enabled == false || --(*l).depth > 0) return;
+  uint64_t s = atomic_load_explicit(&((*l).sequence), memory_order_relaxed);
+  atomic_store_explicit(&((*l).sequence), s + 1, memory_order_release);
+}
+
+/** @brief Rozpoczyna odczyt stanu gry z innego wątku.
+ * Czeka, aż nie będzie trwała żadna zmiana stanu gry.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Parzysta wartość licznika zmian.
+ */
+static uint64_t read_begin(gamma_t* g) {
+  for (uint32_t spins = 0;; spins++) {
+    uint64_t s = atomic_load_explicit(&((*g).seqlock.sequence), 
+                                      memory_order_acquire);
+    if (s % 2 == 0) return s;
+    // Zmiana trwa krótko, chyba że wątek zmieniający stan gry stracił
+    // procesor; wtedy nie ma sensu go zajmować.
+    if (spins >= READ_SPINS) sched_yield();
+  }
+}
+
+/** @brief Sprawdza, czy odczyt stanu gry trzeba powtórzyć.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] s       – wartość licznika zmian z funkcji @ref read_begin.
+ * @return Wartość @p true, jeśli w trakcie odczytu stan gry się zmienił,
+ * @p false w przeciwnym wypadku.
+ */
+static bool read_retry(gamma_t* g, uint64_t s) {
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(&((*g).seqlock.sequence), memory_order_relaxed)
+         != s;
+}
+
+/** @brief Zaznacza zmianę wiersza planszy.
+ * Nadaje wierszowi zawierającemu pole o indeksie @p id nowy znacznik, jeśli
+ * odczyty z innych wątków są dozwolone.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks zmienionego pola.
+ */
+static void touch_row(gamma_t* g, uint64_t id) {
+  if (concurrent(g) == false) return;
+  struct layout* l = &((*g).layout);
+  uint64_t t = id >> TILE_BITS;
+  uint64_t y = ((t / (*l).tiles_in_row) << (*l).height_bits)
+               + (*l).row_of[id & (TILE_CELLS - 1)];
+  atomic_store_explicit(&((*g).seqlock.row_stamps[y]), ++(*g).seqlock.stamp,
+                        memory_order_release);
+}
+
+/** @brief Sprawdza, czy plansza należy tylko do tej gry.
+ * Tablicę kafelków, kafelki i rozmiary obszarów mogą współdzielić tylko kopie
+ * gry, a każda kopia korzysta z bloku kafelków oryginału. Jeśli więc z bloku
+ * korzysta tylko ta gra, to nic nie jest współdzielone. Wynik jest zapamiętywany w grze, a funkcja
+ * @ref gamma_clone go kasuje, więc dopóki gra nie zostanie skopiowana,
+ * zapisy nie odczytują liczników atomowych.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli plansza należy tylko do tej gry,
+ * @p false, jeśli może być współdzielona.
+ */
+static bool exclusive(gamma_t* g) {
+  if ((*g).exclusive == false && atomic_load(&((*(*g).block).refs)) == 1)
+    (*g).exclusive = true;
+  return (*g).exclusive;
+}
+
+/** @brief Podaje kafelek do zapisu.
+ * Jeśli tablica kafelków lub kafelek zawierający pole są współdzielone
+ * z inną grą, najpierw tworzy ich prywatne kopie.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola.
+ * @return Wskaźnik na kafelek zawierający pole o indeksie @p id lub @p NULL,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static struct tile* writable_tile(gamma_t* g, uint64_t id) {
+  if (exclusive(g) == true) return (*g).tiles[id >> TILE_BITS];
+  if (atomic_load(&((*(*g).directory).refs)) > 1 && own_tiles(g) == false) 
+    return NULL;
+  struct tile** t = &((*g).tiles[id >> TILE_BITS]);
+  
+  if (atomic_load(&((**t).refs)) > 1) { // Kafelek jest współdzielony.
+    struct tile* copy = malloc(sizeof(struct tile));
+    if (copy == NULL) return NULL;
+    memcpy(copy, *t, sizeof(struct tile));
+    atomic_init(&((*copy).refs), 1);
+    tile_drop(g, *t);
+    // Czytający z innych wątków muszą widzieć zawartość kopii.
+    __atomic_store_n(t, copy, __ATOMIC_RELEASE);
+  }
+  return *t;
+}
+
+/** @brief Podaje pole do zapisu.
+ * Patrz @ref writable_tile.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola.
+ * @return Wskaźnik na pole o indeksie @p id lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static field_t* writable(gamma_t* g, uint64_t id) {
+  struct tile* t = writable_tile(g, id);
+  return t != NULL ? &((*t).cells[id & (TILE_CELLS - 1)]) : NULL;
+}
+
+/** @brief Podaje rozmiary obszaru do zapisu.
+ * Patrz @ref writable_tile.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks reprezentanta obszaru.
+ * @return Wskaźnik na rozmiary obszaru lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static struct region* writable_region(gamma_t* g, uint64_t id) {
+  struct tile* t = writable_tile(g, id);
+  return t != NULL ? &((*t).regions[id & (TILE_CELLS - 1)]) : NULL;
+}
+
+/** @brief Sprawdza, czy każda zmiana stanu gry musi zostać zapisana.
+ * Zmiany muszą być zapisywane w czasie próbnego ruchu oraz wtedy, gdy plansza
+ * może być współdzielona z kopią gry lub z plikiem, bo zapis pola może się
+ * wtedy nie udać i ruch trzeba wycofać. Plansza może być współdzielona
+ * z kopią gry, dopóki z bloku kafelków korzysta więcej niż jedna gra.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli zmiany muszą być zapisywane,
+ * @p false w przeciwnym wypadku.
+ */
+static bool strict(gamma_t* g) {
+  return (*g).journal.trial == true || exclusive(g) == false;
+}
+
+/** @brief Sprawdza, czy zmiany stanu gry są zapisywane.
+ * Zmiany są zapisywane, jeśli dziennik jest włączony lub muszą być zapisywane.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli zmiany są zapisywane,
+ * @p false w przeciwnym wypadku.
+ */
+static bool recording(gamma_t* g) {
+  return (*g).journal.enabled == true || strict(g) == true;
+}
+
+/** @brief Czyści dziennik ruchów.
+ * Usuwa wszystkie zapisane zmiany i ruchy, nie zwalniając pamięci.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void journal_clear(gamma_t* g) {
+  (*g).journal.changes_count = 0;
+  (*g).journal.moves_count = 0;
+  (*g).journal.done = 0;
+}
+
+/** @brief Zapewnia miejsce na zmiany.
+ * Powiększa w razie potrzeby tablicę zmian tak, by zmieściło się w niej
+ * jeszcze @p n zmian.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] n       – liczba zmian, liczba nieujemna.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool journal_reserve(gamma_t* g, uint64_t n) {
+  struct journal* j = &((*g).journal);
+  if ((*j).changes_count + n <= (*j).changes_size) return true;
+  
+  uint64_t size = 2 * (*j).changes_size + 16;
+  if (size < (*j).changes_count + n) size = (*j).changes_count + n;
+  
+  struct change* temp = realloc((*j).changes, sizeof(struct change) * size);
+  if (temp == NULL) return false;
+  (*j).changes = temp;
+  (*j).changes_size = size;
+  return true;
+}
+
+/** @brief Zapisuje zmianę stanu gry.
+ * Dopisuje zmianę na koniec dziennika, jeśli zmiany są zapisywane.
+ * Jeśli nie uda się zaalokować pamięci, a zmiany nie muszą być zapisywane,
+ * wyłącza dziennik i usuwa jego zawartość.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] kind    – rodzaj zmiany,
+ * @param[in] cell    – indeks zmienionego pola,
+ * @param[in] player  – numer gracza, którego licznik się zmienia,
+ * @param[in] old_value – wartość przed zmianą,
+ * @param[in] new_value – wartość po zmianie.
+ * @return Wartość @p false, jeśli zmiana musiała zostać zapisana, ale nie
+ * udało się zaalokować pamięci, @p true w przeciwnym wypadku.
+ */
+static bool record(gamma_t* g, enum change_kind kind, uint64_t cell,
+                   uint32_t player, uint64_t old_value, uint64_t new_value) {
+  if (recording(g) == false) return true;
+  if (journal_reserve(g, 1) == false) {
+    if (strict(g) == true) return false;
+    (*g).journal.enabled = false;
+    journal_clear(g);
+    return true;
+  }
+  struct change* c = &((*g).journal.changes[(*g).journal.changes_count]);
+  (*c).kind = kind;
+  (*c).cell = cell;
+  (*c).player = player;
+  (*c).old_value = old_value;
+  (*c).new_value = new_value;
+  (*g).journal.changes_count++;
+  return true;
+}
+
+/** @brief Zmienia liczbę pól gracza w kafelku.
+ * @param[in, out] t  – wskaźnik na kafelek, który nie jest współdzielony,
+ * @param[in] player  – numer gracza lub @p 0 dla wolnych pól,
+ * @param[in] delta   – @p 1 lub @p -1; liczba pól gracza w kafelku nie może
+ *                      stać się ujemna.
+ */
+static void tile_count(struct tile* t, uint32_t player, int delta) {
+  uint32_t i = 0;
+  while (i < (*t).owners_count && (*t).owners[i] != player) i++;
+  if (i == (*t).owners_count) {
+    if ((*t).uncounted > 0 || i == TILE_OWNERS) { // Gracz nie jest liczony.
+      (*t).uncounted = (uint16_t)((*t).uncounted + delta);
+      return;
+    }
+    // Wszystkie pola są policzone, więc gracz nie miał dotąd pól w kafelku.
+    (*t).owners[i] = player;
+    (*t).counts[i] = 0;
+    (*t).owners_count++;
+  }
+  (*t).counts[i] = (uint16_t)((*t).counts[i] + delta);
+  
+  if ((*t).counts[i] == 0) { // Na miejsce usuniętego gracza wstawiam ostatniego.
+    (*t).owners_count--;
+    (*t).owners[i] = (*t).owners[(*t).owners_count];
+    (*t).counts[i] = (*t).counts[(*t).owners_count];
+  }
+}
+
+/** @brief Zaznacza kafelek jako zmieniony.
+ * Pole, które nigdy nie było zajęte, nie zmienia się od inicjacji kafelka,
+ * więc kafelek bloku jest zaznaczany, gdy zajmowane jest jego pierwsze pole.
+ * Zaznaczenie nie jest cofane, nawet jeśli ruch zostanie wycofany.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] t       – numer kafelka.
+ */
+static void mark_dirty(gamma_t* g, uint64_t t) {
+  uint64_t bit = (uint64_t)1 << (t & 63);
+  if (((*g).dirty[t >> 6] & bit) == 0) (*g).dirty[t >> 6] |= bit;
+}
+
+/** @brief Ustawia numer gracza na polu.
+ * Aktualizuje skrót stanu gry, bitmapy pól i liczby pól graczy w kafelku.
+ * Nie zapisuje zmiany w dzienniku.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola,
+ * @param[in, out] f  – wskaźnik na pole o indeksie @p id do zapisu,
+ * @param[in] player  – nowy numer gracza na polu.
+ */
+static void put_player(gamma_t* g, uint64_t id, field_t* f, uint32_t player) {
+  if ((*f).player == player) return;
+  (*g).hash ^= field_key(id, (*f).player) ^ field_key(id, player);
+  if ((*g).boards.of_player != NULL) {
+    boards_update(g, position(g, id), (*f).player, player);
+  }
+  
+  struct tile* t = (*g).tiles[id >> TILE_BITS];
+  if ((*f).player == 0) {
+    uint64_t j = id & (TILE_CELLS - 1);
+    (*t).taken[j >> 6] |= (uint64_t)1 << (j & 63);
+    mark_dirty(g, id >> TILE_BITS);
+  }
+  tile_count(t, (*f).player, -1);
+  tile_count(t, player, 1);
+  SHARED_STORE((*f).player, player);
+  touch_row(g, id);
+}
+
+/** @brief Zmienia numer gracza na polu.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola,
+ * @param[in] player  – nowy numer gracza na polu.
+ */
+static void set_player(gamma_t* g, uint64_t id, uint32_t player) {
+  field_t* f = writable(g, id);
+  if (f == NULL || record(g, changed_player, id, 0, (*f).player, player) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  put_player(g, id, f, player);
+}
+
+/** @brief Zmienia reprezentanta pola.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola,
+ * @param[in] rep     – indeks nowego reprezentanta.
+ */
+static void set_rep(gamma_t* g, uint64_t id, uint64_t rep) {
+  if ((*cell(g, id)).rep == rep) return;
+  field_t* f = writable(g, id);
+  if (f == NULL || record(g, changed_rep, id, 0, (*f).rep, rep) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  (*f).rep = rep;
+}
+
+/** @brief Zmienia rozmiar obszaru.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks reprezentanta obszaru,
+ * @param[in] size    – nowa liczba pól obszaru.
+ */
+static void set_size(gamma_t* g, uint64_t id, uint64_t size) {
+  if ((*region(g, id)).size == size) return;
+  struct region* r = writable_region(g, id);
+  if (r == NULL || record(g, changed_size, id, 0, (*r).size, size) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  (*r).size = size;
+}
+
+/** @brief Zmienia liczbę wolnych sąsiadów obszaru.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks reprezentanta obszaru,
+ * @param[in] boundary – nowa liczba par sąsiednich pól obszaru i wolnych.
+ */
+static void set_boundary(gamma_t* g, uint64_t id, uint64_t boundary) {
+  if ((*region(g, id)).boundary == boundary) return;
+  struct region* r = writable_region(g, id);
+  if (r == NULL 
+      || record(g, changed_boundary, id, 0, (*r).boundary, boundary) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  (*r).boundary = boundary;
+}
+
+/** @brief Zmienia rozmiar największego obszaru gracza.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] size    – nowy rozmiar.
+ */
+static void set_largest(gamma_t* g, uint32_t player, uint64_t size) {
+  if ((*g).largest_region[player] == size) return;
+  if (record(g, changed_largest, 0, player, (*g).largest_region[player], size)
+      == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  (*g).largest_region[player] = size;
+}
+
+/** @brief Tworzy pustą tablicę rozmiarów obszarów.
+ * @param[in] capacity – liczba miejsc, potęga dwójki.
+ * @return Wskaźnik na utworzoną tablicę lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static struct sizes* sizes_new(uint64_t capacity) {
+  struct sizes* s = calloc(1, sizeof(struct sizes) 
+                              + sizeof(struct size_count) * capacity);
+  if (s == NULL) return NULL;
+  atomic_init(&((*s).refs), 1);
+  (*s).capacity = capacity;
+  return s;
+}
+
+/** @brief Zwalnia tablicę rozmiarów obszarów.
+ * Zmniejsza licznik gier korzystających z tablicy i usuwa ją, jeśli nie
+ * korzysta z niej już żadna gra. Nic nie robi, jeśli wskaźnik @p s ma
+ * wartość @p NULL.
+ * @param[in] s       – wskaźnik na tablicę rozmiarów obszarów.
+ */
+static void sizes_release(struct sizes* s) {
+  if (s != NULL && atomic_fetch_sub(&((*s).refs), 1) == 1) free(s);
+}
+
+/** @brief Szuka miejsca rozmiaru obszarów gracza.
+ * @param[in] s       – wskaźnik na tablicę rozmiarów obszarów,
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] size    – rozmiar obszarów.
+ * @return Miejsce pary (@p player, @p size) lub wolne miejsce, na które
+ * należy ją wstawić.
+ */
+static struct size_count* size_slot(struct sizes* s, uint32_t player, 
+                                    uint64_t size) {
+  uint64_t h = size * 0x9e3779b97f4a7c15ULL 
+               ^ (uint64_t)player * 0xc2b2ae3d27d4eb4fULL;
+  uint64_t mask = (*s).capacity - 1;
+  for (uint64_t i = (h ^ (h >> 32)) & mask;; i = (i + 1) & mask) {
+    struct size_count* e = &((*s).slots[i]);
+    if ((*e).player == 0 || ((*e).player == player && (*e).size == size)) 
+      return e;
+  }
+}
+
+/** @brief Podaje liczbę obszarów gracza o danym rozmiarze.
+ * @param[in] s       – wskaźnik na tablicę rozmiarów obszarów,
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] size    – rozmiar obszarów.
+ * @return Liczba obszarów gracza @p player o @p size polach.
+ */
+static uint32_t size_count(struct sizes* s, uint32_t player, uint64_t size) {
+  return (*size_slot(s, player, size)).count;
+}
+
+/** @brief Zapewnia miejsce na nowe rozmiary obszarów.
+ * Tworzy prywatną kopię tablicy rozmiarów obszarów, jeśli jest
+ * współdzielona z kopią gry, i powiększa ją, jeśli nie zmieściłoby się
+ * w niej @p n nowych par, usuwając przy tym pary z zerową liczbą obszarów.
+ * Wywoływana przed zmianami ruchu, więc ich cofnięcie znajdzie wszystkie
+ * zmieniane pary. Widok funkcji @ref speculate nie zmienia tablicy.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] n       – liczba nowych par.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool sizes_reserve(gamma_t* g, uint64_t n) {
+  struct sizes* s = (*g).sizes;
+  if ((*g).size_log != NULL) return true;
+  if ((exclusive(g) == true || atomic_load(&((*s).refs)) == 1) 
+      && 2 * ((*s).used + n) <= (*s).capacity) return true;
+  
+  uint64_t live = 0;
+  for (uint64_t i = 0; i < (*s).capacity; i++) 
+    if ((*s).slots[i].count > 0) live++;
+  uint64_t capacity = 16;
+  while (capacity < 4 * (live + n)) capacity *= 2;
+  struct sizes* t = sizes_new(capacity);
+  if (t == NULL) return false;
+  for (uint64_t i = 0; i < (*s).capacity; i++) {
+    struct size_count* e = &((*s).slots[i]);
+    if ((*e).count > 0) *size_slot(t, (*e).player, (*e).size) = *e;
+  }
+  (*t).used = live;
+  sizes_release(s);
+  (*g).sizes = t;
+  return true;
+}
+
+/** @brief Zapisuje zmianę rozmiarów obszarów ruchu widoku.
+ * Zmiany przeciwnego znaku tej samej pary się znoszą. Ruch tworzy obszar
+ * jednopolowy i dołącza do niego co najwyżej cztery obszary, a przy każdym
+ * połączeniu usuwany rozmiar poprzedniego połączonego obszaru znosi się
+ * z jego dodaniem, więc zostaje najwyżej @ref SIZE_CHANGES zmian.
+ * @param[in, out] g  – wskaźnik na widok gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] size    – rozmiar obszaru,
+ * @param[in] delta   – @p 1 lub @p -1.
+ */
+static void log_size(gamma_t* g, uint32_t player, uint64_t size, int delta) {
+  struct size_change* log = (*g).size_log;
+  for (int i = 0; i < SIZE_CHANGES; i++) {
+    if (log[i].player == player && log[i].size == size 
+        && log[i].delta == -delta) {
+      log[i].player = 0;
+      return;
+    }
+  }
+  int i = 0;
+  while (log[i].player != 0) i++;
+  log[i] = (struct size_change){size, player, delta};
+}
+
+/** @brief Zmienia liczbę obszarów gracza o danym rozmiarze.
+ * Aktualizuje rozmiar największego obszaru gracza. Gdy znika ostatni
+ * największy obszar, następnego szuka wśród mniejszych rozmiarów po kolei;
+ * tak dzieje się tylko po złotym ruchu, który wcześniej dodał rozmiary
+ * części dzielonego obszaru, więc sprawdzanych rozmiarów jest mniej niż pól
+ * przejrzanych przez ten ruch. W widoku funkcji @ref speculate tylko
+ * zapisuje zmianę.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] size    – rozmiar obszaru, liczba dodatnia,
+ * @param[in] delta   – @p 1 lub @p -1; liczba obszarów nie może stać się
+ *                      ujemna.
+ */
+static void add_size(gamma_t* g, uint32_t player, uint64_t size, int delta) {
+  if ((*g).size_log != NULL) {
+    log_size(g, player, size, delta);
+    if (delta > 0 && (*g).largest_region[player] < size) 
+      (*g).largest_region[player] = size;
+    return;
+  }
+  
+  struct size_count* e = size_slot((*g).sizes, player, size);
+  if ((*e).player == 0) { // Miejsce zapewniła funkcja sizes_reserve.
+    (*e).player = player;
+    (*e).size = size;
+    (*(*g).sizes).used++;
+  }
+  uint32_t count = (uint32_t)((int64_t)(*e).count + delta);
+  if (record(g, changed_count, size, player, (*e).count, count) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  (*e).count = count;
+  
+  if (delta > 0 && (*g).largest_region[player] < size) {
+    set_largest(g, player, size);
+  }
+  else if (count == 0 && (*g).largest_region[player] == size) {
+    uint64_t next = size - 1;
+    while (next > 0 && size_count((*g).sizes, player, next) == 0) next--;
+    set_largest(g, player, next);
+  }
+}
+
+/** @brief Rozmieszcza poziomy zbioru graczy.
+ * @param[out] r      – wskaźnik na zbiór graczy lub @p NULL,
+ * @param[in] bits    – liczba bitów najniższego poziomu, liczba dodatnia.
+ * @return Liczba słów wszystkich poziomów.
+ */
+static uint64_t roster_layout(struct roster* r, uint64_t bits) {
+  uint64_t total = 0;
+  uint32_t level = 0;
+  uint64_t words;
+  do {
+    words = (bits + 63) / 64;
+    if (r != NULL) (*r).offset[level] = total;
+    total += words;
+    bits = words;
+    level++;
+  } while (words > 1);
+  if (r != NULL) {
+    (*r).offset[level] = total;
+    (*r).levels = level;
+  }
+  return total;
+}
+
+/** @brief Dodaje gracza do zbioru lub go z niego usuwa.
+ * @param[in, out] r  – wskaźnik na zbiór graczy,
+ * @param[in] player  – numer gracza,
+ * @param[in] in      – informacja, czy gracz ma należeć do zbioru.
+ */
+static void roster_put(struct roster* r, uint64_t player, bool in) {
+  uint64_t* w = &((*r).words[player >> 6]);
+  uint64_t bit = (uint64_t)1 << (player & 63);
+  if (((*w & bit) != 0) == in) return;
+  if (in == true) (*r).count++;
+  else (*r).count--;
+  
+  for (uint32_t level = 1; ; level++) {
+    bool empty = *w == 0;
+    *w ^= bit;
+    // Wyższy poziom zmienia się tylko wtedy, gdy słowo staje się puste lub
+    // przestaje być puste.
+    if (empty == false && *w != 0) return;
+    if (level == (*r).levels) return;
+    player >>= 6;
+    w = &((*r).words[(*r).offset[level] + (player >> 6)]);
+    bit = (uint64_t)1 << (player & 63);
+  }
+}
+
+/** @brief Podaje następnego gracza ze zbioru.
+ * @param[in] r       – wskaźnik na zbiór graczy,
+ * @param[in] player  – numer gracza.
+ * @return Najmniejszy numer gracza ze zbioru większy od @p player lub @p 0,
+ * jeśli takiego nie ma.
+ */
+static uint64_t roster_next(struct roster* r, uint64_t player) {
+  // Idę w górę do poziomu, na którym za pozycją jest niezerowy bit.
+  uint64_t i = player + 1;
+  uint32_t level = 0;
+  while (1) {
+    if (level == (*r).levels) return 0;
+    uint64_t k = i >> 6;
+    if (k < (*r).offset[level + 1] - (*r).offset[level]) {
+      uint64_t w = (*r).words[(*r).offset[level] + k] 
+                   & (~(uint64_t)0 << (i & 63));
+      if (w != 0) {
+        i = (k << 6) + (uint64_t)__builtin_ctzll(w);
+        break;
+      }
+    }
+    i = k + 1;
+    level++;
+  }
+  
+  // Schodzę w dół, biorąc najmniejszy bit.
+  while (level-- > 0) {
+    uint64_t w = (*r).words[(*r).offset[level] + i];
+    i = (i << 6) + (uint64_t)__builtin_ctzll(w);
+  }
+  return i;
+}
+
+/** @brief Sprawdza, czy gracz może jeszcze wykonać ruch.
+ * Warunek jest konieczny, ale nie wystarczający: gracz, który go nie spełnia,
+ * nie ma wolnych pól ani złotego ruchu, ale nie każdy gracz, który go
+ * spełnia, może wykonać złoty ruch, patrz @ref gamma_golden_possible.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza.
+ * @return Wartość @p true, jeśli gracz ma wolne pola lub nie wykonał złotego
+ * ruchu, a @p false w przeciwnym przypadku.
+ */
+static bool may_move(gamma_t* g, uint32_t player) {
+  return ((*g).areas_of_player[player] < (*g).areas && (*g).free_fields > 0)
+         || (*g).neighbours_of_player[player] > 0
+         || (*g).golden_move[player] == false;
+}
+
+/** @brief Zapomina, że gracz nie ma złotego ruchu.
+ * Wywoływana, gdy zmienia się stan gracza lub obok jego pola pojawia się pole
+ * innego gracza. Nic nie robi w próbnym złotym ruchu, po którym stan gry
+ * wraca do poprzedniego, ani w widokach gry funkcji @ref gamma_moves.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza.
+ */
+static void unstick(gamma_t* g, uint32_t player) {
+  if ((*g).roster.words != NULL && (*g).journal.trial == false) 
+    (*g).stuck[player] = 0;
+}
+
+/** @brief Zapomina, że gracze nie mają złotego ruchu.
+ * Wywoływana, gdy złoty ruch na pole innego gracza mógł stać się legalny,
+ * bo zajęcie pola dzieli jego obszar na mniej części lub gracz ma mniej
+ * obszarów: gdy maleje liczba obszarów gracza, obszar zyskuje nową drogę
+ * między swoimi polami, ktoś wykonuje złoty ruch albo zmiany są cofane lub
+ * powtarzane. Nic nie robi w próbnym złotym ruchu.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void unstick_all(gamma_t* g) {
+  if ((*g).journal.trial == false) (*g).epoch++;
+}
+
+/** @brief Aktualizuje przynależność gracza do zbioru graczy.
+ * Wywoływana po każdej zmianie liczby obszarów, wolnych sąsiadów lub
+ * informacji o złotym ruchu gracza. Widoki gry funkcji @ref gamma_moves nie
+ * mają zbioru graczy.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza.
+ */
+static void roster_update(gamma_t* g, uint32_t player) {
+  if ((*g).roster.words == NULL || player == 0) return;
+  unstick(g, player);
+  roster_put(&((*g).roster), player, may_move(g, player));
+}
+
+/** @brief Tworzy zbiór graczy od nowa.
+ * Wywoływana po zmianach stanu gry dotyczących wszystkich graczy, także gdy
+ * na planszy skończyły się wolne pola lub się pojawiły.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void roster_rebuild(gamma_t* g) {
+  struct roster* r = &((*g).roster);
+  if ((*r).words == NULL) return;
+  memset((*r).words, 0, sizeof(uint64_t) * (*r).offset[(*r).levels]);
+  (*r).count = 0;
+  for (uint32_t p = 1; p <= (*g).info.players; p++) roster_update(g, p);
+}
+
+/** @brief Zmienia liczbę obszarów gracza.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] delta   – wartość, o jaką zmienia się liczba obszarów.
+ */
+static void add_areas(gamma_t* g, uint32_t player, int64_t delta) {
+  uint32_t value = (*g).areas_of_player[player] + (uint32_t)delta;
+  if (record(g, changed_areas, 0, player, (*g).areas_of_player[player], value)
+      == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  SHARED_STORE((*g).areas_of_player[player], value);
+  roster_update(g, player);
+  if (delta < 0) unstick_all(g);
+}
+
+/** @brief Zmienia liczbę pól gracza.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] delta   – wartość, o jaką zmienia się liczba pól.
+ */
+static void add_fields(gamma_t* g, uint32_t player, int64_t delta) {
+  uint64_t value = (*g).fields_of_player[player] + (uint64_t)delta;
+  if (record(g, changed_fields, 0, player, (*g).fields_of_player[player], value)
+      == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  SHARED_STORE((*g).fields_of_player[player], value);
+}
+
+/** @brief Zmienia liczbę wolnych sąsiadów gracza.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] delta   – wartość, o jaką zmienia się liczba wolnych sąsiadów.
+ */
+static void add_neighbours(gamma_t* g, uint32_t player, int64_t delta) {
+  if (delta == 0) return;
+  uint64_t value = (*g).neighbours_of_player[player] + (uint64_t)delta;
+  if (record(g, changed_neighbours, 0, player,
+             (*g).neighbours_of_player[player], value) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  SHARED_STORE((*g).neighbours_of_player[player], value);
+  roster_update(g, player);
+}
+
+/** @brief Zmienia liczbę wolnych pól na planszy.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] delta   – wartość, o jaką zmienia się liczba wolnych pól.
+ */
+static void add_free(gamma_t* g, int64_t delta) {
+  uint64_t value = (*g).free_fields + (uint64_t)delta;
+  if (record(g, changed_free, 0, 0, (*g).free_fields, value) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  bool full = (*g).free_fields == 0;
+  SHARED_STORE((*g).free_fields, value);
+  if (full != (value == 0)) roster_rebuild(g);
+}
+
+/** @brief Zmienia informację o wykonaniu złotego ruchu.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] b       – nowa wartość informacji.
+ */
+static void set_golden(gamma_t* g, uint32_t player, bool b) {
+  if (record(g, changed_golden, 0, player, (*g).golden_move[player], b) == false) {
+    (*g).journal.failed = true;
+    return;
+  }
+  if ((*g).golden_move[player] != b) (*g).hash ^= golden_key(player);
+  (*g).golden_move[player] = b;
+  roster_update(g, player);
+}
+
+/** @brief Ustawia wartość ze zmiany.
+ * Ustawia składową stanu gry opisaną przez zmianę @p c na wartość @p value.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] c       – wskaźnik na zmianę,
+ * @param[in] value   – wartość do ustawienia.
+ */
+static void apply_change(gamma_t* g, struct change* c, uint64_t value) {
+  unstick_all(g);
+  switch ((*c).kind) {
+    case changed_player:
+      put_player(g, (*c).cell, writable(g, (*c).cell), (uint32_t)value);
+      break;
+    case changed_rep:
+      (*writable(g, (*c).cell)).rep = value;
+      break;
+    case changed_areas:
+      SHARED_STORE((*g).areas_of_player[(*c).player], (uint32_t)value);
+      roster_update(g, (*c).player);
+      break;
+    case changed_fields:
+      SHARED_STORE((*g).fields_of_player[(*c).player], value);
+      break;
+    case changed_neighbours:
+      SHARED_STORE((*g).neighbours_of_player[(*c).player], value);
+      roster_update(g, (*c).player);
+      break;
+    case changed_free: {
+      bool full = (*g).free_fields == 0;
+      SHARED_STORE((*g).free_fields, value);
+      if (full != (value == 0)) roster_rebuild(g);
+      break;
+    }
+    case changed_golden:
+      if ((*g).golden_move[(*c).player] != (bool)value) 
+        (*g).hash ^= golden_key((*c).player);
+      (*g).golden_move[(*c).player] = (bool)value;
+      roster_update(g, (*c).player);
+      break;
+    case changed_size:
+      (*writable_region(g, (*c).cell)).size = value;
+      break;
+    case changed_boundary:
+      (*writable_region(g, (*c).cell)).boundary = value;
+      break;
+    case changed_largest:
+      (*g).largest_region[(*c).player] = value;
+      break;
+    case changed_count:
+      (*size_slot((*g).sizes, (*c).player, (*c).cell)).count = (uint32_t)value;
+      break;
+  }
+}
+
+/** @brief Cofa zmiany.
+ * Cofa w odwrotnej kolejności zapisane zmiany o indeksach niemniejszych niż
+ * @p start i usuwa je z dziennika.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] start   – indeks pierwszej cofanej zmiany.
+ */
+static void rollback(gamma_t* g, uint64_t start) {
+  while ((*g).journal.changes_count > start) {
+    (*g).journal.changes_count--;
+    struct change* c = &((*g).journal.changes[(*g).journal.changes_count]);
+    apply_change(g, c, (*c).old_value);
+  }
+}
+
+/** @brief Rozpoczyna zapisywanie ruchu.
+ * Zmiany ruchu są dopisywane na koniec dziennika, za zmianami cofniętych
+ * ruchów, dzięki czemu nielegalny ruch nie usuwa możliwości ich powtórzenia.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Indeks pierwszej zmiany ruchu w dzienniku.
+ */
+static uint64_t begin_move(gamma_t* g) {
+  return (*g).journal.changes_count;
+}
+
+/** @brief Kończy zapisywanie wykonanego ruchu.
+ * Jeśli którejś zmiany ruchu nie udało się wprowadzić, cofa cały ruch.
+ * W przeciwnym razie, jeśli dziennik jest włączony, usuwa z niego cofnięte
+ * ruchy, których nie będzie można już powtórzyć, i zapisuje ruch, którego
+ * zmiany zaczynają się od indeksu @p start. Jeśli nie uda się zaalokować
+ * pamięci, wyłącza dziennik i usuwa jego zawartość.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] start   – indeks pierwszej zmiany ruchu w dzienniku.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false, jeśli
+ * został cofnięty.
+ */
+static bool end_move(gamma_t* g, uint64_t start) {
+  struct journal* j = &((*g).journal);
+  if ((*j).failed == true) { // Nie udało się skopiować kafelka.
+    rollback(g, start);
+    (*j).failed = false;
+    return false;
+  }
+  if ((*j).trial == true) return true;
+  if ((*j).enabled == false) { // Zmiany były potrzebne tylko w razie błędu.
+    (*j).changes_count = start;
+    return true;
+  }
+  
+  if ((*j).done < (*j).moves_count) { // Przesuwam zmiany na miejsce cofniętych.
+    uint64_t count = (*j).changes_count - start;
+    memmove(&((*j).changes[(*j).moves[(*j).done]]), &((*j).changes[start]),
+            sizeof(struct change) * count);
+    start = (*j).moves[(*j).done];
+    (*j).changes_count = start + count;
+    (*j).moves_count = (*j).done;
+  }
+  
+  if ((*j).moves_count == (*j).moves_size) {
+    uint64_t size = 2 * (*j).moves_size + 16;
+    uint64_t* temp = realloc((*j).moves, sizeof(uint64_t) * size);
+    if (temp == NULL) {
+      (*j).enabled = false;
+      journal_clear(g);
+      return true;
+    }
+    (*j).moves = temp;
+    (*j).moves_size = size;
+  }
+  (*j).moves[(*j).moves_count] = start;
+  (*j).moves_count++;
+  (*j).done = (*j).moves_count;
+  return true;
+}
+
+/** @brief Dopisuje liczbę do ciągu bajtów.
+ * Zapisuje liczbę po 7 bitów w bajcie, od najmłodszych; najstarszy bit
+ * bajtu mówi, czy liczba ma dalsze bajty.
+ * @param[in, out] b  – wskaźnik na ciąg bajtów,
+ * @param[in] value   – liczba.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool put_varint(struct bytes* b, uint64_t value) {
+  if ((*b).length + 10 > (*b).size) {
+    uint64_t size = 2 * (*b).size + 64;
+    uint8_t* temp = realloc((*b).data, size);
+    if (temp == NULL) return false;
+    (*b).data = temp;
+    (*b).size = size;
+  }
+  while (value >= 0x80) {
+    (*b).data[(*b).length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  (*b).data[(*b).length++] = (uint8_t)value;
+  return true;
+}
+
+/** @brief Odczytuje liczbę z ciągu bajtów.
+ * Odwraca funkcję @ref put_varint.
+ * @param[in] data    – tablica bajtów,
+ * @param[in, out] offset – wskaźnik na położenie liczby w tablicy; jest
+ *                      przesuwany za liczbę.
+ * @return Odczytana liczba.
+ */
+static uint64_t get_varint(const uint8_t* data, uint64_t* offset) {
+  uint64_t value = 0;
+  uint32_t shift = 0;
+  uint8_t byte;
+  do {
+    byte = data[(*offset)++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    shift += 7;
+  } while ((byte & 0x80) != 0);
+  return value;
+}
+
+/** @brief Koduje różnicę współrzędnych.
+ * Różnice nieujemne są zapisywane jako liczby parzyste, a ujemne jako
+ * nieparzyste, więc małe co do wartości bezwzględnej różnice zajmują jeden
+ * bajt.
+ * @param[in] from    – poprzednia współrzędna,
+ * @param[in] to      – nowa współrzędna.
+ * @return Zakodowana różnica.
+ */
+static uint64_t zigzag(uint32_t from, uint32_t to) {
+  if (to >= from) return (uint64_t)(to - from) << 1;
+  return ((uint64_t)(from - to) << 1) - 1;
+}
+
+/** @brief Dekoduje różnicę współrzędnych.
+ * Odwraca funkcję @ref zigzag.
+ * @param[in] from    – poprzednia współrzędna,
+ * @param[in] code    – zakodowana różnica.
+ * @return Nowa współrzędna.
+ */
+static uint32_t unzigzag(uint32_t from, uint64_t code) {
+  if ((code & 1) == 0) return from + (uint32_t)(code >> 1);
+  return from - (uint32_t)((code + 1) >> 1);
+}
+
+/** @brief Odczytuje ruch z historii.
+ * @param[in] data    – zapis ruchów,
+ * @param[in, out] offset – wskaźnik na położenie ruchu w zapisie; jest
+ *                      przesuwany za ruch,
+ * @param[out] player – wskaźnik na numer gracza,
+ * @param[in, out] x  – wskaźnik na numer kolumny poprzedniego ruchu; jest
+ *                      zmieniany na numer kolumny odczytanego ruchu,
+ * @param[in, out] y  – wskaźnik na numer wiersza poprzedniego ruchu; jest
+ *                      zmieniany na numer wiersza odczytanego ruchu.
+ * @return Wartość @p true, jeśli ruch był złoty, @p false w przeciwnym
+ * wypadku.
+ */
+static bool history_entry(const uint8_t* data, uint64_t* offset,
+                          uint32_t* player, uint32_t* x, uint32_t* y) {
+  uint64_t head = get_varint(data, offset);
+  *x = unzigzag(*x, get_varint(data, offset));
+  *y = unzigzag(*y, get_varint(data, offset));
+  *player = (uint32_t)(head >> 1);
+  return (head & 1) == 1;
+}
+
+/** @brief Usuwa historię ruchów.
+ * Zwalnia pamięć historii i ją wyłącza.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void history_free(gamma_t* g) {
+  struct history* h = &((*g).history);
+  for (uint64_t i = 0; i < (*h).keyframes_count; i++) 
+    free((*h).keyframes[i].data.data);
+  free((*h).keyframes);
+  free((*h).log.data);
+  *h = (struct history){0};
+}
+
+/** @brief Zapisuje klatkę kluczową historii.
+ * Opisuje bieżący stan gry, patrz @ref keyframe.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool keyframe_add(gamma_t* g) {
+  struct history* h = &((*g).history);
+  if ((*h).keyframes_count == (*h).keyframes_size) {
+    uint64_t size = 2 * (*h).keyframes_size + 4;
+    struct keyframe* temp = realloc((*h).keyframes, 
+                                    sizeof(struct keyframe) * size);
+    if (temp == NULL) return false;
+    (*h).keyframes = temp;
+    (*h).keyframes_size = size;
+  }
+  
+  struct bytes b = {0};
+  bool valid = true;
+  uint32_t player = owner(g, 0, 0);
+  uint64_t run = 0;
+  for (uint32_t y = 0; y < (*g).info.height; y++) {
+    for (uint32_t x = 0; x < (*g).info.width; x++) {
+      uint32_t p = owner(g, x, y);
+      if (p != player) {
+        valid = valid && put_varint(&b, player) && put_varint(&b, run);
+        player = p;
+        run = 0;
+      }
+      run++;
+    }
+  }
+  valid = valid && put_varint(&b, player) && put_varint(&b, run);
+  uint32_t previous = 0;
+  for (uint32_t p = 1; p <= (*g).info.players; p++) {
+    if ((*g).golden_move[p] == true) {
+      valid = valid && put_varint(&b, p - previous);
+      previous = p;
+    }
+  }
+  valid = valid && put_varint(&b, 0);
+  if (valid == false) {
+    free(b.data);
+    return false;
+  }
+  
+  uint8_t* fitted = realloc(b.data, b.length);
+  if (fitted != NULL) {
+    b.data = fitted;
+    b.size = b.length;
+  }
+  (*h).keyframes[(*h).keyframes_count++] = 
+    (struct keyframe){(*h).moves, (*h).log.length, b};
+  (*h).last_x = 0;
+  (*h).last_y = 0;
+  return true;
+}
+
+/** @brief Rozpoczyna historię ruchów.
+ * Usuwa dotychczasową historię i zapisuje klatkę kluczową bieżącego stanu
+ * gry. Jeśli nie uda się zaalokować pamięci, historia zostaje wyłączona.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli się udało, @p false w przeciwnym wypadku.
+ */
+static bool history_start(gamma_t* g) {
+  history_free(g);
+  (*g).history.enabled = true;
+  if (keyframe_add(g) == true) return true;
+  history_free(g);
+  return false;
+}
+
+/** @brief Dopisuje udany ruch do historii.
+ * Wywoływana po wykonaniu ruchu. Jeśli od ostatniej klatki kluczowej minęło
+ * dość ruchów, zapisuje nową. Jeśli nie uda się zaalokować pamięci, usuwa
+ * historię. Nic nie robi, jeśli historia jest wyłączona.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza,
+ * @param[in] gold    – informacja, czy ruch był złoty.
+ */
+static void history_add(gamma_t* g, uint32_t player, uint32_t x, uint32_t y,
+                        bool gold) {
+  struct history* h = &((*g).history);
+  if ((*h).enabled == false) return;
+  
+  bool valid = put_varint(&((*h).log), ((uint64_t)player << 1) | gold)
+               && put_varint(&((*h).log), zigzag((*h).last_x, x))
+               && put_varint(&((*h).log), zigzag((*h).last_y, y));
+  (*h).last_x = x;
+  (*h).last_y = y;
+  (*h).moves++;
+  
+  uint64_t interval = (uint64_t)(*g).info.width * (*g).info.height
+                      / KEYFRAME_CELLS;
+  if (interval < KEYFRAME_MOVES) interval = KEYFRAME_MOVES;
+  if (valid == true 
+      && (*h).moves - (*h).keyframes[(*h).keyframes_count - 1].move 
+         >= interval) valid = keyframe_add(g);
+  if (valid == false) history_free(g);
+}
+
+/** @brief Usuwa z historii ostatni ruch.
+ * Wywoływana po cofnięciu ruchu funkcją @ref gamma_undo. Jeśli historia nie
+ * zawiera żadnego ruchu, bo cofnięty ruch był wykonany przed jej włączeniem,
+ * rozpoczyna ją od nowa od bieżącego stanu gry. Nic nie robi, jeśli historia
+ * jest wyłączona.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void history_pop(gamma_t* g) {
+  struct history* h = &((*g).history);
+  if ((*h).enabled == false) return;
+  if ((*h).moves == 0) {
+    history_start(g);
+    return;
+  }
+  
+  struct keyframe* k = &((*h).keyframes[(*h).keyframes_count - 1]);
+  if ((*k).move == (*h).moves) { // Klatka opisuje stan sprzed cofnięcia.
+    free((*k).data.data);
+    (*h).keyframes_count--;
+    k--;
+  }
+  // Szukam początku ostatniego ruchu od poprzedniej klatki.
+  uint64_t offset = (*k).offset, last = offset;
+  uint32_t player, x = 0, y = 0, last_x = 0, last_y = 0;
+  while (offset < (*h).log.length) {
+    last = offset;
+    last_x = x;
+    last_y = y;
+    history_entry((*h).log.data, &offset, &player, &x, &y);
+  }
+  (*h).log.length = last;
+  (*h).last_x = last_x;
+  (*h).last_y = last_y;
+  (*h).moves--;
+}
+
+/** @brief Dopisuje do historii powtórzony ruch.
+ * Wywoływana po powtórzeniu ruchu funkcją @ref gamma_redo. Odczytuje ruch
+ * ze zmian w dzienniku: ostatnia zmiana numeru gracza na zajęte pole
+ * wskazuje pole i gracza, a zmiana informacji o złotym ruchu mówi, że ruch
+ * był złoty.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] start   – indeks pierwszej zmiany ruchu,
+ * @param[in] end     – indeks za ostatnią zmianą ruchu.
+ */
+static void history_redo(gamma_t* g, uint64_t start, uint64_t end) {
+  if ((*g).history.enabled == false) return;
+  uint64_t id = 0;
+  uint32_t player = 0;
+  bool gold = false;
+  for (uint64_t i = start; i < end; i++) {
+    struct change* c = &((*g).journal.changes[i]);
+    if ((*c).kind == changed_player && (*c).new_value != 0) {
+      id = (*c).cell;
+      player = (uint32_t)(*c).new_value;
+    }
+    if ((*c).kind == changed_golden && (*c).new_value != 0) gold = true;
+  }
+  uint64_t p = position(g, id);
+  history_add(g, player, (uint32_t)(p % (*g).info.width), 
+              (uint32_t)(p / (*g).info.width), gold);
+}
+
+/** @brief Usuwa blok kafelków.
+ * Zmniejsza licznik gier korzystających z bloku i usuwa go, jeśli nie
+ * korzysta z niego już żadna gra. Nic nie robi, jeśli wskaźnik @p b ma
+ * wartość @p NULL.
+ * @param[in] b       – wskaźnik na blok kafelków.
+ */
+static void block_release(struct block* b) {
+  if (b != NULL && atomic_fetch_sub(&((*b).refs), 1) == 1) {
+    if ((*b).file == true) munmap((*b).address, (*b).length);
+    free(b);
+  }
+}
+
+/** @brief Tworzy blok kafelków w pamięci.
+ * Alokuje opis bloku razem z miejscem na kafelki. Kafelki nie są inicjowane.
+ * @param[in] count   – liczba kafelków.
+ * @return Wskaźnik na utworzony blok lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static struct block* block_new(uint64_t count) {
+  struct block* b = malloc(BLOCK_OFFSET + sizeof(struct tile) * count);
+  if (b == NULL) return NULL;
+  atomic_init(&((*b).refs), 1);
+  (*b).address = (char*)b + BLOCK_OFFSET;
+  (*b).length = sizeof(struct tile) * count;
+  (*b).file = false;
+  return b;
+}
+
+/** @brief Zwalnia kafelki planszy.
+ * Zwalnia tablicę kafelków gry z @p tiles_count pierwszymi kafelkami i blok
+ * kafelków.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void free_tiles(gamma_t* g) {
+  directory_release(g, (*g).directory);
+  block_release((*g).block);
+  (*g).tiles_count = 0;
+  (*g).tiles = NULL;
+  (*g).directory = NULL;
+  (*g).block = NULL;
+}
+
+/** @brief Kończy wątki pomocnicze.
+ * Czeka na zakończenie wątków pomocniczych i usuwa strukturę wskazywaną
+ * przez @p c. Nic nie robi, jeśli wskaźnik ten ma wartość @p NULL.
+ * @param[in] c       – wskaźnik na strukturę przechowującą wątki.
+ */
+static void crew_delete(struct crew* c) {
+  if (c == NULL) return;
+  pthread_mutex_lock(&((*c).lock));
+  (*c).finish = true;
+  pthread_cond_broadcast(&((*c).start));
+  pthread_mutex_unlock(&((*c).lock));
+  for (uint32_t i = 0; i < (*c).count; i++) pthread_join((*c).threads[i], NULL);
+  
+  pthread_cond_destroy(&((*c).done));
+  pthread_cond_destroy(&((*c).start));
+  pthread_mutex_destroy(&((*c).lock));
+  free((*c).views);
+  free((*c).helpers);
+  free((*c).threads);
+  free((*c).parent);
+  free((*c).last);
+  free(c);
+}
+
+void gamma_delete(gamma_t *g) {
+  if (g != NULL) {
+    crew_delete((*g).crew);
+    free_tiles(g);
+    sizes_release((*g).sizes);
+    free((*g).journal.changes);
+    free((*g).journal.moves);
+    history_free(g);
+    boards_free(g);
+    free((*g).seqlock.row_stamps);
+    
+    free(g); // Razem z tablicami gry.
+  }
+}
+
+/** @brief Liczy ilu znaków potrzeba do wypisania liczby.
+ * Liczy ilu znaków potrzeba do wypisania liczby @p x w tekstowym opisie planszy.
+ * @param[in] x       – liczba nieujemna.
+ * @return Liczba znaków potrzebnych do wypisania liczby.
+ */
+static uint64_t number_of_characters(uint32_t x) {
+	if (x == 0) return 1;
+  
+	uint64_t num = 0;
+	while (x > 0) {
+		num++;
+		x /= 10;
+	}
+	return num;
+}
+
+/** @brief Podaje liczbę bitów potrzebnych do zapisania numerów.
+ * @param[in] n       – liczba różnych numerów, liczba dodatnia.
+ * @return Najmniejsza liczba @p b taka, że 2^@p b >= @p n.
+ */
+static uint32_t bits_for(uint32_t n) {
+  uint32_t b = 0;
+  while (((uint64_t)1 << b) < n) b++;
+  return b;
+}
+
+/** @brief Podaje pozycję pola w kafelku.
+ * Przeplata bity kolumny i wiersza, zaczynając od najmłodszych, dopóki
+ * któregoś nie zabraknie; pozostałe bity dłuższego boku są najstarsze.
+ * @param[in] l       – wskaźnik na opis podziału planszy,
+ * @param[in] column  – numer kolumny w kafelku,
+ * @param[in] row     – numer wiersza w kafelku.
+ * @return Indeks pola w kafelku, liczba mniejsza od @ref TILE_CELLS.
+ */
+static uint32_t morton(struct layout* l, uint32_t column, uint32_t row) {
+  uint32_t code = 0, next = 0;
+  for (uint32_t i = 0; next < TILE_BITS; i++) {
+    if (i < (*l).width_bits) code |= ((column >> i) & 1) << next++;
+    if (i < (*l).height_bits) code |= ((row >> i) & 1) << next++;
+  }
+  return code;
+}
+
+/** @brief Dzieli planszę na kafelki.
+ * Wybiera kafelki możliwie kwadratowe, ale nie szersze ani wyższe niż to
+ * konieczne, aby wąskie plansze nie zajmowały pamięci na pola spoza planszy.
+ * @param[out] l      – wskaźnik na opis podziału planszy,
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] codes   – tablica na @p width + @p height części indeksów pól
+ *                      lub @p NULL, jeśli trzeba tylko policzyć kafelki.
+ * @return Liczba kafelków planszy.
+ */
+static uint64_t layout_init(struct layout* l, uint32_t width, uint32_t height,
+                            uint64_t* codes) {
+  uint32_t width_bits = bits_for(width), height_bits = bits_for(height);
+  if (width_bits > TILE_BITS / 2) width_bits = TILE_BITS / 2;
+  if (height_bits > TILE_BITS - width_bits) height_bits = TILE_BITS - width_bits;
+  width_bits = TILE_BITS - height_bits;
+  (*l).width_bits = width_bits;
+  (*l).height_bits = height_bits;
+  
+  uint64_t tile_width = (uint64_t)1 << width_bits;
+  uint64_t tile_height = (uint64_t)1 << height_bits;
+  (*l).tiles_in_row = ((uint64_t)width + tile_width - 1) / tile_width;
+  (*l).column_mask = morton(l, (uint32_t)tile_width - 1, 0);
+  (*l).row_mask = morton(l, 0, (uint32_t)tile_height - 1);
+  uint64_t count = (*l).tiles_in_row 
+                   * (((uint64_t)height + tile_height - 1) / tile_height);
+  if (codes == NULL) return count;
+  
+  // Bity kolumny i wiersza się nie pokrywają, więc pozycja pola w kafelku
+  // jest sumą części wyznaczonych przez kolumnę i przez wiersz.
+  uint32_t column_part[TILE_CELLS], row_part[TILE_CELLS];
+  for (uint32_t x = 0; x < tile_width; x++) column_part[x] = morton(l, x, 0);
+  for (uint32_t y = 0; y < tile_height; y++) row_part[y] = morton(l, 0, y);
+  
+  // Jedna tablica na części indeksów kolumn, a za nimi wierszy.
+  (*l).column_code = codes;
+  (*l).row_code = codes + width;
+  
+  for (uint32_t x = 0; x < width; x++) {
+    (*l).column_code[x] = ((uint64_t)(x >> width_bits) << TILE_BITS)
+                          | column_part[x & (tile_width - 1)];
+  }
+  for (uint32_t y = 0; y < height; y++) {
+    (*l).row_code[y] = ((uint64_t)(y >> height_bits) * (*l).tiles_in_row 
+                        << TILE_BITS)
+                       | row_part[y & (tile_height - 1)];
+  }
+  for (uint32_t x = 0; x < tile_width; x++) {
+    for (uint32_t y = 0; y < tile_height; y++) {
+      (*l).column_of[column_part[x] | row_part[y]] = (uint8_t)x;
+      (*l).row_of[column_part[x] | row_part[y]] = (uint8_t)y;
+    }
+  }
+  return count;
+}
+
+/** @brief Podaje długość bitmapy zmienionych kafelków.
+ * @param[in] c       – wskaźnik na rozmiary tablic gry.
+ * @return Liczba słów bitmapy @p dirty ze struktury @ref gamma.
+ */
+static uint64_t dirty_words(struct capacity* c) {
+  return ((*c).tiles + 63) / 64;
+}
+
+/** @brief Podaje rozmiar bloku pamięci gry.
+ * @param[in] c       – wskaźnik na rozmiary tablic gry.
+ * @return Rozmiar struktury przechowującej stan gry razem z jej tablicami
+ * w bajtach.
+ */
+static size_t arena_size(struct capacity* c) {
+  uint64_t n = (uint64_t)(*c).players + 1;
+  uint64_t roster = roster_layout(NULL, n);
+  return sizeof(gamma_t) 
+         + sizeof(uint64_t) * (4 * n + roster + (*c).codes + dirty_words(c))
+         + sizeof(uint32_t) * n + sizeof(bool) * n;
+}
+
+/** @brief Rozmieszcza tablice gry w jej bloku pamięci.
+ * Tablice leżą zaraz za strukturą, od najszerzej wyrównanych.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry
+ *                      z ustawionymi rozmiarami tablic.
+ */
+static void arena_arrays(gamma_t* g) {
+  uint64_t n = (uint64_t)(*g).capacity.players + 1;
+  uint64_t* words = (uint64_t*)(g + 1);
+  (*g).fields_of_player = words;
+  (*g).neighbours_of_player = words + n;
+  (*g).largest_region = words + 2 * n;
+  (*g).stuck = words + 3 * n;
+  (*g).roster.words = words + 4 * n;
+  words += 4 * n + roster_layout(&((*g).roster), n);
+  (*g).layout.column_code = words;
+  (*g).dirty = words + (*g).capacity.codes;
+  (*g).areas_of_player = (uint32_t*)((*g).dirty 
+                                     + dirty_words(&((*g).capacity)));
+  (*g).golden_move = (bool*)((*g).areas_of_player + n);
+}
+
+/** @brief Alokuje strukturę przechowującą stan gry.
+ * Alokuje jednym wywołaniem funkcji malloc strukturę razem z jej tablicami
+ * i osobno tablicę kafelków i pustą tablicę rozmiarów obszarów. Struktura
+ * jest wyzerowana, a tablice graczy i kafelków nie są inicjowane.
+ * @param[in] c       – wskaźnik na rozmiary tablic gry.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static gamma_t* arena_new(struct capacity* c) {
+  gamma_t* g = malloc(arena_size(c));
+  if (g == NULL) return NULL;
+  *g = (struct gamma){0};
+  (*g).capacity = *c;
+  arena_arrays(g);
+  (*g).directory = directory_new((*c).tiles);
+  (*g).sizes = sizes_new(SIZE_SLOTS);
+  if ((*g).directory == NULL || (*g).sizes == NULL) {
+    free((*g).directory);
+    free((*g).sizes);
+    free(g);
+    return NULL;
+  }
+  (*g).tiles = (*(*g).directory).tiles;
+  return g;
+}
+
+/** @brief Inicjuje kafelek pustej planszy.
+ * @param[out] t      – wskaźnik na kafelek,
+ * @param[in] i       – numer kafelka.
+ */
+static void tile_init(struct tile* t, uint64_t i) {
+  atomic_init(&((*t).refs), 1);
+  (*t).owners_count = 1;
+  (*t).owners[0] = 0;
+  (*t).counts[0] = TILE_CELLS;
+  (*t).uncounted = 0;
+  memset((*t).taken, 0, sizeof((*t).taken));
+  for (uint64_t j = 0; j < TILE_CELLS; j++) {
+    (*t).cells[j].player = 0;
+    (*t).cells[j].rep = (i << TILE_BITS) + j;
+    (*t).cells[j].visited = false;
+    (*t).regions[j].size = 0;
+    (*t).regions[j].boundary = 0;
+  }
+}
+
+/** @brief Przywraca kafelek pustej planszy.
+ * Pola, które nigdy nie były zajęte, są takie jak po inicjacji kafelka, więc
+ * przywracane są tylko pola zaznaczone w bitmapie @p taken.
+ * @param[in, out] t  – wskaźnik na kafelek, który nie jest współdzielony,
+ * @param[in] i       – numer kafelka.
+ */
+static void tile_clean(struct tile* t, uint64_t i) {
+  for (uint64_t k = 0; k < TILE_CELLS / 64; k++) {
+    uint64_t w = (*t).taken[k];
+    (*t).taken[k] = 0;
+    while (w != 0) {
+      uint64_t j = (k << 6) + (uint64_t)__builtin_ctzll(w);
+      w &= w - 1;
+      (*t).cells[j].player = 0;
+      (*t).cells[j].rep = (i << TILE_BITS) + j;
+      (*t).cells[j].visited = false;
+      (*t).regions[j].size = 0;
+      (*t).regions[j].boundary = 0;
+    }
+  }
+  atomic_init(&((*t).refs), 1);
+  (*t).owners_count = 1;
+  (*t).owners[0] = 0;
+  (*t).counts[0] = TILE_CELLS;
+  (*t).uncounted = 0;
+}
+
+/** @brief Ustawia kafelki gry na kafelki bloku.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] count   – liczba kafelków.
+ */
+static void use_block(gamma_t* g, uint64_t count) {
+  struct tile* base = (*(*g).block).address;
+  for (uint64_t i = 0; i < count; i++) (*g).tiles[i] = base + i;
+  (*g).tiles_count = count;
+}
+
+/** @brief Inicjuje kafelki pustej planszy.
+ * Ustawia @p count pierwszych kafelków gry na kolejne miejsca bloku kafelków
+ * i inicjuje je. Tablica kafelków i blok nie mogą być współdzielone.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] count   – liczba kafelków.
+ */
+static void init_tiles(gamma_t* g, uint64_t count) {
+  struct tile* base = (*(*g).block).address;
+  for (uint64_t i = 0; i < count; i++) tile_init(base + i, i);
+  memset((*g).dirty, 0, sizeof(uint64_t) * dirty_words(&((*g).capacity)));
+  use_block(g, count);
+}
+
+/** @brief Czyści kafelki planszy.
+ * Przywraca tylko kafelki bloku zaznaczone w bitmapie @p dirty; pozostałe
+ * nie zmieniły się od inicjacji. Blok i tablica kafelków nie mogą być
+ * współdzielone z inną grą.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] count   – nowa liczba kafelków, niewiększa od liczby kafelków
+ *                      bloku.
+ */
+static void clean_tiles(gamma_t* g, uint64_t count) {
+  for (uint64_t i = 0; i < (*g).tiles_count; i++) {
+    if (in_block(g, (*g).tiles[i]) == false) tile_release((*g).tiles[i]);
+  }
+  struct tile* base = (*(*g).block).address;
+  uint64_t length = (*(*g).block).length / sizeof(struct tile);
+  for (uint64_t k = 0; k < dirty_words(&((*g).capacity)); k++) {
+    uint64_t w = (*g).dirty[k];
+    (*g).dirty[k] = 0;
+    while (w != 0) {
+      uint64_t i = (k << 6) + (uint64_t)__builtin_ctzll(w);
+      w &= w - 1;
+      if (i < length) tile_clean(base + i, i);
+    }
+  }
+  use_block(g, count);
+}
+
+/** @brief Tworzy blok kafelków pustej planszy.
+ * Jeśli @p fd jest deskryptorem pliku, kafelki leżą we współdzielonym
+ * odwzorowaniu tego pliku, a w przeciwnym przypadku w pamięci.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry bez
+ *                      kafelków,
+ * @param[in] count   – liczba kafelków,
+ * @param[in] fd      – deskryptor pliku otwartego do odczytu i zapisu
+ *                      lub @p -1.
+ * @return Wartość @p true, jeśli się udało, a @p false w przeciwnym przypadku.
+ */
+static bool alloc_tiles(gamma_t* g, uint64_t count, int fd) {
+  if (fd < 0) {
+    (*g).block = block_new(count);
+    return (*g).block != NULL;
+  }
+  
+  size_t length = sizeof(struct tile) * count;
+  if (ftruncate(fd, (off_t)length) != 0) return false;
+  void* address = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+  if (address == MAP_FAILED) return false;
+  (*g).block = malloc(sizeof(struct block));
+  if ((*g).block == NULL) {
+    munmap(address, length);
+    return false;
+  }
+  atomic_init(&((*(*g).block).refs), 1);
+  (*(*g).block).address = address;
+  (*(*g).block).length = length;
+  (*(*g).block).file = true;
+  advise(g, POSIX_MADV_RANDOM);
+  return true;
+}
+
+/** @brief Ustawia początkowy stan gry.
+ * Kafelki muszą być już zainicjowane. Pamięć dziennika ruchów jest
+ * zachowywana, a bitmapy są usuwane.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] width   – szerokość planszy,
+ * @param[in] height  – wysokość planszy,
+ * @param[in] players – liczba graczy,
+ * @param[in] areas   – maksymalna liczba obszarów jednego gracza.
+ */
+static void game_init(gamma_t* g, uint32_t width, uint32_t height,
+                      uint32_t players, uint32_t areas) {
+  // Przy tych samych wymiarach podział planszy się nie zmienia.
+  if (width != (*g).info.width || height != (*g).info.height) 
+    layout_init(&((*g).layout), width, height, (*g).layout.column_code);
+  
+  for (uint32_t i = 0; i <= players; i++) {
+    (*g).largest_region[i] = 0;
+    (*g).areas_of_player[i] = 0;
+    (*g).fields_of_player[i] = 0;
+    (*g).neighbours_of_player[i] = 0;
+    (*g).stuck[i] = 0;
+    (*g).golden_move[i] = false;
+  }
+  
+  journal_clear(g);
+  (*g).journal.enabled = false;
+  (*g).journal.trial = false;
+  (*g).journal.failed = false;
+  history_free(g);
+  boards_free(g);
+  free((*g).seqlock.row_stamps);
+  (*g).seqlock = (struct seqlock){0};
+  crew_delete((*g).crew);
+  (*g).crew = NULL;
+#ifdef GAMMA_STATS
+  memset((*g).stats, 0, sizeof((*g).stats));
+  (*g).current = gamma_api_move;
+#endif
+  
+  (*g).free_fields = (uint64_t)(width) * (uint64_t)(height);
+  (*g).hash = 0;
+  (*g).epoch = 1;
+  (*g).info.height = height;
+  (*g).info.width = width;
+  (*g).info.players = players;
+  (*g).areas = areas;
+  
+  if (players <= 9) (*g).info.width_of_field = 1;
+  else (*g).info.width_of_field = number_of_characters(players) + 1;
+  roster_rebuild(g);
+}
+
+/** @brief Tworzy strukturę przechowującą stan gry.
+ * Wspólna część funkcji @ref gamma_new i @ref gamma_new_file.
+ * @param[in] width   – szerokość planszy,
+ * @param[in] height  – wysokość planszy,
+ * @param[in] players – liczba graczy,
+ * @param[in] areas   – maksymalna liczba obszarów jednego gracza,
+ * @param[in] fd      – deskryptor pliku na kafelki planszy lub @p -1.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL.
+ */
+static gamma_t* new_game(uint32_t width, uint32_t height,
+                         uint32_t players, uint32_t areas, int fd) {
+  
+  if (width <= 0 || height <= 0 || players <= 0 || areas <= 0) return NULL;
+  
+  struct layout l;
+  uint64_t tiles_count = layout_init(&l, width, height, NULL);
+  struct capacity c = {players, (uint64_t)width + height, tiles_count};
+  gamma_t* new = arena_new(&c);
+  if (new == NULL) return NULL;
+  
+  if (alloc_tiles(new, tiles_count, fd) == false) {
+    free_tiles(new);
+    free(new);
+    return NULL;
+  }
+  init_tiles(new, tiles_count);
+  game_init(new, width, height, players, areas);
+  return new;
+}
+
+gamma_t* gamma_new(uint32_t width, uint32_t height,
+                   uint32_t players, uint32_t areas) {
+  return new_game(width, height, players, areas, -1);
+}
+
+gamma_t* gamma_new_file(uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas, int fd) {
+  if (fd < 0) return NULL;
+  return new_game(width, height, players, areas, fd);
+}
+
+bool gamma_reset(gamma_t *g, uint32_t width, uint32_t height,
+                 uint32_t players, uint32_t areas) {
+  if (g == NULL || width <= 0 || height <= 0 || players <= 0 || areas <= 0) 
+    return false;
+  
+  uint64_t tiles_count = (*g).tiles_count;
+  if (width != (*g).info.width || height != (*g).info.height) {
+    struct layout l;
+    tiles_count = layout_init(&l, width, height, NULL);
+  }
+  if (players > (*g).capacity.players 
+      || (uint64_t)width + height > (*g).capacity.codes
+      || tiles_count > (*g).capacity.tiles) return false;
+  
+  // Tablicę rozmiarów obszarów czyszczę w miejscu, jeśli nie jest
+  // współdzielona i nie urosła.
+  struct sizes* s = (*g).sizes;
+  bool reuse = atomic_load(&((*s).refs)) == 1 && (*s).capacity == SIZE_SLOTS;
+  if (reuse == false) s = sizes_new(SIZE_SLOTS);
+  if (s == NULL) return false;
+  struct block* b = (*g).block;
+  if (atomic_load(&((*b).refs)) == 1 
+      && tiles_count <= (*b).length / sizeof(struct tile)) {
+    // Nikt inny nie korzysta z bloku ani z tablicy kafelków, więc czyszczę
+    // w miejscu zmienione kafelki.
+    clean_tiles(g, tiles_count);
+  }
+  else { // Blok jest współdzielony z kopią gry lub za mały.
+    b = block_new(tiles_count);
+    struct directory* d = directory_new((*g).capacity.tiles);
+    if (b == NULL || d == NULL) {
+      free(b);
+      free(d);
+      if (reuse == false) free(s);
+      return false;
+    }
+    free_tiles(g);
+    (*g).block = b;
+    (*g).directory = d;
+    (*g).tiles = (*d).tiles;
+    init_tiles(g, tiles_count);
+  }
+  if (reuse == true) {
+    memset((*s).slots, 0, sizeof(struct size_count) * SIZE_SLOTS);
+    (*s).used = 0;
+  }
+  else {
+    sizes_release((*g).sizes);
+    (*g).sizes = s;
+  }
+  (*g).exclusive = false;
+  game_init(g, width, height, players, areas);
+  return true;
+}
+
+/**
+ * Struktura przechowująca gry gotowe do ponownego użycia.
+ */
+struct gamma_pool {
+  uint32_t count; ///<liczba gier w puli
+  uint32_t size; ///<największa liczba gier w puli
+  gamma_t* games[]; ///<gry w puli
+};
+
+gamma_pool_t* gamma_pool_new(uint32_t width, uint32_t height,
+                             uint32_t players, uint32_t areas, uint32_t size) {
+  gamma_pool_t* pool = malloc(sizeof(gamma_pool_t) 
+                              + sizeof(gamma_t*) * (uint64_t)size);
+  if (pool == NULL) return NULL;
+  (*pool).count = 0;
+  (*pool).size = size;
+  
+  while ((*pool).count < size) {
+    gamma_t* g = gamma_new(width, height, players, areas);
+    if (g == NULL) {
+      gamma_pool_delete(pool);
+      return NULL;
+    }
+    (*pool).games[(*pool).count++] = g;
+  }
+  return pool;
+}
+
+gamma_t* gamma_pool_get(gamma_pool_t* pool, uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas) {
+  if (pool != NULL && (*pool).count > 0) {
+    gamma_t* g = (*pool).games[--(*pool).count];
+    if (gamma_reset(g, width, height, players, areas) == true) return g;
+    gamma_delete(g);
+  }
+  return gamma_new(width, height, players, areas);
+}
+
+void gamma_pool_put(gamma_pool_t* pool, gamma_t* g) {
+  if (g == NULL) return;
+  if (pool == NULL || (*pool).count == (*pool).size) gamma_delete(g);
+  else (*pool).games[(*pool).count++] = g;
+}
+
+void gamma_pool_delete(gamma_pool_t* pool) {
+  if (pool == NULL) return;
+  for (uint32_t i = 0; i < (*pool).count; i++) gamma_delete((*pool).games[i]);
+  free(pool);
+}
+
+gamma_t* gamma_clone(gamma_t *g) {
+  if (g == NULL) return NULL;
+  
+  uint64_t players = (uint64_t)(*g).info.players + 1;
+  struct capacity c = {(*g).info.players,
+                       (uint64_t)(*g).info.width + (*g).info.height,
+                       (*g).tiles_count};
+  gamma_t* new = (gamma_t*)malloc(arena_size(&c));
+  if (new == NULL) return NULL;
+  *new = *g;
+  (*new).capacity = c;
+  arena_arrays(new);
+  
+  memcpy((*new).areas_of_player, (*g).areas_of_player, 
+         sizeof(uint32_t) * players);
+  memcpy((*new).fields_of_player, (*g).fields_of_player, 
+         sizeof(uint64_t) * players);
+  memcpy((*new).neighbours_of_player, (*g).neighbours_of_player,
+         sizeof(uint64_t) * players);
+  memcpy((*new).golden_move, (*g).golden_move, sizeof(bool) * players);
+  memcpy((*new).stuck, (*g).stuck, sizeof(uint64_t) * players);
+  memcpy((*new).largest_region, (*g).largest_region, 
+         sizeof(uint64_t) * players);
+  memcpy((*new).layout.column_code, (*g).layout.column_code, 
+         sizeof(uint64_t) * c.codes);
+  // Kopia korzysta z bloku oryginału, więc przejmuje zaznaczenia jego kafelków.
+  memcpy((*new).dirty, (*g).dirty, sizeof(uint64_t) * dirty_words(&c));
+  (*new).layout.row_code = (*new).layout.column_code + (*g).info.width;
+  
+  // Współdzielę tablicę kafelków, blok i rozmiary obszarów.
+  atomic_fetch_add(&((*(*g).directory).refs), 1);
+  atomic_fetch_add(&((*(*g).block).refs), 1);
+  atomic_fetch_add(&((*(*g).sizes).refs), 1);
+  (*g).exclusive = false;
+  (*new).exclusive = false;
+  
+  (*new).boards = (struct bitboards){0};
+  (*new).journal = (struct journal){0};
+  (*new).history = (struct history){0};
+  (*new).seqlock = (struct seqlock){0};
+  (*new).crew = NULL;
+  roster_rebuild(new);
+#ifdef GAMMA_STATS
+  memset((*new).stats, 0, sizeof((*new).stats));
+#endif
+  
+  return new;
+}
+
+/** @brief Sprawdza czy pole sąsiaduje z polem gracza.
+ * Sprawdza czy w grze wskazywanej przez @p g pole (@p x, @p y)
+ * sąsiaduje z jakimś polem gracza @p player.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli tak, @p false w przeciwnym wypadku.
+ */
+static bool neighbour(gamma_t* g, uint32_t player, uint32_t x, uint32_t y) {
+  if (x > 0 && owner(g, x - 1, y) == player) return true;
+  if (x < (*g).info.width - 1 && owner(g, x + 1, y) == player) return true;
+  if (y > 0 && owner(g, x, y - 1) == player) return true;
+  if (y < (*g).info.height - 1 && owner(g, x, y + 1) == player) return true;
+  return false;
+}
+
+/** @brief Zwraca indeks reprezentanta.
+ * Zwraca indeks pola będącego reprezentantem obszaru, do którego należy
+ * pole o indeksie @p x.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – indeks pola.
+ * @return Indeks pola będącego reprezentantem obszaru.
+ */
+static uint64_t find(gamma_t* g, uint64_t x) {
+	if ((*cell(g, x)).rep == x) { // Sam jest swoim reprezentantem.
+		return x; // Zwraca indeks.
+	}
+	STATS_ADD(g, find_hops, 1);
+	uint64_t root = find(g, (*cell(g, x)).rep);
+	set_rep(g, x, root);
+	return root;
+}
+
+/** @brief Łączy dwa obszary.
+ * Łączy dwa obszary, do których należą pola o indeksach @p a i @p b.
+ * Jeśli nie były wcześniej połączone, 
+ * zmniejsza o 1 liczbę obszarów należących do gracza @p player.
+ * @param[in] a       – indeks pierwszego pola,
+ * @param[in] b       – indeks drugiego pola,
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ */
+static void uni(uint64_t a, uint64_t b, gamma_t* g, uint32_t player) {
+	uint64_t temp_a = find(g, a);
+  uint64_t temp_b = find(g, b);
+  
+  if (temp_a != temp_b) { // Jeśli mają różnych reprezentantów.
+    uint64_t size_a = (*region(g, temp_a)).size;
+    uint64_t size_b = (*region(g, temp_b)).size;
+    set_rep(g, temp_b, temp_a);
+    set_size(g, temp_a, size_a + size_b);
+    set_boundary(g, temp_a, 
+                 (*region(g, temp_a)).boundary + (*region(g, temp_b)).boundary);
+    // Najpierw dodaję większy rozmiar, żeby usunięcie mniejszych nie
+    // wymagało szukania największego obszaru.
+    add_size(g, player, size_a + size_b, 1);
+    add_size(g, player, size_a, -1);
+    add_size(g, player, size_b, -1);
+    add_areas(g, player, -1); // Zmniejszam liczbę obszarów.
+  }
+  else unstick_all(g); // Obszar ma nową drogę między swoimi polami.
+}
+
+/** @brief Liczy wolnych sąsiadów pola.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Liczba wolnych pól sąsiadujących z polem (@p x, @p y).
+ */
+static uint64_t free_around(gamma_t* g, uint32_t x, uint32_t y) {
+  uint64_t count = 0;
+  if (x > 0 && owner(g, x - 1, y) == 0) count++;
+  if (x < (*g).info.width - 1 && owner(g, x + 1, y) == 0) count++;
+  if (y > 0 && owner(g, x, y - 1) == 0) count++;
+  if (y < (*g).info.height - 1 && owner(g, x, y + 1) == 0) count++;
+  return count;
+}
+
+/** @brief Zmienia numer gracza na polu opisanym przez @p a.
+ * Gracze z sąsiednich pól zyskują obok siebie pole innego gracza, więc mogą
+ * mieć nowy złoty ruch.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] a       – wskaźnik na opis sąsiadów pola,
+ * @param[in] player  – nowy numer gracza na polu.
+ */
+static void set_owner(gamma_t* g, const struct around* a, uint32_t player) {
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    if ((*a).player[i] != 0 && (*a).player[i] != player) 
+      unstick(g, (*a).player[i]);
+  }
+  set_player(g, (*a).centre, player);
+}
+
+/** @brief Usuwa wolne pole z sąsiedztwa obszarów.
+ * Zmniejsza liczbę wolnych sąsiadów obszarów zawierających zajęte pola
+ * sąsiadujące z polem opisanym przez @p a, które przestaje być wolne.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] a       – wskaźnik na opis sąsiadów pola.
+ */
+static void claim_free(gamma_t* g, const struct around* a) {
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    if ((*a).player[i] != 0) {
+      uint64_t root = find(g, (*a).id[i]);
+      set_boundary(g, root, (*region(g, root)).boundary - 1);
+    }
+  }
+}
+
+/** @brief Tworzy jednopolowy obszar.
+ * Ustawia pole opisane przez @p a jako reprezentanta obszaru złożonego tylko
+ * z tego pola.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] a       – wskaźnik na opis sąsiadów pola.
+ */
+static void region_init(gamma_t* g, uint32_t player, const struct around* a) {
+  uint64_t id = (*a).centre;
+  set_rep(g, id, id);
+  set_size(g, id, 1);
+  set_boundary(g, id, free_count(a));
+  add_size(g, player, 1, 1);
+}
+
+/** @brief Łączy pole i jego sąsiadów w jeden obszar.
+ * Przypisuje polu opisanemu przez @p a numer gracza @p player.
+ * Aktualizuje liczbę obszarów i pól zajętych przez gracza @p player.
+ * Łączy obszary, w których leżą należące do gracza @p player
+ * pola sąsiadujące z tym polem, i obszar tego pola.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] a       – wskaźnik na opis sąsiadów pola.
+ */
+static void uni_neighbours(gamma_t *g, uint32_t player, 
+                           const struct around* a) {
+  add_areas(g, player, 1); // Dodaję nowy.
+  add_fields(g, player, 1);
+  set_owner(g, a, player);
+  region_init(g, player, a);
+  
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    if ((*a).player[i] == player) uni((*a).id[i], (*a).centre, g, player);
+  }
+}
+
+/** @brief Liczy wolnych sąsadów pola.
+ * Liczy wolne pola sąsiadujące z polem opisanym przez @p a, niesąsiadujące
+ * z żadnym polem gracza @p player;
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] a       – wskaźnik na opis sąsiadów pola.
+ * @return Liczba pól spełniających odpowiednie warunki.
+ */
+static uint32_t check_neighbours(gamma_t* g, uint32_t player,
+                                 const struct around* a) {
+  uint32_t count = 0;
+  // Jeśli sąsiad jest wolny i nie sąsiaduje z żadnym innym moim.
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    if ((*a).player[i] == 0
+        && neighbour(g, player, (*a).x[i], (*a).y[i]) == false) count++;
+  }
+  return count;
+}
+
+/** @brief Zmniejsza liczbę wolnych sąsiadów graczy sąsiadujących z polem.
+ * Zmniejsza o 1 liczbę wolnych sąsiadów graczy innyh niż @p player, 
+ * których pola sąsiadują z polem opisanym przez @p a.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] a       – wskaźnik na opis sąsiadów pola.
+ */
+static void change_neighbours(gamma_t* g, uint32_t player,
+                              const struct around* a) {
+  for (uint32_t i = 0; i < (*a).count; i++) {
+    uint32_t p = (*a).player[i];
+    // Jeśli sąsiad nie jest moim i nie jest zerem.
+    if (p == player || p == 0) continue;
+    bool seen = false; // Każdego gracza liczę raz.
+    for (uint32_t j = 0; j < i; j++) {
+      if ((*a).player[j] == p) seen = true;
+    }
+    if (seen == false) add_neighbours(g, p, -1);
+  }
+}
+
+/** @brief Wykonuje ruch.
+ * Ustawia pionek gracza @p player na polu (@p x, @p y), jeśli jest to legalny
+ * ruch.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
+ * gdy ruch jest nielegalny lub nie udało się zaalokować pamięci.
+ */
+static bool move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+  uint64_t id = cell_id(g, x, y);
+  // Jest tu pionek jakiegoś gracza.
+  if ((*cell(g, id)).player != 0) return false; 
+  // Za dużo obszarów, a pole nie sąsiaduje z moim polem. Większość
+  // nieudanych ruchów kończy się tutaj, przed wyznaczeniem sąsiadów.
+  if ((*g).areas_of_player[player] == (*g).areas 
+      && neighbour(g, player, x, y) == false) return false;
+  struct around a;
+  gather(g, x, y, id, &a);
+  // Pole nie sąsiaduje z moim polem.
+  if (adjacent(&a, player) == false) { 
+    if (sizes_reserve(g, SIZE_KEYS) == false) return false;
+    
+    uint64_t start = begin_move(g);
+    
+    // Aktualizuję liczbę wolnych sąsiadów gracza.
+    add_neighbours(g, player, check_neighbours(g, player, &a)); 
+    change_neighbours(g, player, &a);
+    
+    claim_free(g, &a);
+    set_owner(g, &a, player); // Dodaję nowy obszar.
+    region_init(g, player, &a);
+    add_areas(g, player, 1);
+    add_fields(g, player, 1);
+    add_free(g, -1);
+    
+    return end_move(g, start);
+  }
+  
+  else { // Pole sąsiaduje z przynajmniej jednym moim polem.
+    if (sizes_reserve(g, SIZE_KEYS) == false) return false;
+    uint64_t start = begin_move(g);
+    
+    add_free(g, -1);
+    
+    add_neighbours(g, player, -1); // To pole już nie jest wolnym sąsiadem.
+    // Aktualizuję liczbę wolnych sąsiadów.
+    add_neighbours(g, player, check_neighbours(g, player, &a)); 
+    change_neighbours(g, player, &a);
+    
+    claim_free(g, &a);
+    uni_neighbours(g, player, &a);
+    
+    return end_move(g, start);
+  }
+}
+
+bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+  // Czy parametry prawidłowe?
+  if (g == NULL) return false;
+  STATS_CALL(g, gamma_api_move);
+  if (player <= 0 || player > (*g).info.players) return false;
+  if (x >= (*g).info.width) return false;
+  if (y >= (*g).info.height) return false;
+  
+  write_begin(g);
+  bool result = move(g, player, x, y);
+  write_end(g);
+  if (result == true) history_add(g, player, x, y, false);
+  return result;
+}
+
+#ifndef GAMMA_STATS
+/** @brief Wykonuje ruchy z bieżącej fali.
+ * Pobiera kolejne ruchy fali, dopóki się nie skończą, i wykonuje je na widoku
+ * gry @p view.
+ * @param[in, out] c  – wskaźnik na strukturę przechowującą wątki,
+ * @param[in, out] view – wskaźnik na widok gry.
+ */
+static void run_wave(struct crew* c, gamma_t* view) {
+  for (;;) {
+    uint64_t i = atomic_fetch_add(&((*c).next), 1);
+    if (i >= (*c).end) return;
+    uint64_t k = (*c).order[i];
+    (*view).size_log = (*c).size_log + SIZE_CHANGES * k;
+    (*c).results[k] = move(view, (*c).moves[k].player, (*c).moves[k].x, 
+                           (*c).moves[k].y);
+  }
+}
+
+/** @brief Wykonuje pracę wątku pomocniczego.
+ * Czeka na kolejne fale i bierze udział w ich wykonaniu, dopóki wątki nie
+ * mają się zakończyć.
+ * @param[in] arg     – wskaźnik na opis wątku pomocniczego.
+ * @return Wartość @p NULL.
+ */
+static void* crew_thread(void* arg) {
+  struct helper* h = arg;
+  struct crew* c = (*h).crew;
+  uint64_t seen = 0;
+  
+  pthread_mutex_lock(&((*c).lock));
+  for (;;) {
+    while ((*c).generation == seen && (*c).finish == false)
+      pthread_cond_wait(&((*c).start), &((*c).lock));
+    if ((*c).finish == true) break;
+    seen = (*c).generation;
+    pthread_mutex_unlock(&((*c).lock));
+    
+    run_wave(c, &((*c).views[(*h).id]));
+    
+    pthread_mutex_lock(&((*c).lock));
+    if (--(*c).running == 0) pthread_cond_signal(&((*c).done));
+  }
+  pthread_mutex_unlock(&((*c).lock));
+  return NULL;
+}
+
+/** @brief Tworzy wątki pomocnicze.
+ * Tworzy też tablicę widoków gry dla nich i dla wątku wywołującego.
+ * @param[in] count   – liczba wątków pomocniczych, liczba dodatnia.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, jeśli nie udało się
+ * zaalokować pamięci lub utworzyć wątku.
+ */
+static struct crew* crew_new(uint32_t count) {
+  struct crew* c = calloc(1, sizeof(struct crew));
+  if (c == NULL) return NULL;
+  (*c).threads = malloc(sizeof(pthread_t) * count);
+  (*c).helpers = malloc(sizeof(struct helper) * count);
+  (*c).views = malloc(sizeof(gamma_t) * ((uint64_t)count + 1));
+  if ((*c).threads == NULL || (*c).helpers == NULL || (*c).views == NULL) {
+    free((*c).threads);
+    free((*c).helpers);
+    free((*c).views);
+    free(c);
+    return NULL;
+  }
+  pthread_mutex_init(&((*c).lock), NULL);
+  pthread_cond_init(&((*c).start), NULL);
+  pthread_cond_init(&((*c).done), NULL);
+  atomic_init(&((*c).next), 0);
+  
+  for (uint32_t i = 0; i < count; i++) {
+    (*c).helpers[i] = (struct helper){c, i + 1};
+    if (pthread_create(&((*c).threads[i]), NULL, crew_thread, 
+                       &((*c).helpers[i])) != 0) {
+      crew_delete(c); // Kończy już utworzone wątki.
+      return NULL;
+    }
+    (*c).count++;
+  }
+  return c;
+}
+
+/** @brief Wykonuje falę ruchów.
+ * Wykonuje ruchy o indeksach od @p begin do @p end - 1 w tablicy @p order
+ * razem z wątkami pomocniczymi i czeka na ich zakończenie. Krótką falę
+ * wykonuje bez udziału wątków pomocniczych.
+ * @param[in, out] c  – wskaźnik na strukturę przechowującą wątki,
+ * @param[in] begin   – indeks pierwszego ruchu fali,
+ * @param[in] end     – indeks za ostatnim ruchem fali.
+ */
+static void crew_run(struct crew* c, uint64_t begin, uint64_t end) {
+  atomic_store(&((*c).next), begin);
+  (*c).end = end;
+  if (end - begin < 2 * ((uint64_t)(*c).count + 1)) {
+    run_wave(c, &((*c).views[0]));
+    return;
+  }
+  
+  pthread_mutex_lock(&((*c).lock));
+  (*c).generation++;
+  (*c).running = (*c).count;
+  pthread_cond_broadcast(&((*c).start));
+  pthread_mutex_unlock(&((*c).lock));
+  
+  run_wave(c, &((*c).views[0]));
+  
+  pthread_mutex_lock(&((*c).lock));
+  while ((*c).running > 0) pthread_cond_wait(&((*c).done), &((*c).lock));
+  pthread_mutex_unlock(&((*c).lock));
+}
+
+/** @brief Podaje reprezentanta klasy kafelków.
+ * Kafelki, których dotykają zależne od siebie ruchy, są łączone w klasy
+ * przechowywane jako drzewa, patrz @ref speculate.
+ * @param[in, out] parent – tablica ojców kafelków w drzewach klas,
+ * @param[in] t       – numer kafelka.
+ * @return Numer kafelka reprezentującego klasę kafelka @p t.
+ */
+static uint64_t tile_class(uint64_t* parent, uint64_t t) {
+  while (parent[t] != t) {
+    parent[t] = parent[parent[t]];
+    t = parent[t];
+  }
+  return t;
+}
+
+/** @brief Przygotowuje klasy kafelków.
+ * Powiększa tablice klas kafelków, jeśli są za małe, i ustawia każdy nowy
+ * kafelek jako osobną klasę z falą @p 0. Pozostałe kafelki są już tak
+ * ustawione, więc koszt nie zależy od liczby kafelków, jeśli tablice mają
+ * odpowiedni rozmiar.
+ * @param[in, out] c  – wskaźnik na strukturę przechowującą wątki,
+ * @param[in] tiles   – liczba kafelków planszy.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool classes_reserve(struct crew* c, uint64_t tiles) {
+  if (tiles <= (*c).classes) return true;
+  uint64_t* parent = realloc((*c).parent, sizeof(uint64_t) * tiles);
+  if (parent == NULL) return false;
+  (*c).parent = parent;
+  uint64_t* last = realloc((*c).last, sizeof(uint64_t) * tiles);
+  if (last == NULL) return false;
+  (*c).last = last;
+  for (uint64_t t = (*c).classes; t < tiles; t++) {
+    parent[t] = t;
+    last[t] = 0;
+  }
+  (*c).classes = tiles;
+  return true;
+}
+
+/** @brief Wyznacza kafelki, których dotyka ruch.
+ * Ruch czyta pola odległe o co najwyżej dwa od pola (@p x, @p y), zmienia
+ * to pole i obszary, do których należą jego sąsiedzi. Obszar jest
+ * reprezentowany przez kafelek zawierający jego reprezentanta.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new,
+ * @param[out] tiles  – tablica na co najwyżej 17 numerów kafelków.
+ * @return Liczba różnych kafelków zapisanych w tablicy @p tiles.
+ */
+static uint32_t touched_tiles(gamma_t* g, uint32_t x, uint32_t y,
+                              uint64_t tiles[17]) {
+  uint64_t found[17];
+  uint32_t count = 0;
+  for (int64_t dy = -2; dy <= 2; dy++) {
+    int64_t reach = 2 - (dy < 0 ? -dy : dy);
+    for (int64_t dx = -reach; dx <= reach; dx++) {
+      int64_t nx = (int64_t)x + dx, ny = (int64_t)y + dy;
+      if (nx < 0 || ny < 0 || nx >= (*g).info.width
+          || ny >= (*g).info.height) continue;
+      found[count++] = cell_id(g, (uint32_t)nx, (uint32_t)ny) >> TILE_BITS;
+    }
+  }
+  const int64_t dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+  for (int i = 0; i < 4; i++) {
+    int64_t nx = (int64_t)x + dx[i], ny = (int64_t)y + dy[i];
+    if (nx < 0 || ny < 0 || nx >= (*g).info.width
+        || ny >= (*g).info.height) continue;
+    if (owner(g, (uint32_t)nx, (uint32_t)ny) == 0) continue;
+    found[count++] = find(g, cell_id(g, (uint32_t)nx, (uint32_t)ny)) 
+                     >> TILE_BITS;
+  }
+  
+  uint32_t unique = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t j = 0;
+    while (j < unique && tiles[j] != found[i]) j++;
+    if (j == unique) tiles[unique++] = found[i];
+  }
+  return unique;
+}
+
+/** @brief Szuka miejsca pola w zbiorze pól funkcji @ref speculate.
+ * @param[in] set     – tablica zbioru, wolne miejsca mają wartość @p 0,
+ * @param[in] mask    – rozmiar tablicy, potęga dwójki, pomniejszony o 1,
+ * @param[in] id      – indeks pola.
+ * @return Miejsce z wartością @p id + 1 lub wolne miejsce, na które należy
+ * ją wstawić.
+ */
+static uint64_t* cell_slot(uint64_t* set, uint64_t mask, uint64_t id) {
+  uint64_t h = id * 0x9e3779b97f4a7c15ULL;
+  for (uint64_t i = (h ^ (h >> 32)) & mask;; i = (i + 1) & mask) {
+    if (set[i] == 0 || set[i] == id + 1) return &(set[i]);
+  }
+}
+
+/** @brief Wykonuje ciąg ruchów równolegle.
+ * Ruchy na zajęte pola są odrzucane od razu, bo ruchy nie zwalniają pól.
+ * Każdy pozostały ruch trafia do fali o numerze o jeden większym niż
+ * największy numer fali ruchu z jego klasy kafelków, a jego kafelki są
+ * łączone w jedną klasę. Klasy obejmują w ten sposób także obszary
+ * połączone przez wcześniejsze ruchy ciągu, więc ruchy jednej fali zmieniają
+ * rozłączne pola, kafelki i obszary.
+ * Każdy wątek wykonuje ruchy na widoku gry: kopii struktury gry, która
+ * współdzieli z nią planszę, ale ma własne liczniki graczy, liczbę wolnych
+ * pól i skrót. Gracze tych ruchów nie osiągają w trakcie ciągu limitu
+ * obszarów, więc ruchy nie zależą od liczników, a ich zmiany są na końcu
+ * sumowane. Ruchy graczy, którzy mogliby osiągnąć limit, i późniejsze ruchy
+ * na ich pola są wykonywane potem po kolei, bo zależą od wyników wcześniejszych
+ * ruchów tylko przez pola i obszary swoich graczy.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves   – wskaźnik na tablicę @p count ruchów,
+ * @param[in] count   – liczba ruchów, liczba dodatnia,
+ * @param[out] results – wskaźnik na tablicę @p count wyników.
+ * @return Wartość @p true, jeśli ruchy zostały wykonane, a @p false, jeśli
+ * trzeba je wykonać po kolei; stan gry się wtedy nie zmienia.
+ */
+static bool speculate(gamma_t* g, const struct gamma_move_args* moves,
+                      uint64_t count, bool* results) {
+  if (recording(g) == true || concurrent(g) == true 
+      || (*g).history.enabled == true || (*g).boards.of_player != NULL 
+      || (*g).areas > UINT32_MAX - count) return false;
+  
+  struct crew* c = (*g).crew;
+  if (classes_reserve(c, (*g).tiles_count) == false) return false;
+  uint64_t views = (uint64_t)(*c).count + 1;
+  uint64_t players = (uint64_t)(*g).info.players + 1;
+  // Jeden blok na wszystkie tablice pomocnicze, w słowach 64-bitowych;
+  // żadna nie zależy od liczby kafelków.
+  uint64_t slots = 1; // Zbiór pól jest wypełniony co najwyżej w połowie.
+  while (slots < 2 * count) slots <<= 1;
+  uint64_t words = players + 4 * count + 2 + views * players * 4 
+                   + 17 * count + 2 * SIZE_CHANGES * count + slots;
+  uint64_t* scratch = malloc(sizeof(uint64_t) * words);
+  if (scratch == NULL) return false;
+  uint64_t* tally = scratch;
+  uint64_t* wave = tally + players;
+  uint64_t* order = wave + count;
+  uint64_t* later = order + count;
+  uint64_t* starts = later + count;
+  uint64_t* counters = starts + count + 2;
+  uint64_t* used = counters + views * players * 4;
+  struct size_change* size_log = (struct size_change*)(used + 17 * count);
+  uint64_t* set = used + 17 * count + 2 * SIZE_CHANGES * count;
+  uint64_t* parent = (*c).parent;
+  uint64_t* last = (*c).last;
+  
+  // Liczę ruchy graczy, żeby sprawdzić, kto mógłby osiągnąć limit obszarów.
+  for (uint64_t p = 0; p < players; p++) tally[p] = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    if (moves[i].player > 0 && moves[i].player <= (*g).info.players) 
+      tally[moves[i].player]++;
+  }
+  memset(set, 0, sizeof(uint64_t) * slots);
+  // Każdy ruch dodaje co najwyżej jeden nowy rozmiar obszaru.
+  if (sizes_reserve(g, count) == false) {
+    free(scratch);
+    return false;
+  }
+  
+  // Przydzielam ruchy do fal. Zapamiętuję kafelki, których klasy się
+  // zmieniają, żeby potem przywrócić tylko je.
+  uint64_t waves = 0, used_count = 0, later_count = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    uint32_t player = moves[i].player, x = moves[i].x, y = moves[i].y;
+    wave[i] = 0;
+    if (player <= 0 || player > (*g).info.players || x >= (*g).info.width 
+        || y >= (*g).info.height || owner(g, x, y) != 0) {
+      results[i] = false; // Ruch na pewno jest nielegalny.
+      continue;
+    }
+    // Ruch zależy od liczby obszarów gracza lub od takiego ruchu.
+    uint64_t* slot = cell_slot(set, slots - 1, cell_id(g, x, y));
+    if ((*g).areas_of_player[player] + tally[player] > (*g).areas) 
+      *slot = cell_id(g, x, y) + 1;
+    if (*slot != 0) {
+      later[later_count++] = i;
+      continue;
+    }
+    // Widoki zapisywałyby wspólne słowa bitmapy, więc zaznaczam kafelek
+    // z góry; ruch może się nie udać, ale nadmiarowe zaznaczenie nie szkodzi.
+    mark_dirty(g, cell_id(g, x, y) >> TILE_BITS);
+    uint64_t tiles[17];
+    uint32_t n = touched_tiles(g, x, y, tiles);
+    for (uint32_t j = 0; j < n; j++) {
+      if (parent[tiles[j]] == tiles[j] && last[tiles[j]] == 0) 
+        used[used_count++] = tiles[j];
+      tiles[j] = tile_class(parent, tiles[j]);
+      if (last[tiles[j]] >= wave[i]) wave[i] = last[tiles[j]] + 1;
+    }
+    for (uint32_t j = 1; j < n; j++) parent[tile_class(parent, tiles[j])] = 
+                                       tile_class(parent, tiles[0]);
+    last[tile_class(parent, tiles[0])] = wave[i];
+    if (wave[i] > waves) waves = wave[i];
+  }
+  for (uint64_t k = 0; k < used_count; k++) {
+    parent[used[k]] = used[k];
+    last[used[k]] = 0;
+  }
+  
+  // Układam ruchy falami, zachowując ich kolejność.
+  for (uint64_t w = 0; w <= waves + 1; w++) starts[w] = 0;
+  for (uint64_t i = 0; i < count; i++) starts[wave[i] + 1]++;
+  for (uint64_t w = 1; w <= waves + 1; w++) starts[w] += starts[w - 1];
+  for (uint64_t i = 0; i < count; i++) order[starts[wave[i]]++] = i;
+  // Teraz starts[w] jest początkiem fali w + 1.
+  
+  // Widoki gry z własnymi licznikami.
+  for (uint64_t v = 0; v < views; v++) {
+    gamma_t* view = &((*c).views[v]);
+    *view = *g;
+    uint64_t* own = counters + v * players * 4;
+    (*view).fields_of_player = own;
+    (*view).neighbours_of_player = own + players;
+    (*view).largest_region = own + 2 * players;
+    (*view).areas_of_player = (uint32_t*)(own + 3 * players);
+    (*view).roster.words = NULL;
+    memcpy((*view).fields_of_player, (*g).fields_of_player, 
+           sizeof(uint64_t) * players);
+    memcpy((*view).neighbours_of_player, (*g).neighbours_of_player,
+           sizeof(uint64_t) * players);
+    memcpy((*view).largest_region, (*g).largest_region, 
+           sizeof(uint64_t) * players);
+    memcpy((*view).areas_of_player, (*g).areas_of_player, 
+           sizeof(uint32_t) * players);
+  }
+  
+  memset(size_log, 0, sizeof(struct size_change) * SIZE_CHANGES * count);
+  (*c).moves = moves;
+  (*c).order = order;
+  (*c).results = results;
+  (*c).size_log = size_log;
+  for (uint64_t w = 1; w <= waves; w++) crew_run(c, starts[w - 1], starts[w]);
+  
+  // Sumuję zmiany liczników z widoków.
+  uint64_t free_fields = (*g).free_fields, hash = (*g).hash;
+  for (uint64_t v = 0; v < views; v++) {
+    gamma_t* view = &((*c).views[v]);
+    free_fields += (*view).free_fields - (*g).free_fields;
+    hash ^= (*view).hash ^ (*g).hash;
+  }
+  (*g).free_fields = free_fields;
+  (*g).hash = hash;
+  for (uint64_t p = 0; p < players; p++) {
+    uint64_t fields = 0, neighbours = 0, largest = (*g).largest_region[p];
+    uint32_t areas = 0;
+    for (uint64_t v = 0; v < views; v++) {
+      gamma_t* view = &((*c).views[v]);
+      fields += (*view).fields_of_player[p] - (*g).fields_of_player[p];
+      neighbours += (*view).neighbours_of_player[p] 
+                    - (*g).neighbours_of_player[p];
+      areas += (*view).areas_of_player[p] - (*g).areas_of_player[p];
+      if ((*view).largest_region[p] > largest) 
+        largest = (*view).largest_region[p];
+    }
+    (*g).fields_of_player[p] += fields;
+    (*g).neighbours_of_player[p] += neighbours;
+    (*g).areas_of_player[p] += areas;
+    (*g).largest_region[p] = largest;
+  }
+  // Wprowadzam zmiany rozmiarów obszarów w kolejności ruchów, w każdym
+  // ruchu najpierw dodane rozmiary, które są większe od usuwanych.
+  for (uint64_t i = 0; i < SIZE_CHANGES * count; i += SIZE_CHANGES) {
+    for (int delta = 1; delta >= -1; delta -= 2) {
+      for (uint64_t j = i; j < i + SIZE_CHANGES; j++) {
+        if (size_log[j].player != 0 && size_log[j].delta == delta) 
+          add_size(g, size_log[j].player, size_log[j].size, delta);
+      }
+    }
+  }
+  roster_rebuild(g);
+  unstick_all(g); // Widoki nie zapominają o zablokowanych graczach.
+  for (uint64_t k = 0; k < later_count; k++) {
+    const struct gamma_move_args* m = &(moves[later[k]]);
+    results[later[k]] = gamma_move(g, (*m).player, (*m).x, (*m).y);
+  }
+  free(scratch);
+  return true;
+}
+#endif
+
+bool gamma_moves(gamma_t *g, const struct gamma_move_args *moves,
+                 uint64_t count, bool *results, uint32_t threads) {
+  if (g == NULL || (count > 0 && (moves == NULL || results == NULL))) 
+    return false;
+  
+#ifdef GAMMA_STATS
+  (void)threads; // Statystyki zależą od kolejności ruchów.
+#else
+  if (threads > 1 && count > 0) {
+    if ((*g).crew != NULL && (*(*g).crew).count != threads - 1) {
+      crew_delete((*g).crew);
+      (*g).crew = NULL;
+    }
+    if ((*g).crew == NULL) (*g).crew = crew_new(threads - 1);
+    if ((*g).crew != NULL && speculate(g, moves, count, results) == true) 
+      return true;
+  }
+#endif
+  
+  for (uint64_t i = 0; i < count; i++) 
+    results[i] = gamma_move(g, moves[i].player, moves[i].x, moves[i].y);
+  return true;
+}
+
+uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
+  if (g == NULL || player > (*g).info.players || player <= 0) return 0;
+  if (concurrent(g) == true) { // Odczyt z innego wątku.
+    uint64_t s, result;
+    do {
+      s = read_begin(g);
+      result = SHARED_LOAD((*g).fields_of_player[player]);
+    } while (read_retry(g, s) == true);
+    return result;
+  }
+  STATS_CALL(g, gamma_api_busy_fields);
+  return (*g).fields_of_player[player];
+}
+
+/** @brief Podaje liczbę pól, jakie jeszcze gracz może zająć.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Wynik funkcji @ref gamma_free_fields.
+ */
+static uint64_t free_of(gamma_t* g, uint32_t player) {
+  if (SHARED_LOAD((*g).areas_of_player[player]) == (*g).areas) 
+    return SHARED_LOAD((*g).neighbours_of_player[player]);
+  
+  return SHARED_LOAD((*g).free_fields);
+}
+
+uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
+  if (g == NULL || player > (*g).info.players || player <= 0) return 0;
+  if (concurrent(g) == true) { // Odczyt z innego wątku.
+    uint64_t s, result;
+    do {
+      s = read_begin(g);
+      result = free_of(g, player);
+    } while (read_retry(g, s) == true);
+    return result;
+  }
+  STATS_CALL(g, gamma_api_free_fields);
+  return free_of(g, player);
+}
+
+/** @brief Przechodzi obszar wgłąb.
+ * Przechodzi wgłąb należący do gracza @p player obszar zawierający
+ * pole (@p x, @p y), zmieniając reprezentanta pól na @p new_rep oraz informację
+ * o ich przetworzeniu na @p b. Nie wchodzi na pola, których nie udało się
+ * zmienić. Jeśli podano liczniki, zlicza odwiedzone pola i ich wolnych
+ * sąsiadów.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] new_rep – indeks pola,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new,
+ * @param[in] b       – wartość @p true lub @p false,
+ * @param[in, out] size – wskaźnik na licznik odwiedzonych pól lub @p NULL,
+ * @param[in, out] boundary
+ *                    – wskaźnik na licznik par sąsiednich pól obszaru i wolnych
+ *                      lub @p NULL.
+ */
+static void dfs(gamma_t* g, uint64_t new_rep, uint32_t player, 
+                uint32_t x, uint32_t y, bool b, 
+                uint64_t* size, uint64_t* boundary) {
+  if (size != NULL) {
+    (*size)++;
+    (*boundary) += free_around(g, x, y);
+  }
+
+  STATS_ADD(g, cells_visited, 1);
+  set_rep(g, cell_id(g, x, y), new_rep); 
+  field_t* f = writable(g, cell_id(g, x, y));
+  if (f == NULL) {
+    (*g).journal.failed = true;
+    return;
+  }
+  (*f).visited = b;
+  
+  if (x > 0 && owner(g, x - 1, y) == player 
+      && (*at(g, x - 1, y)).visited != b) {
+    dfs(g, new_rep, player, x - 1, y, b, size, boundary);
+  }
+  if (x < (*g).info.width - 1 && owner(g, x + 1, y) == player 
+      && (*at(g, x + 1, y)).visited != b) {
+    dfs(g, new_rep, player, x + 1, y, b, size, boundary);
+  }
+  if (y > 0 && owner(g, x, y - 1) == player 
+      && (*at(g, x, y - 1)).visited != b) {
+    dfs(g, new_rep, player, x, y - 1, b, size, boundary);
+  }
+  if (y < (*g).info.height - 1 && owner(g, x, y + 1) == player 
+      && (*at(g, x, y + 1)).visited != b) {
+    dfs(g, new_rep, player, x, y + 1, b, size, boundary);
+  }
+}
+
+/** @brief Wydziela część obszaru.
+ * Przechodzi część obszaru gracza @p player zawierającą pole (@p x, @p y),
+ * ustawiając to pole jako jej reprezentanta, zaznaczając jej pola jako
+ * przetworzone, zapisując w reprezentancie jej rozmiary i dodając jej
+ * rozmiar do rozmiarów obszarów gracza.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ */
+static void part(gamma_t* g, uint32_t player, uint32_t x, uint32_t y) {
+  uint64_t size = 0, boundary = 0;
+  dfs(g, cell_id(g, x, y), player, x, y, true, &size, &boundary);
+  set_size(g, cell_id(g, x, y), size);
+  set_boundary(g, cell_id(g, x, y), boundary);
+  add_size(g, player, size, 1);
+}
+
+/** @brief Wykonuje złoty ruch.
+ * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
+ * gracza, usuwając pionek innego gracza. Nie sprawdza poprawności parametrów.
+ * Jeśli ruch okaże się nielegalny, przywraca poprzedni stan gry.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
+ * gdy gracz wykorzystał już swój złoty ruch lub ruch jest nielegalny.
+ */
+static bool golden(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+  // Gracz wykonał złoty ruch.
+  if ((*g).golden_move[player] == true) return false; 
+  uint64_t id = cell_id(g, x, y);
+  uint32_t prev_player = (*cell(g, id)).player; // Poprzedni gracz.
+  // Ruch nie jest złoty.
+  if (prev_player == 0 || prev_player == player) return false; 
+  struct around a;
+  gather(g, x, y, id, &a);
+  // Za dużo obszarów.
+  if (adjacent(&a, player) == false 
+      && (*g).areas_of_player[player] == (*g).areas) return false; 
+  
+  if (sizes_reserve(g, SIZE_KEYS) == false) return false;
+  uint64_t start = begin_move(g);
+  uint64_t old_size = (*region(g, find(g, id))).size;
+  
+  // Tyle wolnych do dodania w przypadku wstawienia.
+  uint32_t to_add = check_neighbours(g, player, &a); 
+  
+  set_owner(g, &a, player); // Niech pole puste.
+  set_rep(g, id, id);
+  add_fields(g, prev_player, -1); 
+  // Zmieniam liczbę pól poprzedniego gracza.
+  uint32_t parts = 0;
+  
+  for (uint32_t i = 0; i < a.count; i++) {
+    if (a.player[i] == prev_player
+        && (*cell(g, a.id[i])).visited == false) {
+      parts++;
+      part(g, prev_player, a.x[i], a.y[i]);
+    }
+  }
+  
+  // Cofam odwiedzenie pól.
+  for (uint32_t i = 0; i < a.count; i++) {
+    if (a.player[i] == prev_player
+        && (*cell(g, a.id[i])).visited == true) {
+      dfs(g, a.id[i], prev_player, a.x[i], a.y[i], false, NULL, NULL);
+    }
+  }
+  
+  // Części zastępują podzielony obszar, który mógł być największy.
+  add_size(g, prev_player, old_size, -1);
+  
+  // Zmieniam liczbę obszarów poprzedniego gracza.
+  add_areas(g, prev_player, (int64_t)parts - 1); 
+  
+  // Można usunąć bez naruszania zasad.
+  if ((*g).areas_of_player[prev_player] <= (*g).areas) { 
+    // Zmniejszam liczbę wolnych sąsiadów poprzedniego gracza.
+    add_neighbours(g, prev_player, 
+                   -(int64_t)check_neighbours(g, prev_player, &a)); 
+    // Zwiększam liczbę wolnych sąsiadów nowego gracza.
+    add_neighbours(g, player, to_add); 
+    uni_neighbours(g, player, &a); // Wstawiam.
+    set_golden(g, player, true);
+    unstick_all(g);
+    
+    return end_move(g, start);
+  }
+  
+  else {
+    if (recording(g) == true) {
+      rollback(g, start);
+      (*g).journal.failed = false;
+    }
+    else {
+      uni_neighbours(g, prev_player, &a);
+    }
+    return false;
+  }
+}
+
+/** @brief Rezerwuje pamięć na próbny złoty ruch.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] x       – numer kolumny pola innego gracza,
+ * @param[in] y       – numer wiersza pola innego gracza.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool trial_reserve(gamma_t *g, uint32_t player, uint32_t x, 
+                          uint32_t y) {
+  uint32_t prev_player = owner(g, x, y);
+  // Ruch zmienia co najwyżej pola obszaru poprzedniego gracza, ścieżki
+  // w obszarach gracza oraz stałą liczbę liczników.
+  uint64_t bound = (*g).fields_of_player[prev_player] 
+                   + 8 * ((*g).fields_of_player[player] + 1) + 128;
+  return journal_reserve(g, bound) == true 
+         && sizes_reserve(g, SIZE_KEYS) == true;
+}
+
+/** @brief Sprawdza, czy złoty ruch jest legalny.
+ * Wykonuje próbnie złoty ruch gracza @p player na polu (@p x, @p y),
+ * a następnie cofa jego skutki za pomocą dziennika ruchów.
+ * Nie zmienia zawartości dziennika.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli ruch jest legalny, a @p false w przeciwnym
+ * wypadku lub jeśli nie udało się zaalokować pamięci.
+ */
+static bool golden_trial(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+  if (trial_reserve(g, player, x, y) == false) return false;
+  
+  STATS_ADD(g, trial_moves, 1);
+  write_begin(g);
+  uint64_t start = (*g).journal.changes_count;
+  (*g).journal.trial = true;
+  bool result = golden(g, player, x, y);
+  rollback(g, start);
+  (*g).journal.trial = false;
+  write_end(g);
+  
+  return result;
+}
+
+bool gamma_golden_possible(gamma_t *g, uint32_t player) {
+  if (g == NULL || player > (*g).info.players || player <= 0) return false;
+  STATS_CALL(g, gamma_api_golden_possible);
+  
+  if ((*g).golden_move[player] == false) { // Nie wykonał złotego ruchu.
+  
+  // Istnieje jakieś pole należące do innego gracza.
+   if ((*g).free_fields + (*g).fields_of_player[player] < 
+        (uint64_t)(*g).info.width * (uint64_t)(*g).info.height) {
+          
+     // Liczba moich obszarów jest mniejsza niż maksymalna.
+     if ((*g).areas_of_player[player] < (*g).areas) {
+       return true;
+     }
+     
+     // Od ostatniego przeglądu nic nie mogło dać mi złotego ruchu.
+     else if ((*g).stuck[player] == (*g).epoch) return false;
+     
+     else { // Liczba moich obszarów jest maksymalna;
+       // Wynik przeglądu jest pewny, jeśli nie zabrakło pamięci.
+       bool sure = true;
+       // Przeglądam pola kafelkami, w kolejności pamięci.
+       struct layout* l = &((*g).layout);
+       for (uint64_t t = 0; t < (*g).tiles_count; t++) {
+         uint64_t left = (t % (*l).tiles_in_row) << (*l).width_bits;
+         uint64_t bottom = (t / (*l).tiles_in_row) << (*l).height_bits;
+         for (uint64_t k = 0; k < TILE_CELLS; k++) {
+           uint64_t x = left + (*l).column_of[k], y = bottom + (*l).row_of[k];
+           if (x >= (*g).info.width || y >= (*g).info.height) continue;
+           uint32_t p = (*(*g).tiles[t]).cells[k].player;
+           
+           //Jeśli pole innego gracza sąsiaduje z moim obszarem.
+           if (p != 0 && p != player
+            && neighbour(g, player, (uint32_t)x, (uint32_t)y) == true) {
+             
+             if (trial_reserve(g, player, (uint32_t)x, (uint32_t)y) 
+                 == false) sure = false;
+             
+             //Jeśli udało się na nim wykonać złoty ruch.
+             else if (golden_trial(g, player, (uint32_t)x, (uint32_t)y) 
+                      == true) {
+              return true;
+             }
+           }
+         }
+       }
+       if (sure == true) (*g).stuck[player] = (*g).epoch;
+     }
+   }
+  }
+  return false;
+}
+
+uint32_t gamma_next_player(gamma_t *g, uint32_t player) {
+  if (g == NULL || player > (*g).info.players) return 0;
+  struct roster* r = &((*g).roster);
+  
+  // Każdego gracza ze zbioru sprawdzam co najwyżej raz.
+  uint64_t p = player;
+  for (uint32_t checked = 0; checked < (*r).count; checked++) {
+    p = roster_next(r, p);
+    if (p == 0) p = roster_next(r, 0); // Zaczynam od początku.
+    if (free_of(g, (uint32_t)p) > 0 
+        || gamma_golden_possible(g, (uint32_t)p) == true) return (uint32_t)p;
+  }
+  return 0;
+}
+
+bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+  // Czy parametry prawidłowe?
+  if (g == NULL) return false;
+  STATS_CALL(g, gamma_api_golden_move);
+  if (player <= 0 || player > (*g).info.players) return false;
+  if (x >= (*g).info.width) return false;
+  if (y >= (*g).info.height) return false;
+  
+  write_begin(g);
+  bool result = golden(g, player, x, y);
+  write_end(g);
+  if (result == true) history_add(g, player, x, y, true);
+  return result;
+}
+
+/** @brief Podaje bitmapę pól gracza.
+ * Podaje bitmapę pól zajętych przez gracza @p player lub, dla @p player
+ * równego @p 0, bitmapę wolnych pól. Jeśli bitmapa nie była jeszcze
+ * utworzona, tworzy ją, przeglądając całą planszę.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza lub @p 0.
+ * @return Wskaźnik na bitmapę lub @p NULL, jeśli nie udało się zaalokować
+ * pamięci.
+ */
+static uint64_t* board_of(gamma_t* g, uint32_t player) {
+  struct bitboards* b = &((*g).boards);
+  if ((*b).of_player == NULL) {
+    (*b).of_player = calloc((uint64_t)(*g).info.players + 1, sizeof(uint64_t*));
+    if ((*b).of_player == NULL) return NULL;
+  }
+  
+  if ((*b).of_player[player] == NULL) {
+    uint64_t* board = calloc(words_count(g), sizeof(uint64_t));
+    if (board == NULL) return NULL;
+    
+    uint64_t id = 0;
+    for (uint32_t y = 0; y < (*g).info.height; y++) {
+      for (uint32_t x = 0; x < (*g).info.width; x++, id++) {
+        if (owner(g, x, y) == player) 
+          board[id >> 6] |= (uint64_t)1 << (id & 63);
+      }
+    }
+    (*b).of_player[player] = board;
+  }
+  return (*b).of_player[player];
+}
+
+/** @brief Tworzy bitmapy skrajnych kolumn planszy.
+ * Tworzy, jeśli jeszcze nie istnieją, bitmapy pól pierwszej i ostatniej
+ * kolumny planszy.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli bitmapy istnieją, @p false, jeśli nie udało
+ * się zaalokować pamięci.
+ */
+static bool columns(gamma_t* g) {
+  struct bitboards* b = &((*g).boards);
+  if ((*b).first_column != NULL) return true;
+  
+  uint64_t* first = calloc(words_count(g), sizeof(uint64_t));
+  uint64_t* last = calloc(words_count(g), sizeof(uint64_t));
+  if (first == NULL || last == NULL) {
+    free(first);
+    free(last);
+    return false;
+  }
+  
+  for (uint32_t y = 0; y < (*g).info.height; y++) {
+    uint64_t id = (uint64_t)y * (uint64_t)(*g).info.width;
+    first[id >> 6] |= (uint64_t)1 << (id & 63);
+    id += (*g).info.width - 1;
+    last[id >> 6] |= (uint64_t)1 << (id & 63);
+  }
+  (*b).first_column = first;
+  (*b).last_column = last;
+  return true;
+}
+
+/** @brief Podaje słowo przesuniętej bitmapy.
+ * Podaje słowo numer @p k bitmapy @p in przesuniętej o @p shift bitów
+ * w stronę wyższych indeksów (lub niższych, jeśli @p shift jest ujemne).
+ * @param[in] in      – bitmapa,
+ * @param[in] words   – liczba słów bitmapy,
+ * @param[in] k       – numer słowa,
+ * @param[in] shift   – przesunięcie.
+ * @return Słowo przesuniętej bitmapy.
+ */
+static uint64_t shifted_word(const uint64_t* in, uint64_t words, 
+                             uint64_t k, int64_t shift) {
+  if (shift >= 0) {
+    uint64_t q = (uint64_t)shift >> 6, r = (uint64_t)shift & 63;
+    if (k < q) return 0;
+    uint64_t v = in[k - q] << r;
+    if (r != 0 && k > q) v |= in[k - q - 1] >> (64 - r);
+    return v;
+  }
+  uint64_t q = (uint64_t)(-shift) >> 6, r = (uint64_t)(-shift) & 63;
+  if (k + q >= words) return 0;
+  uint64_t v = in[k + q] >> r;
+  if (r != 0 && k + q + 1 < words) v |= in[k + q + 1] << (64 - r);
+  return v;
+}
+
+/** @brief Podaje słowo bitmapy sąsiadów.
+ * Podaje słowo numer @p k bitmapy pól sąsiadujących z polami bitmapy @p in.
+ * Sąsiedzi z lewej i prawej strony powstają z przesunięcia o jeden bit,
+ * z pominięciem pól, które przeszłyby do innego wiersza, a sąsiedzi z góry
+ * i z dołu z przesunięcia o szerokość planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ *                      z utworzonymi bitmapami skrajnych kolumn,
+ * @param[in] in      – bitmapa,
+ * @param[in] k       – numer słowa.
+ * @return Słowo bitmapy sąsiadów.
+ */
+static uint64_t neighbours_word(gamma_t* g, const uint64_t* in, uint64_t k) {
+  uint64_t words = words_count(g);
+  int64_t width = (int64_t)(*g).info.width;
+  return (shifted_word(in, words, k, 1) & ~(*g).boards.first_column[k])
+         | (shifted_word(in, words, k, -1) & ~(*g).boards.last_column[k])
+         | shifted_word(in, words, k, width)
+         | shifted_word(in, words, k, -width);
+}
+
+/** @brief Sprawdza, czy złoty ruch na zajęte pole jest legalny.
+ * Zakłada, że gracz @p player nie wykonał jeszcze złotego ruchu, pole
+ * (@p x, @p y) jest zajęte przez innego gracza i gracz @p player może je
+ * zająć, nie przekraczając swojej liczby obszarów. Jeśli usunięcie pionka nie
+ * może zwiększyć liczby obszarów poprzedniego gracza ponad maksymalną,
+ * odpowiada od razu; w przeciwnym wypadku wykonuje próbny ruch.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli ruch jest legalny, a @p false w przeciwnym
+ * wypadku.
+ */
+static bool golden_legal(gamma_t* g, uint32_t player, uint32_t x, uint32_t y) {
+  uint32_t prev_player = owner(g, x, y);
+  uint64_t parts = 0; // Górne ograniczenie liczby części obszaru.
+  if (x > 0 && owner(g, x - 1, y) == prev_player) parts++;
+  if (x < (*g).info.width - 1 && owner(g, x + 1, y) == prev_player) parts++;
+  if (y > 0 && owner(g, x, y - 1) == prev_player) parts++;
+  if (y < (*g).info.height - 1 && owner(g, x, y + 1) == prev_player) parts++;
+  
+  if ((uint64_t)(*g).areas_of_player[prev_player] + parts <= 
+      (uint64_t)(*g).areas + 1) {
+    return true;
+  }
+  return golden_trial(g, player, x, y);
+}
+
+/** @brief Wypełnia bitmapę legalnych ruchów, przeglądając planszę.
+ * Wersja funkcji @ref gamma_legal_moves i @ref gamma_legal_golden_moves
+ * niewymagająca alokowania pamięci, używana, gdy nie udało się utworzyć
+ * bitmap pól.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] bitmap – bitmapa do wypełnienia,
+ * @param[in] b       – wartość @p true dla złotych ruchów, @p false dla
+ *                      zwykłych.
+ * @return Liczba legalnych ruchów.
+ */
+static uint64_t legal_scan(gamma_t* g, uint32_t player, 
+                           uint64_t* bitmap, bool b) {
+  uint64_t count = 0;
+  bool any = (*g).areas_of_player[player] < (*g).areas;
+  memset(bitmap, 0, sizeof(uint64_t) * words_count(g));
+  
+  for (uint32_t y = 0; y < (*g).info.height; y++) {
+    for (uint32_t x = 0; x < (*g).info.width; x++) {
+      uint32_t p = owner(g, x, y);
+      bool legal;
+      if (b == false) {
+        legal = p == 0 && (any == true || neighbour(g, player, x, y) == true);
+      }
+      else {
+        legal = p != 0 && p != player 
+                && (any == true || neighbour(g, player, x, y) == true)
+                && golden_legal(g, player, x, y) == true;
+      }
+      if (legal == true) {
+        uint64_t id = (uint64_t)y * (uint64_t)(*g).info.width + x;
+        bitmap[id >> 6] |= (uint64_t)1 << (id & 63);
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+uint64_t gamma_bitmap_words(gamma_t *g) {
+  if (g == NULL) return 0;
+  return words_count(g);
+}
+
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player, uint64_t *bitmap) {
+  if (g == NULL || bitmap == NULL) return 0;
+  STATS_CALL(g, gamma_api_legal_moves);
+  if (player <= 0 || player > (*g).info.players) return 0;
+  
+  // Gracz może zająć każde wolne pole lub tylko wolnych sąsiadów.
+  bool any = (*g).areas_of_player[player] < (*g).areas;
+  uint64_t* free_board = board_of(g, 0);
+  uint64_t* mine = any ? NULL : board_of(g, player);
+  if (free_board == NULL || (any == false && (mine == NULL || columns(g) == false)))
+    return legal_scan(g, player, bitmap, false);
+  
+  uint64_t count = 0;
+  uint64_t words = words_count(g);
+  for (uint64_t k = 0; k < words; k++) {
+    uint64_t v = free_board[k];
+    if (any == false) v &= neighbours_word(g, mine, k);
+    bitmap[k] = v;
+    count += (uint64_t)__builtin_popcountll(v);
+  }
+  return count;
+}
+
+uint64_t gamma_legal_golden_moves(gamma_t *g, uint32_t player, uint64_t *bitmap) {
+  if (g == NULL || bitmap == NULL) return 0;
+  STATS_CALL(g, gamma_api_legal_golden_moves);
+  if (player <= 0 || player > (*g).info.players) return 0;
+  
+  uint64_t words = words_count(g);
+  if ((*g).golden_move[player] == true) {
+    memset(bitmap, 0, sizeof(uint64_t) * words);
+    return 0;
+  }
+  
+  bool any = (*g).areas_of_player[player] < (*g).areas;
+  uint64_t* free_board = board_of(g, 0);
+  uint64_t* mine = board_of(g, player);
+  if (free_board == NULL || mine == NULL || (any == false && columns(g) == false))
+    return legal_scan(g, player, bitmap, true);
+  
+  uint64_t cells = (uint64_t)(*g).info.width * (uint64_t)(*g).info.height;
+  uint64_t count = 0;
+  for (uint64_t k = 0; k < words; k++) {
+    // Pola innych graczy.
+    uint64_t v = ~(free_board[k] | mine[k]);
+    if (k == words - 1 && (cells & 63) != 0) 
+      v &= ((uint64_t)1 << (cells & 63)) - 1;
+    if (any == false) v &= neighbours_word(g, mine, k);
+    
+    // Sprawdzam, czy usunięcie pionka nie rozspójni za bardzo obszaru.
+    uint64_t candidates = v;
+    while (candidates != 0) {
+      uint64_t id = (k << 6) + (uint64_t)__builtin_ctzll(candidates);
+      candidates &= candidates - 1;
+      uint32_t x = (uint32_t)(id % (*g).info.width);
+      uint32_t y = (uint32_t)(id / (*g).info.width);
+      if (golden_legal(g, player, x, y) == false)
+        v &= ~((uint64_t)1 << (id & 63));
+    }
+    bitmap[k] = v;
+    count += (uint64_t)__builtin_popcountll(v);
+  }
+  return count;
+}
+
+/** @brief Zwraca indeks reprezentanta bez skracania ścieżek.
+ * Wersja funkcji @ref find, która nie zmienia stanu gry, używana przez
+ * zapytania, aby nie dopisywały zmian do dziennika ruchów.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – indeks pola.
+ * @return Indeks pola będącego reprezentantem obszaru.
+ */
+static uint64_t root_of(gamma_t* g, uint64_t id) {
+  while ((*cell(g, id)).rep != id) id = (*cell(g, id)).rep;
+  return id;
+}
+
+/** @brief Podaje rozmiary obszaru zawierającego pole.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Wskaźnik na rozmiary obszaru lub @p NULL, jeśli pole jest wolne
+ * lub parametry są niepoprawne.
+ */
+static struct region* region_root(gamma_t* g, uint32_t x, uint32_t y) {
+  if (g == NULL || x >= (*g).info.width || y >= (*g).info.height) return NULL;
+  if (owner(g, x, y) == 0) return NULL;
+  return region(g, root_of(g, cell_id(g, x, y)));
+}
+
+uint64_t gamma_region_of(gamma_t *g, uint32_t x, uint32_t y) {
+  if (g == NULL || x >= (*g).info.width || y >= (*g).info.height) return 0;
+  if (owner(g, x, y) == 0) return 0;
+  return root_of(g, cell_id(g, x, y)) + 1;
+}
+
+uint64_t gamma_region_size(gamma_t *g, uint32_t x, uint32_t y) {
+  struct region* root = region_root(g, x, y);
+  return root != NULL ? (*root).size : 0;
+}
+
+uint64_t gamma_region_boundary(gamma_t *g, uint32_t x, uint32_t y) {
+  struct region* root = region_root(g, x, y);
+  return root != NULL ? (*root).boundary : 0;
+}
+
+uint32_t gamma_region_count(gamma_t *g, uint32_t player) {
+  if (g == NULL || player > (*g).info.players || player <= 0) return 0;
+  return (*g).areas_of_player[player];
+}
+
+uint64_t gamma_largest_region(gamma_t *g, uint32_t player) {
+  if (g == NULL || player > (*g).info.players || player <= 0) return 0;
+  return (*g).largest_region[player];
+}
+
+/** @brief Podaje liczbę pól gracza w kafelku.
+ * @param[in] t       – wskaźnik na kafelek,
+ * @param[in] player  – numer gracza lub @p 0 dla wolnych pól,
+ * @param[out] count  – wskaźnik na liczbę pól gracza @p player w kafelku.
+ * @return Wartość @p true, jeśli liczba pól jest znana, a @p false, jeśli
+ * gracz nie jest liczony w kafelku i trzeba przejrzeć jego pola.
+ */
+static bool tile_fields(struct tile* t, uint32_t player, uint64_t* count) {
+  for (uint32_t i = 0; i < (*t).owners_count; i++) {
+    if ((*t).owners[i] == player) {
+      *count = (*t).counts[i];
+      return true;
+    }
+  }
+  *count = 0;
+  return (*t).uncounted == 0;
+}
+
+uint64_t gamma_count_in_rect(gamma_t *g, uint32_t player, uint32_t x,
+                             uint32_t y, uint32_t width, uint32_t height) {
+  if (g == NULL || player > (*g).info.players) return 0;
+  if ((uint64_t)x + width > (*g).info.width
+      || (uint64_t)y + height > (*g).info.height)
+    return 0;
+  if (width == 0 || height == 0) return 0;
+  
+  struct layout* l = &((*g).layout);
+  uint32_t x_end = x + width, y_end = y + height;
+  uint64_t count = 0;
+  
+  for (uint32_t ty = y >> (*l).height_bits; 
+       ty <= (y_end - 1) >> (*l).height_bits; ty++) {
+    for (uint32_t tx = x >> (*l).width_bits; 
+         tx <= (x_end - 1) >> (*l).width_bits; tx++) {
+      // Część prostokąta leżąca w kafelku.
+      uint64_t left = (uint64_t)tx << (*l).width_bits;
+      uint64_t right = left + ((uint64_t)1 << (*l).width_bits);
+      uint64_t bottom = (uint64_t)ty << (*l).height_bits;
+      uint64_t top = bottom + ((uint64_t)1 << (*l).height_bits);
+      
+      uint64_t fields;
+      if (left >= x && right <= x_end && bottom >= y && top <= y_end
+          && tile_fields((*g).tiles[(uint64_t)ty * (*l).tiles_in_row + tx],
+                         player, &fields) == true) {
+        // Cały kafelek leży w prostokącie.
+        count += fields;
+        continue;
+      }
+      
+      uint32_t x0 = left > x ? (uint32_t)left : x;
+      uint32_t x1 = right < x_end ? (uint32_t)right : x_end;
+      uint32_t y0 = bottom > y ? (uint32_t)bottom : y;
+      uint32_t y1 = top < y_end ? (uint32_t)top : y_end;
+      for (uint32_t j = y0; j < y1; j++) {
+        for (uint32_t i = x0; i < x1; i++) {
+          if (owner(g, i, j) == player) count++;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * Napis rozpoczynający zapis stanu gry.
+ */
+#define SAVE_MAGIC "GAMMASV1"
+
+/**
+ * Wersja formatu zapisu stanu gry.
+ */
+#define SAVE_VERSION 3
+
+/** @brief Nagłówek zapisu stanu gry.
+ * Po nagłówku zapisane są kolejno tablice graczy: liczby obszarów, liczby
+ * pól, liczby wolnych sąsiadów, rozmiary największych obszarów i informacje
+ * o złotych ruchach, każda o @p players + 1 elementach. Od przesunięcia
+ * @p board_offset, będącego wielokrotnością rozmiaru strony, zapisane są
+ * kolejne kafelki planszy. Liczby są zapisywane w kolejności bajtów
+ * komputera, więc zapis można wczytać tylko programem skompilowanym tak samo.
+ */
+struct save_header {
+  char magic[8]; ///<napis @ref SAVE_MAGIC
+  uint32_t version; ///<wersja formatu, @ref SAVE_VERSION
+  uint32_t tile_size; ///<rozmiar kafelka w bajtach
+  uint32_t tile_bits; ///<wartość @ref TILE_BITS
+  uint32_t width; ///<szerokość planszy
+  uint32_t height; ///<wysokość planszy
+  uint32_t players; ///<liczba graczy
+  uint32_t areas; ///<maksymalna liczba obszarów jednego gracza
+  uint32_t reserved; ///<zero
+  uint64_t free_fields; ///<liczba wolnych pól na planszy
+  uint64_t hash; ///<skrót stanu gry
+  uint64_t tiles_count; ///<liczba kafelków
+  uint64_t board_offset; ///<przesunięcie kafelków względem początku zapisu
+  uint64_t board_checksum; ///<suma kontrolna kafelków
+  uint64_t checksum;
+  ///<suma kontrolna nagłówka (z zerem w tym polu) i tablic graczy
+};
+
+/** @brief Dolicza dane do sumy kontrolnej.
+ * Suma w stylu FNV-1a liczona słowami 64-bitowymi.
+ * @param[in] sum     – dotychczasowa suma kontrolna,
+ * @param[in] data    – wskaźnik na dane,
+ * @param[in] size    – rozmiar danych w bajtach.
+ * @return Suma kontrolna uwzględniająca dane.
+ */
+static uint64_t checksum(uint64_t sum, const void* data, size_t size) {
+  const unsigned char* bytes = data;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, 8);
+    sum = (sum ^ word) * 0x100000001b3ULL;
+  }
+  for (; i < size; i++) sum = (sum ^ bytes[i]) * 0x100000001b3ULL;
+  return sum;
+}
+
+/** @brief Zapisuje dane do pliku.
+ * @param[in] fd      – deskryptor pliku,
+ * @param[in] data    – wskaźnik na dane,
+ * @param[in] size    – rozmiar danych w bajtach.
+ * @return Wartość @p true, jeśli zapisano wszystkie dane, a @p false, jeśli
+ * wystąpił błąd.
+ */
+static bool write_all(int fd, const void* data, size_t size) {
+  const char* bytes = data;
+  while (size > 0) {
+    ssize_t n = write(fd, bytes, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    bytes += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+/** @brief Wczytuje dane z pliku.
+ * @param[in] fd      – deskryptor pliku,
+ * @param[out] data   – wskaźnik na bufor na dane,
+ * @param[in] size    – rozmiar danych w bajtach.
+ * @return Wartość @p true, jeśli wczytano wszystkie dane, a @p false, jeśli
+ * wystąpił błąd lub plik się skończył.
+ */
+static bool read_all(int fd, void* data, size_t size) {
+  char* bytes = data;
+  while (size > 0) {
+    ssize_t n = read(fd, bytes, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    bytes += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+/** @brief Podaje rozmiar strony pamięci.
+ * @return Rozmiar strony w bajtach.
+ */
+static uint64_t page_size() {
+  long size = sysconf(_SC_PAGESIZE);
+  return size > 0 ? (uint64_t)size : 4096;
+}
+
+/** @brief Podaje tablice graczy.
+ * Wypełnia tablice wskaźników na tablice graczy i ich rozmiarów w kolejności,
+ * w jakiej są zapisywane.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] arrays – tablica pięciu wskaźników na tablice graczy,
+ * @param[out] sizes  – tablica pięciu rozmiarów tablic w bajtach.
+ */
+static void player_arrays(gamma_t* g, void* arrays[5], size_t sizes[5]) {
+  size_t n = (size_t)(*g).info.players + 1;
+  arrays[0] = (*g).areas_of_player;
+  sizes[0] = sizeof(uint32_t) * n;
+  arrays[1] = (*g).fields_of_player;
+  sizes[1] = sizeof(uint64_t) * n;
+  arrays[2] = (*g).neighbours_of_player;
+  sizes[2] = sizeof(uint64_t) * n;
+  arrays[3] = (*g).largest_region;
+  sizes[3] = sizeof(uint64_t) * n;
+  arrays[4] = (*g).golden_move;
+  sizes[4] = sizeof(bool) * n;
+}
+
+bool gamma_save(gamma_t *g, int fd) {
+  if (g == NULL || fd < 0) return false;
   
-  (*new).areas_of_player = (uint32_t*) malloc(sizeof(uint32_t) * (players + 1));
+  void* arrays[5];
+  size_t sizes[5];
+  player_arrays(g, arrays, sizes);
   
-  if ((*new).areas_of_player == NULL) {
-    for (uint32_t i = 0; i < height; i++) {
-      free((*new).tab[i]);
-    }
-    free((*new).tab);
-    free(new);
-    return NULL;
-  }
+  struct save_header h = {0};
+  memcpy(h.magic, SAVE_MAGIC, sizeof(h.magic));
+  h.version = SAVE_VERSION;
+  h.tile_size = sizeof(struct tile);
+  h.tile_bits = TILE_BITS;
+  h.width = (*g).info.width;
+  h.height = (*g).info.height;
+  h.players = (*g).info.players;
+  h.areas = (*g).areas;
+  h.free_fields = (*g).free_fields;
+  h.hash = (*g).hash;
+  h.tiles_count = (*g).tiles_count;
   
-  (*new).fields_of_player = (uint64_t*) malloc(sizeof(uint64_t) * (players + 1));
+  uint64_t offset = sizeof(h);
+  for (int i = 0; i < 5; i++) offset += sizes[i];
+  uint64_t page = page_size();
+  h.board_offset = (offset + page - 1) / page * page;
   
-  if ((*new).fields_of_player == NULL) {
-    for (uint32_t i = 0; i < height; i++) {
-      free((*new).tab[i]);
-    }
-    free((*new).tab);
-    free((*new).areas_of_player);
-    free(new);
-    return NULL;
+  // Kafelki są zapisywane z licznikiem gier równym 1, bo wczytana gra ma
+  // je na wyłączność.
+  struct tile* copy = malloc(sizeof(struct tile));
+  if (copy == NULL) return false;
+  advise(g, POSIX_MADV_SEQUENTIAL);
+  uint64_t board_sum = 0xcbf29ce484222325ULL;
+  for (uint64_t i = 0; i < (*g).tiles_count; i++) {
+    memcpy(copy, (*g).tiles[i], sizeof(struct tile));
+    atomic_init(&((*copy).refs), 1);
+    board_sum = checksum(board_sum, copy, sizeof(struct tile));
   }
+  h.board_checksum = board_sum;
   
-  (*new).neighbours_of_player = (uint64_t*) malloc(sizeof(uint64_t) * (players + 1));
-  
-  if ((*new).neighbours_of_player == NULL) {
-    for (uint32_t i = 0; i < height; i++) {
-      free((*new).tab[i]);
-    }
-    free((*new).tab);
-    free((*new).areas_of_player);
-    free((*new).fields_of_player);
-    free(new);
-    return NULL;
-  }
+  h.checksum = checksum(0xcbf29ce484222325ULL, &h, sizeof(h));
+  for (int i = 0; i < 5; i++) 
+    h.checksum = checksum(h.checksum, arrays[i], sizes[i]);
   
-  (*new).golden_move = (bool*) malloc(sizeof(bool) * (players + 1));
+  bool result = write_all(fd, &h, sizeof(h));
+  for (int i = 0; i < 5 && result == true; i++) 
+    result = write_all(fd, arrays[i], sizes[i]);
   
-  if ((*new).golden_move == NULL) {
-    for (uint32_t i = 0; i < height; i++) {
-      free((*new).tab[i]);
-    }
-    free((*new).tab);
-    free((*new).areas_of_player);
-    free((*new).fields_of_player);
-    free((*new).neighbours_of_player);
-    free(new);
-    return NULL;
+  char zeros[64] = {0};
+  while (result == true && offset < h.board_offset) {
+    uint64_t n = h.board_offset - offset < sizeof(zeros) 
+                 ? h.board_offset - offset : sizeof(zeros);
+    result = write_all(fd, zeros, n);
+    offset += n;
   }
   
-  for (uint32_t i = 0; i <= players; i++) {
-    (*new).areas_of_player[i] = 0;
-    (*new).fields_of_player[i] = 0;
-    (*new).neighbours_of_player[i] = 0;
-    (*new).golden_move[i] = false;
+  for (uint64_t i = 0; i < (*g).tiles_count && result == true; i++) {
+    memcpy(copy, (*g).tiles[i], sizeof(struct tile));
+    atomic_init(&((*copy).refs), 1);
+    result = write_all(fd, copy, sizeof(struct tile));
   }
-  
-  (*new).free_fields = (uint64_t)(width) * (uint64_t)(height);
-  (*new).height = height;
-  (*new).width = width;
-  (*new).players = players;
-  (*new).areas = areas;
-  
-  if (players <= 9) (*new).width_of_field = 1;
-  else (*new).width_of_field = number_of_characters(players) + 1;
-  
-  return new;
+  advise(g, POSIX_MADV_RANDOM);
+  free(copy);
+  return result;
 }
 
-/** @brief Sprawdza czy pole sąsiaduje z polem gracza.
- * Sprawdza czy w grze wskazywanej przez @p g pole (@p x, @p y)
- * sąsiaduje z jakimś polem gracza @p player.
- * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new.
- * @return Wartość @p true, jeśli tak, @p false w przeciwnym wypadku.
+/** @brief Sprawdza nagłówek zapisu stanu gry.
+ * @param[in] h       – wskaźnik na nagłówek.
+ * @return Wartość @p true, jeśli nagłówek opisuje zapis, który można wczytać,
+ * a @p false w przeciwnym przypadku.
  */
-static bool neighbour(gamma_t g, uint32_t player, uint32_t x, uint32_t y) {
-  if (x > 0 && g.tab[y][x - 1].player == player) return true;
-  if (x < g.width - 1 && g.tab[y][x + 1].player == player) return true;
-  if (y > 0 && g.tab[y - 1][x].player == player) return true;
-  if (y < g.height - 1 && g.tab[y + 1][x].player == player) return true;
-  return false;
+static bool header_valid(struct save_header* h) {
+  if (memcmp((*h).magic, SAVE_MAGIC, sizeof((*h).magic)) != 0) return false;
+  if ((*h).version != SAVE_VERSION || (*h).tile_size != sizeof(struct tile)
+      || (*h).tile_bits != TILE_BITS) return false;
+  if ((*h).width == 0 || (*h).height == 0 || (*h).players == 0 
+      || (*h).areas == 0) return false;
+  return true;
 }
 
-/** @brief Zwraca adres reprezentanta.
- * Zwraca adres pola będącego reprezentantem obszaru, do którego należy
- * pole wskazywane przez @p x.
- * @param[in] x       – wskaźnik na pole.
- * @return Wskaźnik na pole będące reprezentantem obszaru.
+/** @brief Sprawdza wczytane kafelki planszy.
+ * Sprawdza, czy liczniki kafelków i pola mają poprawne wartości (każdy
+ * kafelek należy tylko do wczytanej gry), wolne pola są takie jak na pustej
+ * planszy, zajęte pola są zaznaczone w bitmapach @p taken, a drzewa obszarów
+ * są acykliczne i każde pole gracza prowadzi do reprezentanta tego samego
+ * gracza, więc funkcja @ref find zawsze się zatrzymuje.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry
+ *                      z wczytanymi kafelkami.
+ * @return Wartość @p true, jeśli kafelki są poprawne, a @p false
+ * w przeciwnym przypadku lub gdy nie udało się zaalokować pamięci.
  */
-static field_t* find(field_t* x) {
-	if ((*x).rep == x) { // Sam jest swoim reprezentantem.
-		return x; // Zwraca adres.
-	}
-	(*x).rep = find((*x).rep);
-	return (*x).rep;
+static bool tiles_valid(gamma_t* g) {
+  uint64_t cells = (*g).tiles_count << TILE_BITS;
+  for (uint64_t i = 0; i < (*g).tiles_count; i++) {
+    struct tile* t = (*g).tiles[i];
+    if (atomic_load(&((*t).refs)) != 1 
+        || (*t).owners_count > TILE_OWNERS) return false;
+    uint64_t counted = (*t).uncounted;
+    for (uint32_t k = 0; k < (*t).owners_count; k++) {
+      if ((*t).owners[k] > (*g).info.players) return false;
+      counted += (*t).counts[k];
+    }
+    if (counted != TILE_CELLS) return false;
+    for (uint64_t j = 0; j < TILE_CELLS; j++) {
+      field_t* f = &((*t).cells[j]);
+      unsigned char visited;
+      memcpy(&visited, &((*f).visited), 1);
+      if ((*f).player > (*g).info.players || (*f).rep >= cells || visited > 1)
+        return false;
+      // Wolne pole musi być takie jak na pustej planszy, bo czyszczenie
+      // kafelków przywraca tylko pola zajęte.
+      if ((*f).player == 0 && ((*f).rep != (i << TILE_BITS) + j || visited != 0
+                               || (*t).regions[j].size != 0 
+                               || (*t).regions[j].boundary != 0))
+        return false;
+      if ((*f).player != 0 && ((*cell(g, (*f).rep)).player != (*f).player
+                               || ((*t).taken[j >> 6] >> (j & 63) & 1) == 0))
+        return false;
+    }
+  }
+  
+  // Przechodzę drzewa obszarów: 1 oznacza pole na bieżącej ścieżce,
+  // a 2 pole, z którego droga do reprezentanta jest już sprawdzona.
+  uint8_t* state = calloc(cells, sizeof(uint8_t));
+  if (state == NULL) return false;
+  bool result = true;
+  for (uint64_t id = 0; id < cells && result == true; id++) {
+    if (state[id] != 0 || (*cell(g, id)).player == 0) continue;
+    uint64_t x = id;
+    while (state[x] == 0 && (*cell(g, x)).rep != x) {
+      state[x] = 1;
+      x = (*cell(g, x)).rep;
+    }
+    result = state[x] != 1;
+    state[x] = 2;
+    for (uint64_t y = id; state[y] == 1; y = (*cell(g, y)).rep) state[y] = 2;
+  }
+  free(state);
+  return result;
 }
 
-/** @brief Łączy dwa obszary.
- * Łączy dwa obszary, do których należą pola wskazywane przez @p a i @p b.
- * Jeśli nie były wcześniej połączone, 
- * zmniejsza o 1 liczbę obszarów należących do gracza @p player.
- * @param[in] a       – wskaźnik na pierwsze pole,
- * @param[in] b       – wskaźnik na drugie pole,
- * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new.
+/** @brief Wczytuje kafelki planszy.
+ * Odwzorowuje kafelki z pliku do pamięci, a jeśli to niemożliwe (na przykład
+ * plik jest potokiem lub jest za krótki), wczytuje je. W obu przypadkach
+ * sprawdza sumę kontrolną i poprawność kafelków. Plik odwzorowanej planszy
+ * nie może być potem skracany.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry
+ *                      z zaalokowaną tablicą kafelków,
+ * @param[in] fd      – deskryptor pliku ustawiony na początku kafelków,
+ * @param[in] start   – położenie kafelków w pliku lub @p -1, jeśli plik nie
+ *                      pozwala zmieniać położenia,
+ * @param[in] h       – wskaźnik na nagłówek zapisu.
+ * @return Wartość @p true, jeśli się udało, a @p false w przeciwnym przypadku.
  */
-static void uni(field_t *a, field_t* b, gamma_t* g, uint32_t player) {
-	field_t* temp_a = find(a);
-  field_t* temp_b = find(b);
+static bool load_tiles(gamma_t* g, int fd, off_t start, struct save_header* h) {
+  size_t length = sizeof(struct tile) * (*h).tiles_count;
+  struct stat st;
   
-  if (temp_a != temp_b) { // Jeśli mają różnych reprezentantów.
-    (*temp_b).rep = temp_a;
-    (*g).areas_of_player[player]--; // Zmniejszam liczbę obszarów.
+  // Odwołanie do strony odwzorowania spoza pliku kończy program sygnałem
+  // SIGBUS, więc odwzorowuję tylko plik zawierający wszystkie kafelki.
+  if (start >= 0 && (uint64_t)start % page_size() == 0 
+      && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) 
+      && (uint64_t)st.st_size >= (uint64_t)start + length) {
+    void* address = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fd, start);
+    struct block* b = malloc(sizeof(struct block));
+    if (address != MAP_FAILED && b != NULL 
+        && lseek(fd, start + (off_t)length, SEEK_SET) >= 0) {
+      atomic_init(&((*b).refs), 1);
+      (*b).address = address;
+      (*b).length = length;
+      (*b).file = true;
+      (*g).block = b;
+      advise(g, POSIX_MADV_SEQUENTIAL);
+      uint64_t sum = checksum(0xcbf29ce484222325ULL, address, length);
+      use_block(g, (*h).tiles_count);
+      bool result = sum == (*h).board_checksum && tiles_valid(g);
+      advise(g, POSIX_MADV_RANDOM);
+      // Niepoprawnych kafelków nie wolno zwalniać, zwalniam tylko blok.
+      if (result == false) (*g).tiles_count = 0;
+      return result;
+    }
+    if (address != MAP_FAILED) munmap(address, length);
+    free(b);
   }
+  
+  // Wczytuję kafelki do bloku w pamięci.
+  (*g).block = block_new((*h).tiles_count);
+  if ((*g).block == NULL 
+      || read_all(fd, (*(*g).block).address, length) == false) return false;
+  uint64_t sum = checksum(0xcbf29ce484222325ULL, (*(*g).block).address, 
+                          length);
+  if (sum != (*h).board_checksum) return false;
+  use_block(g, (*h).tiles_count);
+  if (tiles_valid(g) == true) return true;
+  (*g).tiles_count = 0;
+  return false;
 }
 
-/** @brief Łączy pole i jego sąsiadów w jeden obszar.
- * Przypisuje polu (@p x, @p y) numer gracza @p player.
- * Aktualizuje liczbę obszarów i pól zajętych przez gracza @p player.
- * Łączy obszary, w których leżą należące do gracza @p player
- * pola sąsiadujące z polem (@p x, @p y) i obszar pola (@p x, @p y).
- * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new.
+/** @brief Zlicza obszary graczy według rozmiaru.
+ * Wypełnia pustą tablicę rozmiarów obszarów na podstawie reprezentantów
+ * obszarów na wczytanej planszy.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry
+ *                      z poprawnymi kafelkami.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
  */
-static void uni_neighbours(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-  (*g).areas_of_player[player]++; // Dodaję nowy.
-  (*g).fields_of_player[player]++;
-  (*g).tab[y][x].player = player;
-  
-  if (x > 0 && (*g).tab[y][x - 1].player == player) {
-    uni(&((*g).tab[y][x - 1]), &((*g).tab[y][x]), g, player);
-  }
-  if (x < (*g).width - 1 && (*g).tab[y][x+1].player == player) {
-    uni(&((*g).tab[y][x + 1]), &((*g).tab[y][x]), g, player);
-  }
-  if (y > 0 && (*g).tab[y - 1][x].player == player) {
-    uni(&((*g).tab[y - 1][x]), &((*g).tab[y][x]), g, player);
-  }
-  if (y < (*g).height - 1 && (*g).tab[y + 1][x].player == player) {
-    uni(&((*g).tab[y + 1][x]), &((*g).tab[y][x]), g, player);
+static bool count_sizes(gamma_t* g) {
+  uint64_t cells = (*g).tiles_count << TILE_BITS;
+  for (uint64_t id = 0; id < cells; id++) {
+    field_t* f = cell(g, id);
+    if ((*f).player == 0 || (*f).rep != id) continue;
+    if (sizes_reserve(g, 1) == false) return false;
+    struct size_count* e = size_slot((*g).sizes, (*f).player, 
+                                     (*region(g, id)).size);
+    if ((*e).player == 0) {
+      *e = (struct size_count){(*region(g, id)).size, (*f).player, 0};
+      (*(*g).sizes).used++;
+    }
+    (*e).count++;
   }
+  return true;
 }
 
-/** @brief Liczy wolnych sąsadów pola.
- * Liczy wolne pola sąsiadujące z polem (@p x, @p y), niesąsiadujące z żadnym
- * polem gracza @p player;
- * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new.
- * @return Liczba pól spełniających odpowiednie warunki.
+/** @brief Sprawdza liczniki wczytanej gry.
+ * Porównuje z planszą liczbę wolnych pól oraz liczby pól i obszarów graczy
+ * i rozmiary ich największych obszarów. Sprawdza też, czy pola spoza planszy
+ * są wolne, a rozmiary obszarów gracza sumują się do liczby jego pól.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry
+ *                      z poprawnymi kafelkami.
+ * @return Wartość @p true, jeśli liczniki są zgodne z planszą, a @p false
+ * w przeciwnym przypadku lub gdy nie udało się zaalokować pamięci.
  */
-static uint32_t check_neighbours(gamma_t* g, uint32_t player,
-                                  uint32_t x, uint32_t y) {
-  uint32_t count = 0;
-  // Jeśli sąsiad jest wolny i nie sąsiaduje z żadnym innym moim.
-  if (x > 0 && (*g).tab[y][x - 1].player == 0) { 
-    if (neighbour(*g, player, x - 1, y) == false) count++;
+static bool counters_valid(gamma_t* g) {
+  uint64_t n = (uint64_t)(*g).info.players + 1;
+  uint64_t* fields = calloc(4 * n, sizeof(uint64_t));
+  if (fields == NULL) return false;
+  uint64_t* areas = fields + n;
+  uint64_t* total = fields + 2 * n;
+  uint64_t* largest = fields + 3 * n;
+  struct layout* l = &((*g).layout);
+  uint64_t cells = (*g).tiles_count << TILE_BITS;
+  bool result = true;
+  for (uint64_t id = 0; id < cells && result == true; id++) {
+    field_t* f = cell(g, id);
+    if ((*f).player == 0) continue;
+    uint64_t t = id >> TILE_BITS;
+    uint64_t x = ((t % (*l).tiles_in_row) << (*l).width_bits)
+                 | (*l).column_of[id & (TILE_CELLS - 1)];
+    uint64_t y = ((t / (*l).tiles_in_row) << (*l).height_bits)
+                 | (*l).row_of[id & (TILE_CELLS - 1)];
+    result = x < (*g).info.width && y < (*g).info.height;
+    fields[(*f).player]++;
+    if ((*f).rep != id) continue;
+    uint64_t size = (*region(g, id)).size;
+    if (size == 0 || size > cells - total[(*f).player]) result = false;
+    areas[(*f).player]++;
+    total[(*f).player] += size;
+    if (size > largest[(*f).player]) largest[(*f).player] = size;
   }
-  if (x < (*g).width - 1 && (*g).tab[y][x + 1].player == 0) {
-    if (neighbour(*g, player, x + 1, y) == false) count++;
+  uint64_t taken = 0;
+  for (uint64_t p = 1; p < n && result == true; p++) {
+    result = fields[p] == (*g).fields_of_player[p] && total[p] == fields[p]
+             && areas[p] == (*g).areas_of_player[p]
+             && largest[p] == (*g).largest_region[p];
+    taken += fields[p];
   }
-  if (y > 0 && (*g).tab[y - 1][x].player == 0) {
-    if (neighbour(*g, player, x, y - 1) == false) count++;
-  }
-  if (y < (*g).height - 1 && (*g).tab[y + 1][x].player == 0) {
-    if (neighbour(*g, player, x, y + 1) == false) count++;
-  }
-  return count;
+  free(fields);
+  return result == true 
+         && (*g).free_fields == (uint64_t)(*g).info.width * (*g).info.height 
+                                - taken;
 }
 
-/** @brief Zmniejsza liczbę wolnych sąsiadów graczy sąsiadujących z polem.
- * Zmniejsza o 1 liczbę wolnych sąsiadów graczy innyh niż @p player, 
- * których pola sąsiadują z polem (@p x, @p y).
- * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new.
- */
-static void change_neighbours(gamma_t* g, uint32_t player,
-                              uint32_t x, uint32_t y) {
-  uint32_t p = 0, q = 0, r = 0;
+gamma_t* gamma_load(int fd) {
+  if (fd < 0) return NULL;
+  off_t start = lseek(fd, 0, SEEK_CUR);
   
-  // Jeśli sąsiad nie jest moim i nie jest zerem.
-  if (x > 0 && (*g).tab[y][x - 1].player != player 
-      && (*g).tab[y][x - 1].player != 0) { 
-    p = (*g).tab[y][x - 1].player;
-    (*g).neighbours_of_player[p]--;
-  }
-  if (x < (*g).width - 1 && (*g).tab[y][x + 1].player != player 
-      && (*g).tab[y][x + 1].player != 0) {
-    if ((*g).tab[y][x + 1].player != p) {
-      q = (*g).tab[y][x + 1].player;
-      (*g).neighbours_of_player[q]--;
+  struct save_header h;
+  if (read_all(fd, &h, sizeof(h)) == false || header_valid(&h) == false) 
+    return NULL;
+  
+  struct layout l;
+  uint64_t tiles_count = layout_init(&l, h.width, h.height, NULL);
+  if (tiles_count != h.tiles_count) return NULL;
+  struct capacity c = {h.players, (uint64_t)h.width + h.height, tiles_count};
+  gamma_t* g = arena_new(&c);
+  if (g == NULL) return NULL;
+  layout_init(&((*g).layout), h.width, h.height, (*g).layout.column_code);
+  (*g).info.width = h.width;
+  (*g).info.height = h.height;
+  (*g).info.players = h.players;
+  (*g).areas = h.areas;
+  (*g).free_fields = h.free_fields;
+  (*g).hash = h.hash;
+  (*g).epoch = 1;
+  for (uint32_t i = 0; i <= h.players; i++) (*g).stuck[i] = 0;
+  if (h.players <= 9) (*g).info.width_of_field = 1;
+  else (*g).info.width_of_field = number_of_characters(h.players) + 1;
+  
+  
+  void* arrays[5];
+  size_t sizes[5];
+  player_arrays(g, arrays, sizes);
+  uint64_t offset = sizeof(h);
+  uint64_t expected = h.checksum;
+  h.checksum = 0;
+  uint64_t sum = checksum(0xcbf29ce484222325ULL, &h, sizeof(h));
+  for (int i = 0; i < 5; i++) {
+    if (read_all(fd, arrays[i], sizes[i]) == false) {
+      gamma_delete(g);
+      return NULL;
     }
+    sum = checksum(sum, arrays[i], sizes[i]);
+    offset += sizes[i];
   }
-  if (y > 0 && (*g).tab[y - 1][x].player != player 
-      && (*g).tab[y - 1][x].player != 0) {
-    if ((*g).tab[y - 1][x].player != p && (*g).tab[y - 1][x].player != q) {
-      r = (*g).tab[y - 1][x].player;
-      (*g).neighbours_of_player[r]--;
-    }
+  // Informacje o złotych ruchach muszą być poprawnymi wartościami logicznymi.
+  bool valid = sum == expected && offset <= h.board_offset;
+  for (uint32_t i = 0; i <= h.players && valid == true; i++) {
+    unsigned char golden;
+    memcpy(&golden, &((*g).golden_move[i]), 1);
+    valid = golden <= 1 && (*g).areas_of_player[i] <= h.areas;
+  }
+  if (valid == false) {
+    gamma_delete(g);
+    return NULL;
   }
-  if (y < (*g).height - 1 && (*g).tab[y + 1][x].player != player 
-      && (*g).tab[y + 1][x].player != 0) {
-    if ((*g).tab[y + 1][x].player != p && (*g).tab[y + 1][x].player != q 
-        && (*g).tab[y + 1][x].player != r) {
-      (*g).neighbours_of_player[(*g).tab[y + 1][x].player]--;
+  roster_rebuild(g);
+  
+  // Pomijam wyrównanie do początku kafelków.
+  char skip[64];
+  off_t board = start >= 0 ? start + (off_t)h.board_offset : -1;
+  if (board >= 0 && lseek(fd, board, SEEK_SET) < 0) board = -1;
+  while (board < 0 && offset < h.board_offset) {
+    uint64_t k = h.board_offset - offset < sizeof(skip) 
+                 ? h.board_offset - offset : sizeof(skip);
+    if (read_all(fd, skip, k) == false) {
+      gamma_delete(g);
+      return NULL;
     }
+    offset += k;
   }
-}
-
-bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-  // Czy parametry prawidłowe?
-  if (g == NULL) return false;
-  if (player <= 0 || player > (*g).players) return false;
-  if (x >= (*g).width) return false;
-  if (y >= (*g).height) return false;
-  // Jest tu pionek jakiegoś gracza.
-  if (((*g).tab[y][x]).player != 0) return false; 
-  // Pole nie sąsiaduje z moim polem.
-  if (neighbour(*g, player, x, y) == false) { 
-    // Za dużo obszarów.
-    if ((*g).areas_of_player[player] == (*g).areas) return false; 
-    
-    // Aktualizuję liczbę wolnych sąsiadów gracza.
-    (*g).neighbours_of_player[player] += check_neighbours(g, player, x, y); 
-    change_neighbours(g, player, x, y);
-    
-    (*g).tab[y][x].player = player; // Dodaję nowy obszar.
-    (*g).areas_of_player[player]++;
-    (*g).fields_of_player[player]++;
-    (*g).free_fields--;
-    
-    return true;
+  
+  if (load_tiles(g, fd, board, &h) == false || counters_valid(g) == false 
+      || count_sizes(g) == false) {
+    gamma_delete(g);
+    return NULL;
   }
+  // Każdy wczytany kafelek może mieć zajęte pola.
+  memset((*g).dirty, 0xff, sizeof(uint64_t) * dirty_words(&c));
   
-  else { // Pole sąsiaduje z przynajmniej jednym moim polem.
-    (*g).free_fields--;
-    
-    (*g).neighbours_of_player[player]--; // To pole już nie jest wolnym sąsiadem.
-    // Aktualizuję liczbę wolnych sąsiadów.
-    (*g).neighbours_of_player[player] += check_neighbours(g, player, x, y); 
-    change_neighbours(g, player, x, y);
-    
-    uni_neighbours(g, player, x, y);
-    
-    return true;
+#ifdef GAMMA_STATS
+  (*g).current = gamma_api_move;
+#endif
+  return g;
+}
+
+bool gamma_counter(gamma_t *g, enum gamma_api api, enum gamma_counter counter,
+                   uint64_t *value) {
+  if (value != NULL) *value = 0;
+  if (g == NULL || value == NULL || (unsigned)api >= API_COUNT) return false;
+#ifdef GAMMA_STATS
+  struct counters* c = &((*g).stats[api]);
+  switch (counter) {
+    case gamma_counter_calls:
+      *value = (*c).calls;
+      return true;
+    case gamma_counter_cells_visited:
+      *value = (*c).cells_visited;
+      return true;
+    case gamma_counter_find_hops:
+      *value = (*c).find_hops;
+      return true;
+    case gamma_counter_trial_moves:
+      *value = (*c).trial_moves;
+      return true;
   }
+#else
+  (void)counter;
+#endif
+  return false;
 }
 
-uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
-  if (g == NULL || player > (*g).players || player <= 0) return 0;
-  return (*g).fields_of_player[player];
+const char* gamma_api_name(enum gamma_api api) {
+  static const char* names[API_COUNT] = {
+    "gamma_move", "gamma_golden_move", "gamma_busy_fields",
+    "gamma_free_fields", "gamma_golden_possible", "gamma_board",
+    "gamma_legal_moves", "gamma_legal_golden_moves"
+  };
+  if ((unsigned)api >= API_COUNT) return NULL;
+  return names[api];
 }
 
-uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
-  if (g == NULL || player > (*g).players || player <= 0) return 0;
-  
-  if ((*g).areas_of_player[player] == (*g).areas) 
-    return (*g).neighbours_of_player[player];
-  
-  return (*g).free_fields;
+uint64_t gamma_hash(gamma_t *g) {
+  if (g == NULL) return 0;
+  return (*g).hash;
 }
 
-/** @brief Przechodzi obszar wgłąb.
- * Przechodzi wgłąb należący do gracza @p player obszar zawierający
- * pole (@p x, @p y), zmieniając reprezentanta pól na @p new_rep oraz informację
- * o ich przetworzeniu na @p b.
- * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] new_rep – wskaźnik na pole,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new,
- * @param[in] b       – wartość @p true lub @p false.
- */
-static void dfs(gamma_t* g, field_t* new_rep, 
-                uint32_t player, uint32_t x, uint32_t y, bool b) {
-  
-  (*g).tab[y][x].rep = new_rep; 
-  (*g).tab[y][x].visited = b;
-  
-  if (x > 0 && (*g).tab[y][x - 1].player == player 
-      && (*g).tab[y][x - 1].visited != b) {
-    dfs(g, new_rep, player, x - 1, y, b);
-  }
-  if (x < (*g).width - 1 && (*g).tab[y][x + 1].player == player 
-      && (*g).tab[y][x + 1].visited != b) {
-    dfs(g, new_rep, player, x + 1, y, b);
+bool gamma_journal(gamma_t *g, bool enabled) {
+  if (g == NULL) return false;
+  if (enabled == false) journal_clear(g);
+  (*g).journal.enabled = enabled;
+  return true;
+}
+
+bool gamma_concurrent(gamma_t *g, bool enabled) {
+  if (g == NULL) return false;
+  struct seqlock* l = &((*g).seqlock);
+  if (enabled == (*l).enabled) return true;
+  if (enabled == true) {
+    (*l).row_stamps = malloc(sizeof(atomic_uint_fast64_t) * (*g).info.height);
+    if ((*l).row_stamps == NULL) return false;
+    for (uint32_t y = 0; y < (*g).info.height; y++) 
+      atomic_init(&((*l).row_stamps[y]), 0);
   }
-  if (y > 0 && (*g).tab[y - 1][x].player == player 
-      && (*g).tab[y - 1][x].visited != b) {
-    dfs(g, new_rep, player, x, y - 1, b);
+  else {
+    free((*l).row_stamps);
+    (*l).row_stamps = NULL;
   }
-  if (y < (*g).height - 1 && (*g).tab[y + 1][x].player == player 
-      && (*g).tab[y + 1][x].visited != b) {
-    dfs(g, new_rep, player, x, y + 1, b);
+  (*l).enabled = enabled;
+  return true;
+}
+
+/** @brief Przygotowuje pola do wprowadzenia zmian.
+ * Tworzy prywatne kopie współdzielonych kafelków zawierających pola zmieniane
+ * przez zmiany o indeksach od @p start do @p end - 1 i wstawia do tablicy
+ * rozmiarów obszarów zmieniane pary, tak aby cofnięcie lub powtórzenie zmian
+ * nie wymagało już alokowania pamięci.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] start   – indeks pierwszej zmiany,
+ * @param[in] end     – indeks za ostatnią zmianą.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool prepare_changes(gamma_t* g, uint64_t start, uint64_t end) {
+  if (sizes_reserve(g, end - start) == false) return false;
+  for (uint64_t i = start; i < end; i++) {
+    struct change* c = &((*g).journal.changes[i]);
+    if ((*c).kind == changed_player || (*c).kind == changed_rep
+        || (*c).kind == changed_size || (*c).kind == changed_boundary) {
+      if (writable(g, (*c).cell) == NULL) return false;
+    }
+    if ((*c).kind == changed_count) { // Wstawiam brakujące pary.
+      struct size_count* e = size_slot((*g).sizes, (*c).player, (*c).cell);
+      if ((*e).player == 0) {
+        *e = (struct size_count){(*c).cell, (*c).player, 0};
+        (*(*g).sizes).used++;
+      }
+    }
   }
+  return true;
 }
 
-bool gamma_golden_possible(gamma_t *g, uint32_t player) {
-  if (g == NULL || player > (*g).players || player <= 0) return false;
+bool gamma_undo(gamma_t *g) {
+  if (g == NULL || (*g).journal.done == 0) return false;
+  struct journal* j = &((*g).journal);
   
-  if ((*g).golden_move[player] == false) { // Nie wykonał złotego ruchu.
+  uint64_t start = (*j).moves[(*j).done - 1];
+  uint64_t end = (*j).changes_count;
+  if ((*j).done < (*j).moves_count) end = (*j).moves[(*j).done];
+  if (prepare_changes(g, start, end) == false) return false;
+  (*j).done--;
   
-  // Istnieje jakieś pole należące do innego gracza.
-   if ((*g).free_fields + (*g).fields_of_player[player] < 
-        (uint64_t)(*g).width * (uint64_t)(*g).height) {
-          
-     // Liczba moich obszarów jest mniejsza niż maksymalna.
-     if ((*g).areas_of_player[player] < (*g).areas) {
-       return true;
-     }
-     
-     else { // Liczba moich obszarów jest maksymalna;
-       for (uint32_t y = 0; y < (*g).height; y++) {
-         for (uint32_t x = 0; x < (*g).width; x++) {
-           
-           //Jeśli pole innego gracza sąsiaduje z moim obszarem.
-           if ((*g).tab[y][x].player != 0 && (*g).tab[y][x].player != player
-            && neighbour(*g, player, x, y) == true) {
-             uint32_t prev_player = (*g).tab[y][x].player; // Poprzedni gracz.
-             
-             //Jeśli udało się na nim wykonać złoty ruch.
-             if (gamma_golden_move(g, player, x, y) == true) {
-              // Cofamy jego skutki.
-              bool temp = (*g).golden_move[prev_player];
-              (*g).golden_move[prev_player] = false;
-              gamma_golden_move(g, prev_player, x, y);
-              (*g).golden_move[prev_player] = temp;
-              (*g).golden_move[player] = false;
-              return true;
-             }
-           }
-         }
-       }
-     }
-   }
+  write_begin(g);
+  for (uint64_t i = end; i > start; i--) { // Cofam w odwrotnej kolejności.
+    apply_change(g, &((*j).changes[i - 1]), (*j).changes[i - 1].old_value);
   }
-  return false;
+  write_end(g);
+  history_pop(g);
+  return true;
 }
 
-bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-  // Czy parametry prawidłowe?
-  if (g == NULL) return false;
-  if (player <= 0 || player > (*g).players) return false;
-  if (x >= (*g).width) return false;
-  if (y >= (*g).height) return false;
-  
-  // Gracz wykonał złoty ruch.
-  if ((*g).golden_move[player] == true) return false; 
-  // Ruch nie jest złoty.
-  if ((*g).tab[y][x].player == 0 || (*g).tab[y][x].player == player) return false; 
-  // Za dużo obszarów.
-  if (neighbour(*g, player, x, y) == false 
-      && (*g).areas_of_player[player] == (*g).areas) return false; 
+bool gamma_redo(gamma_t *g) {
+  if (g == NULL || (*g).journal.done == (*g).journal.moves_count) return false;
+  struct journal* j = &((*g).journal);
   
-  uint32_t prev_player = (*g).tab[y][x].player; // Poprzedni gracz.
-  
-  // Tyle wolnych do dodania w przypadku wstawienia.
-  uint32_t to_add = check_neighbours(g, player, x, y); 
-  
-  (*g).tab[y][x].player = player; // Niech pole puste.
-  (*g).tab[y][x].rep = &((*g).tab[y][x]);
-  (*g).fields_of_player[prev_player]--; 
-  // Zmieniam liczbę pól poprzedniego gracza.
-  uint32_t parts = 0;
+  uint64_t start = (*j).moves[(*j).done];
+  uint64_t end = (*j).changes_count;
+  if ((*j).done + 1 < (*j).moves_count) end = (*j).moves[(*j).done + 1];
+  if (prepare_changes(g, start, end) == false) return false;
   
-  if (x > 0 && (*g).tab[y][x - 1].player == prev_player) {
-    parts++;
-    dfs(g, &((*g).tab[y][x - 1]), prev_player, x - 1, y, true);
-  }
-  if (x < (*g).width - 1 && (*g).tab[y][x + 1].player == prev_player
-      && (*g).tab[y][x + 1].visited == false) {
-    parts++;
-    dfs(g, &((*g).tab[y][x + 1]), prev_player, x + 1, y, true);
+  write_begin(g);
+  for (uint64_t i = start; i < end; i++) {
+    apply_change(g, &((*j).changes[i]), (*j).changes[i].new_value);
   }
-  if (y > 0 && (*g).tab[y - 1][x].player == prev_player
-      && (*g).tab[y - 1][x].visited == false) {
-    parts++;
-    dfs(g, &((*g).tab[y - 1][x]), prev_player, x, y - 1, true);
+  write_end(g);
+  (*j).done++;
+  history_redo(g, start, end);
+  return true;
+}
+
+bool gamma_history(gamma_t *g, bool enabled) {
+  if (g == NULL) return false;
+  if (enabled == (*g).history.enabled) return true;
+  if (enabled == false) {
+    history_free(g);
+    return true;
   }
-  if (y < (*g).height - 1 && (*g).tab[y + 1][x].player == prev_player
-      && (*g).tab[y + 1][x].visited == false) {
-    parts++;
-    dfs(g, &((*g).tab[y + 1][x]), prev_player, x, y + 1, true);
+  return history_start(g);
+}
+
+uint64_t gamma_history_length(gamma_t *g) {
+  if (g == NULL) return 0;
+  return (*g).history.moves;
+}
+
+/** @brief Odtwarza stan gry z klatki kluczowej.
+ * Ustawia pionki na pustej planszy gry @p g zgodnie z klatką. Pionki są
+ * stawiane w kolejności wierszy, więc obszar może chwilowo składać się
+ * z kilku części; limit obszarów jest na ten czas wyłączony.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan nowej gry,
+ * @param[in] k       – wskaźnik na klatkę kluczową.
+ */
+static void keyframe_apply(gamma_t* g, struct keyframe* k) {
+  uint32_t areas = (*g).areas;
+  (*g).areas = UINT32_MAX;
+  uint64_t offset = 0;
+  uint32_t x = 0, y = 0;
+  while (y < (*g).info.height) {
+    uint32_t player = (uint32_t)get_varint((*k).data.data, &offset);
+    uint64_t run = get_varint((*k).data.data, &offset);
+    for (uint64_t i = 0; i < run; i++) {
+      if (player != 0) move(g, player, x, y);
+      if (++x == (*g).info.width) {
+        x = 0;
+        y++;
+      }
+    }
   }
+  (*g).areas = areas;
+  roster_rebuild(g);
   
-  // Cofam odwiedzenie pól.
-  if (x > 0 && (*g).tab[y][x - 1].player == prev_player) {
-    dfs(g, &((*g).tab[y][x - 1]), prev_player, x - 1, y, false);
-  }
-  if (x < (*g).width - 1 && (*g).tab[y][x + 1].player == prev_player
-      && (*g).tab[y][x + 1].visited == true) {
-    dfs(g, &((*g).tab[y][x + 1]), prev_player, x + 1, y, false);
-  }
-  if (y > 0 && (*g).tab[y - 1][x].player == prev_player
-      && (*g).tab[y - 1][x].visited == true) {
-    dfs(g, &((*g).tab[y - 1][x]), prev_player, x, y - 1, false);
+  uint32_t player = 0;
+  for (uint64_t d; (d = get_varint((*k).data.data, &offset)) != 0;) {
+    player += (uint32_t)d;
+    set_golden(g, player, true);
   }
-  if (y < (*g).height - 1 && (*g).tab[y + 1][x].player == prev_player
-      && (*g).tab[y + 1][x].visited == true) {
-    dfs(g, &((*g).tab[y + 1][x]), prev_player, x, y + 1, false);
-  }
-  
-  // Zmieniam liczbę obszarów poprzedniego gracza.
-  (*g).areas_of_player[prev_player] += parts; 
-  (*g).areas_of_player[prev_player]--;
+}
+
+gamma_t* gamma_replay(gamma_t *g, uint64_t moves) {
+  if (g == NULL || (*g).history.enabled == false 
+      || moves > (*g).history.moves) return NULL;
+  struct history* h = &((*g).history);
   
-  // Można usunąć bez naruszania zasad.
-  if ((*g).areas_of_player[prev_player] <= (*g).areas) { 
-    // Zmniejszam liczbę wolnych sąsiadów poprzedniego gracza.
-    (*g).neighbours_of_player[prev_player] -= check_neighbours(g, prev_player, x, y); 
-    // Zwiększam liczbę wolnych sąsiadów nowego gracza.
-    (*g).neighbours_of_player[player] += to_add; 
-    uni_neighbours(g, player, x, y); // Wstawiam.
-    (*g).golden_move[player] = true;
-    
-    return true;
+  // Szukam ostatniej klatki sprzed ruchu numer moves.
+  uint64_t low = 0, high = (*h).keyframes_count;
+  while (high - low > 1) {
+    uint64_t middle = low + (high - low) / 2;
+    if ((*h).keyframes[middle].move <= moves) low = middle;
+    else high = middle;
   }
+  struct keyframe* k = &((*h).keyframes[low]);
   
-  else{
-    uni_neighbours(g, prev_player, x, y);
-    return false;
+  gamma_t* new = gamma_new((*g).info.width, (*g).info.height,
+                           (*g).info.players, (*g).areas);
+  if (new == NULL) return NULL;
+  keyframe_apply(new, k);
+  
+  uint64_t offset = (*k).offset;
+  uint32_t player, x = 0, y = 0;
+  for (uint64_t i = (*k).move; i < moves; i++) {
+    bool gold = history_entry((*h).log.data, &offset, &player, &x, &y);
+    bool result = gold == true ? golden(new, player, x, y) 
+                               : move(new, player, x, y);
+    if (result == false) { // Nie udało się zaalokować pamięci.
+      gamma_delete(new);
+      return NULL;
+    }
   }
+  return new;
 }
 
 /** @brief Zwraca cyfrę w formie znaku.
@@ -617,6 +4755,64 @@ static void add_char(char** c, uint64_t* num, uint32_t x, uint32_t width_of_fiel
   }
 }
 
+/** @brief Podaje numer gracza na polu (@p x, @p y) z innego wątku.
+ * Odczytuje pole tak jak funkcja @ref owner, ale atomowo, patrz
+ * @ref SHARED_LOAD. Kafelek lub tablica kafelków mogły zostać właśnie
+ * skopiowane przy zapisie, więc wskaźniki na nie są odczytywane
+ * z synchronizacją z zapisem kopii.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Numer gracza lub @p 0, jeśli pole jest wolne.
+ */
+static uint32_t shared_owner(gamma_t* g, uint32_t x, uint32_t y) {
+  uint64_t id = cell_id(g, x, y);
+  struct tile** tiles = __atomic_load_n(&((*g).tiles), __ATOMIC_ACQUIRE);
+  struct tile* t = __atomic_load_n(&(tiles[id >> TILE_BITS]), 
+                                   __ATOMIC_ACQUIRE);
+  return SHARED_LOAD((*t).cells[id & (TILE_CELLS - 1)].player);
+}
+
+/** @brief Wypisuje planszę, gdy stan gry mogą zmieniać inne wątki.
+ * Wypisuje kolejne wiersze planszy, a potem ponownie te, których znacznik
+ * się zmienił, dopóki w trakcie jednego przejrzenia znaczników nie zmieni
+ * się ani żaden znacznik, ani licznik zmian; napis opisuje wtedy stan planszy
+ * z jednej chwili. Nie dopisuje znaków końca wiersza.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] c      – wskaźnik na napis o długości podanej w funkcji
+ *                      @ref gamma_board,
+ * @param[in] line    – długość jednego wiersza napisu.
+ * @return Wartość @p true, jeśli się udało, @p false, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+static bool board_rows(gamma_t* g, char* c, uint64_t line) {
+  uint64_t* seen = malloc(sizeof(uint64_t) * (*g).info.height);
+  if (seen == NULL) return false;
+  for (uint32_t y = 0; y < (*g).info.height; y++) seen[y] = UINT64_MAX;
+  
+  bool changed;
+  uint64_t s;
+  do {
+    changed = false;
+    s = read_begin(g);
+    for (uint32_t y = 0; y < (*g).info.height; y++) {
+      uint64_t stamp = atomic_load_explicit(&((*g).seqlock.row_stamps[y]),
+                                            memory_order_acquire);
+      if (stamp == seen[y]) continue;
+      changed = true;
+      seen[y] = stamp;
+      uint64_t num = ((*g).info.height - 1 - y) * line;
+      for (uint32_t x = 0; x < (*g).info.width; x++) 
+        add_char(&c, &num, shared_owner(g, x, y), (*g).info.width_of_field);
+    }
+  } while (changed == true || read_retry(g, s) == true);
+  
+  free(seen);
+  return true;
+}
+
 char* gamma_board(gamma_t* g) {
   
   if (g == NULL) return NULL;
@@ -624,45 +4820,55 @@ char* gamma_board(gamma_t* g) {
   uint64_t num = 0;
   
   char* c = (char*) malloc(sizeof(char) * 
-    ((((uint64_t)((*g).width) * (uint64_t)(*g).width_of_field)+ 1)
-    * (uint64_t)((*g).height) + 1));
+    ((((uint64_t)((*g).info.width) * (uint64_t)(*g).info.width_of_field)+ 1)
+    * (uint64_t)((*g).info.height) + 1));
   
   if (c == NULL) return NULL;
   
-  for (uint32_t i = 0; i < (*g).height; i++) {
-    for (uint32_t j = 0; j < (*g).width; j++) {
-      add_char(&c, &num, (*g).tab[(*g).height - 1 - i][j].player,
-      (*g).width_of_field);
+  uint64_t line = (uint64_t)(*g).info.width * (*g).info.width_of_field + 1;
+  if (concurrent(g) == true) { // Odczyt z innego wątku.
+    if (board_rows(g, c, line) == false) {
+      free(c);
+      return NULL;
+    }
+  }
+  else {
+    STATS_CALL(g, gamma_api_board);
+    // Przeglądam pola w kolejności pamięci; każde pole zajmuje w napisie
+    // tyle samo znaków, więc jego miejsce w napisie jest znane.
+    struct layout* l = &((*g).layout);
+    advise(g, POSIX_MADV_SEQUENTIAL);
+    for (uint64_t t = 0; t < (*g).tiles_count; t++) {
+      uint64_t left = (t % (*l).tiles_in_row) << (*l).width_bits;
+      uint64_t bottom = (t / (*l).tiles_in_row) << (*l).height_bits;
+      for (uint64_t k = 0; k < TILE_CELLS; k++) {
+        uint64_t x = left + (*l).column_of[k], y = bottom + (*l).row_of[k];
+        if (x >= (*g).info.width || y >= (*g).info.height) continue;
+        num = ((*g).info.height - 1 - y) * line + x * (*g).info.width_of_field;
+        add_char(&c, &num, (*(*g).tiles[t]).cells[k].player, 
+                 (*g).info.width_of_field);
+      }
     }
-    c[num] = '\n';
-    num++;
+    advise(g, POSIX_MADV_RANDOM);
   }
-  c[num] = 0;
+  for (uint64_t i = 1; i <= (*g).info.height; i++) c[i * line - 1] = '\n';
+  c[(*g).info.height * line] = 0;
   return c;
 }
 
-/** @brief Podaje szerokość pojedynczego pola.
- * Podaje szerokość pojedynczego pola w tekstowym opisie stanu planszy
- * w grze wskazywanej przez @p g.
- * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
- * @return Szerokość pojednyczego pola planszy, liczba dodatnia.
- */
-uint32_t get_width_of_field(gamma_t* g) {
-  return (*g).width_of_field;
-}
-
-uint32_t get_width(gamma_t* g) {
-  return (*g).width;
-}
-
-uint32_t get_height(gamma_t* g) {
-  return (*g).height;
-}
-
-uint32_t get_players(gamma_t* g) {
-  return (*g).players;
+uint32_t player_on_position(gamma_t* g, int x, int y) {
+  return owner(g, x, y);
 }
 
-uint32_t player_on_position(gamma_t* g, int x, int y) {
-  return (*g).tab[y][x].player;
+uint32_t gamma_cells(gamma_t *g, uint32_t x, uint32_t y, uint32_t count,
+                     uint32_t *players) {
+  if (g == NULL || players == NULL || x >= (*g).info.width
+      || y >= (*g).info.height) return 0;
+  if (count > (*g).info.width - x) count = (*g).info.width - x;
+  // Indeks pola jest sumą części kolumny i wiersza; część wiersza jest
+  // wspólna dla wszystkich odczytywanych pól.
+  uint64_t row = (*g).layout.row_code[y];
+  for (uint32_t i = 0; i < count; i++)
+    players[i] = (*cell(g, (*g).layout.column_code[x + i] + row)).player;
+  return count;
 }
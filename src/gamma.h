@@ -18,6 +18,65 @@
  */
 typedef struct gamma gamma_t;
 
+/**
+ * Typ przechowujący pulę gier gotowych do ponownego użycia.
+ */
+typedef struct gamma_pool gamma_pool_t;
+
+/** @brief Parametry gry.
+ * Struktura jest pierwszym polem struktury przechowującej stan gry, więc
+ * wskaźnik na grę wskazuje również na nią. Tylko ta część stanu gry należy
+ * do interfejsu binarnego biblioteki i nie zmienia się między jej wersjami;
+ * dzięki temu funkcje @ref get_width, @ref get_height, @ref get_players
+ * i @ref get_width_of_field są rozwijane w miejscu wywołania. Pozostałe pola
+ * gry są ukryte, a do planszy dają dostęp funkcje @ref player_on_position
+ * i @ref gamma_cells. Pól struktury nie wolno zmieniać.
+ */
+struct gamma_info {
+  uint32_t width; ///<szerokość planszy
+  uint32_t height; ///<wysokość planszy
+  uint32_t players; ///<liczba graczy
+  uint32_t width_of_field;
+  ///<szerokość jednego pola w tekstowej reprezentacji planszy
+};
+
+/** @brief Funkcje interfejsu, dla których zbierane są statystyki.
+ * Typ wyliczeniowy wskazujący funkcję w wywołaniach @ref gamma_counter
+ * i @ref gamma_api_name. Wartości są kolejnymi liczbami od zera, a nowe
+ * funkcje są dopisywane na końcu.
+ */
+enum gamma_api {
+  gamma_api_move, ///<funkcja @ref gamma_move
+  gamma_api_golden_move, ///<funkcja @ref gamma_golden_move
+  gamma_api_busy_fields, ///<funkcja @ref gamma_busy_fields
+  gamma_api_free_fields, ///<funkcja @ref gamma_free_fields
+  gamma_api_golden_possible, ///<funkcja @ref gamma_golden_possible
+  gamma_api_board, ///<funkcja @ref gamma_board
+  gamma_api_legal_moves, ///<funkcja @ref gamma_legal_moves
+  gamma_api_legal_golden_moves ///<funkcja @ref gamma_legal_golden_moves
+};
+
+/** @brief Liczniki zbierane dla każdej funkcji interfejsu.
+ * Typ wyliczeniowy wskazujący licznik w wywołaniach @ref gamma_counter.
+ * Wartości są kolejnymi liczbami od zera, a nowe liczniki są dopisywane na
+ * końcu.
+ */
+enum gamma_counter {
+  gamma_counter_calls, ///<liczba wywołań
+  gamma_counter_cells_visited, ///<liczba pól odwiedzonych w obszarach
+  gamma_counter_find_hops, ///<liczba kroków w górę drzew obszarów
+  gamma_counter_trial_moves ///<liczba próbnych złotych ruchów
+};
+
+/**
+ * Struktura opisująca ruch, patrz @ref gamma_moves.
+ */
+struct gamma_move_args {
+  uint32_t player; ///<numer gracza
+  uint32_t x; ///<numer kolumny
+  uint32_t y; ///<numer wiersza
+};
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -32,6 +91,29 @@ typedef struct gamma gamma_t;
 gamma_t* gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
+/** @brief Tworzy strukturę przechowującą stan gry z planszą w pliku.
+ * Działa jak @ref gamma_new, ale plansza leży w pliku @p fd odwzorowanym
+ * w pamięci, a nie w pamięci programu, więc gra może mieć planszę większą
+ * niż pamięć komputera; dostęp do pól, których nie ma w pamięci podręcznej
+ * systemu, jest wtedy wolniejszy. Plik jest skracany lub wydłużany do
+ * rozmiaru planszy, a jego poprzednia zawartość jest tracona. W czasie gry
+ * plik zawiera bieżącą planszę w wewnętrznym formacie silnika; do zapisu
+ * stanu gry służy funkcja @ref gamma_save. Deskryptor można zamknąć zaraz
+ * po utworzeniu gry.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz, liczba dodatnia,
+ * @param[in] fd      – deskryptor zwykłego pliku otwartego do odczytu
+ *                      i zapisu.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci, odwzorować pliku lub któryś z parametrów jest
+ * niepoprawny.
+ */
+gamma_t* gamma_new_file(uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas, int fd);
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
  * Nic nie robi, jeśli wskaźnik ten ma wartość @p NULL.
@@ -39,6 +121,92 @@ gamma_t* gamma_new(uint32_t width, uint32_t height,
  */
 void gamma_delete(gamma_t *g);
 
+/** @brief Przywraca początkowy stan gry.
+ * Ustawia grę wskazywaną przez @p g tak, jakby została właśnie utworzona
+ * funkcją @ref gamma_new z podanymi parametrami, bez alokowania pamięci,
+ * jeśli plansza nie jest współdzielona z kopią gry. Gra i jej tablice leżą
+ * w jednym bloku pamięci, a kafelki planszy w drugim, więc nowe parametry
+ * nie mogą wymagać większych tablic niż te, z którymi grę utworzono:
+ * liczba graczy, suma szerokości i wysokości oraz liczba kafelków planszy
+ * nie mogą być większe. Plansza utworzona funkcją @ref gamma_new_file
+ * pozostaje w pliku, jeśli się w nim mieści.
+ * @param[in, out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz, liczba dodatnia.
+ * @return Wartość @p true, jeśli stan gry został przywrócony, a @p false,
+ * gdy któryś z parametrów jest niepoprawny, nowa gra się nie mieści lub nie
+ * udało się zaalokować pamięci; stan gry się wtedy nie zmienia.
+ */
+bool gamma_reset(gamma_t *g, uint32_t width, uint32_t height,
+                 uint32_t players, uint32_t areas);
+
+/** @brief Tworzy pulę gier.
+ * Tworzy pulę mieszczącą @p size gier i wypełnia ją grami utworzonymi
+ * funkcją @ref gamma_new z podanymi parametrami. Pula nie jest chroniona
+ * przed jednoczesnym użyciem przez kilka wątków.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz, liczba dodatnia,
+ * @param[in] size    – liczba gier w puli.
+ * @return Wskaźnik na utworzoną pulę lub @p NULL, gdy nie udało się
+ * zaalokować pamięci lub któryś z parametrów jest niepoprawny.
+ */
+gamma_pool_t* gamma_pool_new(uint32_t width, uint32_t height,
+                             uint32_t players, uint32_t areas, uint32_t size);
+
+/** @brief Pobiera grę z puli.
+ * Zwraca grę z puli przywróconą do początkowego stanu funkcją
+ * @ref gamma_reset, a jeśli pula jest pusta lub gra się nie mieści, tworzy
+ * nową grę funkcją @ref gamma_new.
+ * @param[in, out] pool – wskaźnik na pulę gier lub @p NULL,
+ * @param[in] width     – szerokość planszy, liczba dodatnia,
+ * @param[in] height    – wysokość planszy, liczba dodatnia,
+ * @param[in] players   – liczba graczy, liczba dodatnia,
+ * @param[in] areas     – maksymalna liczba obszarów,
+ *                        jakie może zająć jeden gracz, liczba dodatnia.
+ * @return Wskaźnik na grę lub @p NULL, gdy nie udało się zaalokować pamięci
+ * lub któryś z parametrów jest niepoprawny.
+ */
+gamma_t* gamma_pool_get(gamma_pool_t* pool, uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas);
+
+/** @brief Oddaje grę do puli.
+ * Zapamiętuje grę wskazywaną przez @p g w puli do ponownego użycia, a jeśli
+ * pula jest pełna, usuwa ją funkcją @ref gamma_delete. Nic nie robi, jeśli
+ * @p g ma wartość @p NULL.
+ * @param[in, out] pool – wskaźnik na pulę gier lub @p NULL,
+ * @param[in] g         – wskaźnik na strukturę przechowującą stan gry.
+ */
+void gamma_pool_put(gamma_pool_t* pool, gamma_t* g);
+
+/** @brief Usuwa pulę gier.
+ * Usuwa wszystkie gry z puli i samą pulę. Nic nie robi, jeśli wskaźnik
+ * @p pool ma wartość @p NULL.
+ * @param[in] pool    – wskaźnik na pulę gier.
+ */
+void gamma_pool_delete(gamma_pool_t* pool);
+
+/** @brief Tworzy kopię stanu gry.
+ * Tworzy nową strukturę przechowującą ten sam stan gry co @p g. Plansza nie
+ * jest kopiowana: obie gry współdzielą kafelki planszy, a kafelek jest
+ * kopiowany dopiero wtedy, gdy któraś z gier pierwszy raz go zmienia, więc
+ * czas utworzenia kopii nie zależy od rozmiaru planszy. Pierwsza zmiana
+ * planszy po utworzeniu kopii kopiuje tablicę wskaźników na kafelki.
+ * Dopóki kopia istnieje, obie gry zapisują zmiany stanu gry, żeby móc
+ * wycofać ruch, gdy skopiowanie kafelka się nie uda.
+ * Kopia ma wyłączony i pusty dziennik ruchów.
+ * Kopię usuwa się funkcją @ref gamma_delete, niezależnie od oryginału.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub parametr jest niepoprawny.
+ */
+gamma_t* gamma_clone(gamma_t *g);
+
 /** @brief Wykonuje ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y).
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
@@ -49,10 +217,38 @@ void gamma_delete(gamma_t *g);
  * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
  * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
- * gdy ruch jest nielegalny lub któryś z parametrów jest niepoprawny.
+ * gdy ruch jest nielegalny, któryś z parametrów jest niepoprawny lub nie
+ * udało się zaalokować pamięci na kopię współdzielonego kafelka planszy.
  */
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
+/** @brief Wykonuje ciąg ruchów.
+ * Daje takie same wyniki i taki sam stan gry, jak kolejne wywołania funkcji
+ * @ref gamma_move dla ruchów z tablicy @p moves. Jeśli @p threads jest
+ * większe od jednego, ruchy są wykonywane równolegle przez tyle wątków:
+ * ruchy na zajęte pola są od razu odrzucane, a pozostałe są dzielone na fale
+ * tak, że ruchy z jednej fali nie dotykają tych samych kafelków planszy ani
+ * tych samych obszarów i mogą być wykonane w dowolnej kolejności. Ruchy
+ * zależne od siebie trafiają do kolejnych fal w kolejności z tablicy.
+ * Ruchy są wykonywane po kolei, jeśli któryś gracz mógłby w trakcie ciągu
+ * osiągnąć limit obszarów, włączony jest dziennik ruchów, historia ruchów lub
+ * odczyty z innych wątków, plansza może być współdzielona z kopią gry,
+ * istnieją bitmapy pól, silnik skompilowano ze statystykami lub nie udało się
+ * zaalokować pamięci.
+ * Wątki pomocnicze są tworzone przy pierwszym równoległym wykonaniu i żyją
+ * razem z grą.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves   – wskaźnik na tablicę @p count ruchów,
+ * @param[in] count   – liczba ruchów,
+ * @param[out] results – wskaźnik na tablicę @p count wyników, w której pod
+ *                      indeksem @p i zostanie zapisany wynik ruchu @p i,
+ * @param[in] threads – liczba wątków, wartość @p 0 oznacza jeden wątek.
+ * @return Wartość @p true, jeśli ruchy zostały wykonane, a @p false,
+ * gdy któryś z parametrów jest niepoprawny.
+ */
+bool gamma_moves(gamma_t *g, const struct gamma_move_args *moves,
+                 uint64_t count, bool *results, uint32_t threads);
+
 /** @brief Wykonuje złoty ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
  * gracza, usuwając pionek innego gracza.
@@ -64,8 +260,9 @@ bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
  * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
  * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
- * gdy gracz wykorzystał już swój złoty ruch, ruch jest nielegalny
- * lub któryś z parametrów jest niepoprawny.
+ * gdy gracz wykorzystał już swój złoty ruch, ruch jest nielegalny,
+ * któryś z parametrów jest niepoprawny lub nie udało się zaalokować pamięci
+ * na kopię współdzielonego kafelka planszy.
  */
 bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
@@ -105,6 +302,24 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Podaje następnego gracza, który może wykonać ruch.
+ * Szuka gracza, dla którego funkcja @ref gamma_free_fields zwraca liczbę
+ * dodatnią lub funkcja @ref gamma_golden_possible zwraca @p true, wśród graczy
+ * o numerach większych od @p player, a potem od numeru @p 1 do @p player.
+ * Gra utrzymuje zbiór graczy, którzy mają wolne pola lub nie wykonali złotego
+ * ruchu, więc gracze, którzy odpadli z gry, są pomijani bez sprawdzania,
+ * a gracz należący do zbioru jest znajdowany w stałej liczbie kroków. Funkcja
+ * @ref gamma_golden_possible jest wywoływana tylko dla graczy bez wolnych pól,
+ * którzy nie wykonali złotego ruchu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba nieujemna niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new; @p 0 oznacza
+ *                      szukanie od pierwszego gracza.
+ * @return Numer gracza lub @p 0, jeśli żaden gracz nie może wykonać ruchu lub
+ * któryś z parametrów jest niepoprawny.
+ */
+uint32_t gamma_next_player(gamma_t *g, uint32_t player);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Przykład znajduje się w pliku gamma_test.c.
@@ -115,34 +330,346 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player);
  */
 char* gamma_board(gamma_t *g);
 
+/** @brief Podaje skrót stanu gry.
+ * Podaje 64-bitowy skrót (w stylu Zobrista) stanu gry wskazywanej przez
+ * @p g: zawartości planszy i informacji, którzy gracze wykonali już złoty
+ * ruch. Skrót jest aktualizowany w czasie stałym przy każdej zmianie pola,
+ * więc jego odczyt nie wymaga przeglądania planszy. Te same stany gry
+ * mają ten sam skrót niezależnie od kolejności ruchów, które do nich
+ * doprowadziły.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Skrót stanu gry lub zero, jeśli parametr jest niepoprawny.
+ */
+uint64_t gamma_hash(gamma_t *g);
+
+/** @brief Podaje rozmiar bitmapy pól.
+ * Podaje liczbę 64-bitowych słów bitmapy, w której każdemu polu planszy gry
+ * wskazywanej przez @p g odpowiada jeden bit. Polu (@p x, @p y) odpowiada bit
+ * numer @p i = @p y * @p width + @p x, czyli bit @p i % 64 słowa @p i / 64.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba słów bitmapy lub zero, jeśli parametr jest niepoprawny.
+ */
+uint64_t gamma_bitmap_words(gamma_t *g);
+
+/** @brief Wyznacza pola, na których gracz może wykonać ruch.
+ * Zapisuje w bitmapie @p bitmap pola, na których gracz @p player może
+ * w następnym ruchu postawić pionek funkcją @ref gamma_move: wolne pola
+ * sąsiadujące z jego polami, a jeśli nie osiągnął maksymalnej liczby obszarów,
+ * wszystkie wolne pola. Bitmapy pól graczy są tworzone przy pierwszym
+ * wywołaniu i później aktualizowane przy każdym ruchu, a sąsiedztwo jest
+ * wyznaczane przesunięciami całych słów, więc wywołanie kosztuje
+ * O(liczba pól / 64).
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] bitmap – wskaźnik na bitmapę o rozmiarze podanym przez
+ *                      funkcję @ref gamma_bitmap_words.
+ * @return Liczba pól, na których gracz może wykonać ruch, lub zero,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player, uint64_t *bitmap);
+
+/** @brief Wyznacza pola, na których gracz może wykonać złoty ruch.
+ * Zapisuje w bitmapie @p bitmap pola, na których gracz @p player może
+ * wykonać złoty ruch funkcją @ref gamma_golden_move. Kandydaci są wyznaczani
+ * tak jak w funkcji @ref gamma_legal_moves; dla pól, których zajęcie mogłoby
+ * podzielić obszar poprzedniego gracza na zbyt wiele części, wykonywany jest
+ * dodatkowo próbny ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] bitmap – wskaźnik na bitmapę o rozmiarze podanym przez
+ *                      funkcję @ref gamma_bitmap_words.
+ * @return Liczba pól, na których gracz może wykonać złoty ruch, lub zero,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_legal_golden_moves(gamma_t *g, uint32_t player, uint64_t *bitmap);
+
+/** @brief Włącza lub wyłącza dziennik ruchów.
+ * Gdy dziennik jest włączony, każdy wykonany ruch i złoty ruch jest w nim
+ * zapisywany jako zbiór zmian stanu gry (pole, poprzedni gracz, zmiany
+ * liczników i reprezentantów obszarów), co pozwala go cofnąć funkcją
+ * @ref gamma_undo i powtórzyć funkcją @ref gamma_redo.
+ * Wyłączenie dziennika usuwa jego zawartość. Jeśli nie uda się zaalokować
+ * pamięci na kolejny wpis, dziennik zostaje wyłączony.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – wartość @p true, aby włączyć dziennik, @p false,
+ *                      aby go wyłączyć.
+ * @return Wartość @p true, jeśli operacja się powiodła, a @p false,
+ * gdy któryś z parametrów jest niepoprawny.
+ */
+bool gamma_journal(gamma_t *g, bool enabled);
+
+/** @brief Pozwala odczytywać stan gry z innych wątków.
+ * Gdy odczyty są dozwolone, funkcje @ref gamma_busy_fields,
+ * @ref gamma_free_fields i @ref gamma_board można wywoływać z innych wątków
+ * w trakcie wykonywania ruchów przez wątek, który jest właścicielem gry.
+ * Odczyty nie blokują wątku wykonującego ruchy: każda zmiana stanu gry zwiększa
+ * licznik zmian, a czytający powtarza odczyt, jeśli licznik zmienił się
+ * w jego trakcie (przy odczycie planszy powtarzane jest wypisanie tylko tych
+ * wierszy, które się zmieniły). Wynik odczytu zawsze opisuje stan gry
+ * z jednej chwili między ruchami. Odczyty z innych wątków nie są liczone
+ * w statystykach. Pozostałe funkcje może wywoływać tylko właściciel gry,
+ * a odczyty muszą się skończyć przed wyłączeniem tej możliwości, przed
+ * wywołaniem funkcji @ref gamma_reset lub @ref gamma_delete i przed
+ * usunięciem kopii gry utworzonych funkcją @ref gamma_clone.
+ * Kopia gry i gra przywrócona funkcją @ref gamma_reset nie pozwalają na
+ * odczyty z innych wątków.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – wartość @p true, aby pozwolić na odczyty z innych
+ *                      wątków, @p false, aby na nie nie pozwalać.
+ * @return Wartość @p true, jeśli operacja się powiodła, a @p false,
+ * gdy któryś z parametrów jest niepoprawny lub nie udało się zaalokować
+ * pamięci.
+ */
+bool gamma_concurrent(gamma_t *g, bool enabled);
+
+/** @brief Cofa ostatni ruch.
+ * Cofa ostatni zapisany w dzienniku ruch, który nie został jeszcze cofnięty.
+ * Działa w czasie proporcjonalnym do liczby zmian wprowadzonych przez ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli ruch został cofnięty, a @p false,
+ * gdy nie ma ruchu do cofnięcia, któryś z parametrów jest niepoprawny lub
+ * nie udało się zaalokować pamięci.
+ */
+bool gamma_undo(gamma_t *g);
+
+/** @brief Powtarza ostatnio cofnięty ruch.
+ * Powtarza ostatni ruch cofnięty funkcją @ref gamma_undo. Wykonanie nowego
+ * ruchu usuwa możliwość powtórzenia cofniętych ruchów.
+ * Działa w czasie proporcjonalnym do liczby zmian wprowadzonych przez ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli ruch został powtórzony, a @p false,
+ * gdy nie ma ruchu do powtórzenia, któryś z parametrów jest niepoprawny lub
+ * nie udało się zaalokować pamięci.
+ */
+bool gamma_redo(gamma_t *g);
+
+/** @brief Włącza lub wyłącza historię ruchów.
+ * Gdy historia jest włączona, każdy udany ruch i złoty ruch jest w niej
+ * zapisywany w zwartej postaci: numer gracza i różnice współrzędnych
+ * względem poprzedniego ruchu jako liczby o zmiennej długości, zwykle po
+ * jednym lub dwa bajty. Co pewną liczbę ruchów, nie mniejszą niż 1024
+ * i proporcjonalną do liczby pól planszy, historia zapisuje klatkę kluczową:
+ * planszę zakodowaną długościami serii pól tego samego gracza. Pierwsza
+ * klatka opisuje stan gry z chwili włączenia historii. Ruch cofnięty funkcją
+ * @ref gamma_undo jest usuwany z historii, a ruch powtórzony funkcją
+ * @ref gamma_redo dopisywany; cofnięcie ruchu sprzed włączenia historii
+ * rozpoczyna ją od bieżącego stanu gry. Wyłączenie historii usuwa jej
+ * zawartość. Jeśli nie uda się zaalokować pamięci na kolejny wpis, historia
+ * zostaje wyłączona. Kopia gry utworzona funkcją @ref gamma_clone nie ma
+ * historii.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – wartość @p true, aby włączyć historię, @p false,
+ *                      aby ją wyłączyć.
+ * @return Wartość @p true, jeśli operacja się powiodła, a @p false,
+ * gdy któryś z parametrów jest niepoprawny lub nie udało się zaalokować
+ * pamięci.
+ */
+bool gamma_history(gamma_t *g, bool enabled);
+
+/** @brief Podaje długość historii ruchów.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba ruchów zapisanych w historii, patrz @ref gamma_history,
+ * lub @p 0, jeśli historia jest wyłączona lub parametr jest niepoprawny.
+ */
+uint64_t gamma_history_length(gamma_t *g);
+
+/** @brief Odtwarza stan gry z historii ruchów.
+ * Tworzy nową grę w stanie po wykonaniu @p moves pierwszych ruchów historii
+ * gry @p g. Odtwarza planszę z ostatniej klatki kluczowej przed tym ruchem
+ * i wykonuje tylko ruchy zapisane po niej. Nowa gra nie ma historii.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves   – numer ruchu, liczba nieujemna niewiększa od wyniku
+ *                      funkcji @ref gamma_history_length.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, gdy historia jest
+ * wyłączona, któryś z parametrów jest niepoprawny lub nie udało się
+ * zaalokować pamięci.
+ */
+gamma_t* gamma_replay(gamma_t *g, uint64_t moves);
+
+/** @brief Podaje identyfikator obszaru.
+ * Podaje identyfikator obszaru zawierającego pole (@p x, @p y) w grze
+ * wskazywanej przez @p g. Pola tego samego obszaru mają ten sam
+ * identyfikator. Identyfikator może się zmienić po kolejnym ruchu.
+ * Działa w czasie bliskim stałemu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Dodatni identyfikator obszaru lub zero, jeśli pole jest wolne
+ * lub któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_region_of(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Podaje rozmiar obszaru.
+ * Podaje liczbę pól obszaru zawierającego pole (@p x, @p y) w grze
+ * wskazywanej przez @p g. Działa w czasie bliskim stałemu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Liczba pól obszaru lub zero, jeśli pole jest wolne lub któryś
+ * z parametrów jest niepoprawny.
+ */
+uint64_t gamma_region_size(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Podaje długość wolnego brzegu obszaru.
+ * Podaje liczbę par sąsiednich pól, z których jedno należy do obszaru
+ * zawierającego pole (@p x, @p y), a drugie jest wolne. Wolne pole sąsiadujące
+ * z kilkoma polami obszaru jest liczone kilka razy. Działa w czasie bliskim
+ * stałemu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Liczba par pól lub zero, jeśli pole jest wolne lub któryś
+ * z parametrów jest niepoprawny.
+ */
+uint64_t gamma_region_boundary(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Podaje liczbę obszarów gracza.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Liczba obszarów gracza lub zero, jeśli któryś z parametrów jest
+ * niepoprawny.
+ */
+uint32_t gamma_region_count(gamma_t *g, uint32_t player);
+
+/** @brief Podaje rozmiar największego obszaru gracza.
+ * Gra pamięta, ile obszarów każdego rozmiaru ma każdy gracz, i aktualizuje
+ * największy rozmiar przy każdym ruchu, także złotym, więc wynik jest
+ * podawany w czasie stałym.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Liczba pól największego obszaru gracza lub zero, jeśli gracz nie
+ * ma pól lub któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_largest_region(gamma_t *g, uint32_t player);
+
+/** @brief Podaje liczbę pól gracza w prostokącie.
+ * Liczy pola gracza @p player w prostokącie złożonym z kolumn od @p x do
+ * @p x + @p width - 1 i wierszy od @p y do @p y + @p height - 1. Plansza jest
+ * przechowywana w kafelkach po 256 pól pamiętających liczby pól graczy, więc
+ * kafelek leżący w całości w prostokącie kosztuje zwykle jeden odczyt,
+ * a przeglądane są tylko pola kafelków przeciętych brzegiem prostokąta.
+ * Kafelek pamięta jednak liczby pól co najwyżej 16 graczy. Jeśli pola
+ * w kafelku ma więcej graczy, to dla gracza spoza liczonych wszystkie 256 pól
+ * kafelka jest przeglądanych po kolei. Przy wielu graczach wymieszanych na
+ * planszy koszt rośnie więc do liczby pól prostokąta.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba nieujemna niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new; dla zera liczone
+ *                      są wolne pola,
+ * @param[in] x       – numer pierwszej kolumny prostokąta,
+ * @param[in] y       – numer pierwszego wiersza prostokąta,
+ * @param[in] width   – szerokość prostokąta,
+ * @param[in] height  – wysokość prostokąta.
+ * @return Liczba pól gracza w prostokącie lub zero, jeśli któryś z parametrów
+ * jest niepoprawny lub prostokąt nie mieści się na planszy.
+ */
+uint64_t gamma_count_in_rect(gamma_t *g, uint32_t player, uint32_t x,
+                             uint32_t y, uint32_t width, uint32_t height);
+
+/** @brief Zapisuje stan gry do pliku.
+ * Zapisuje stan gry wskazywanej przez @p g od bieżącego położenia w pliku
+ * @p fd w formacie binarnym, który można wczytać funkcją @ref gamma_load
+ * programem skompilowanym tak samo. Kafelki planszy są zapisywane od
+ * położenia wyrównanego do rozmiaru strony pamięci. Dziennik ruchów nie jest
+ * zapisywany.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] fd      – deskryptor pliku otwartego do zapisu.
+ * @return Wartość @p true, jeśli stan gry został zapisany, a @p false,
+ * gdy któryś z parametrów jest niepoprawny lub zapis się nie udał.
+ */
+bool gamma_save(gamma_t *g, int fd);
+
+/** @brief Wczytuje stan gry z pliku.
+ * Wczytuje stan gry zapisany funkcją @ref gamma_save od bieżącego położenia
+ * w pliku @p fd i ustawia położenie za zapisem. Jeśli plik pozwala zmieniać
+ * położenie, plansza nie jest czytana, tylko odwzorowywana w pamięci, a jej
+ * kafelki są kopiowane dopiero przy pierwszej zmianie, więc wczytanie trwa
+ * krótko niezależnie od rozmiaru planszy; plik nie może być wtedy zmieniany,
+ * dopóki istnieje wczytana gra lub jej kopie. W przeciwnym wypadku plansza
+ * jest czytana w całości. Sumy kontrolne nagłówka i tablic graczy są zawsze
+ * sprawdzane, a suma kontrolna planszy tylko przy czytaniu planszy.
+ * @param[in] fd      – deskryptor pliku otwartego do odczytu.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, gdy zapis jest
+ * niepoprawny, nie udało się go wczytać lub zaalokować pamięci.
+ */
+gamma_t* gamma_load(int fd);
+
+/** @brief Podaje licznik statystyk silnika.
+ * Zapisuje w @p value licznik @p counter funkcji interfejsu @p api zebrany
+ * od utworzenia gry wskazywanej przez @p g: liczbę wywołań funkcji albo
+ * pracę wykonaną wewnątrz niej. Liczniki są dostępne tylko, gdy silnik
+ * skompilowano z makrem @p GAMMA_STATS; w przeciwnym wypadku nie są
+ * zbierane, więc nie spowalniają silnika, a funkcja zapisuje zero. Układ
+ * liczników w pamięci zna tylko silnik, więc dopisanie funkcji lub licznika
+ * nie zmienia interfejsu binarnego biblioteki.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] api     – funkcja interfejsu,
+ * @param[in] counter – licznik,
+ * @param[out] value  – wskaźnik na zmienną, do której zostanie zapisany
+ *                      licznik.
+ * @return Wartość @p true, jeśli licznik został zapisany, a @p false, gdy
+ * któryś z parametrów jest niepoprawny lub silnik skompilowano bez
+ * statystyk.
+ */
+bool gamma_counter(gamma_t *g, enum gamma_api api, enum gamma_counter counter,
+                   uint64_t *value);
+
+/** @brief Podaje nazwę funkcji interfejsu.
+ * Pozwala wypisać statystyki wszystkich funkcji bez znajomości ich liczby:
+ * kolejne wartości @p api od zera wskazują funkcje, dopóki wynikiem nie jest
+ * @p NULL.
+ * @param[in] api     – funkcja interfejsu.
+ * @return Nazwa funkcji, na przykład @p "gamma_move", lub @p NULL, jeśli
+ * @p api nie wskazuje żadnej funkcji.
+ */
+const char* gamma_api_name(enum gamma_api api);
+
 /** @brief Podaje szerokość pojedynczego pola.
  * Podaje szerokość pojedynczego pola w tekstowym opisie stanu planszy
  * w grze wskazywanej przez @p g.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
  * @return Szerokość pojednyczego pola planszy, liczba dodatnia.
  */
-uint32_t get_width_of_field(gamma_t* g);
+static inline uint32_t get_width_of_field(gamma_t* g) {
+  return (*(const struct gamma_info*)g).width_of_field;
+}
 
 /** @brief Podaje szerokość planszy.
  * Podaje szerokość planszy w grze wskazywanej przez @p g.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
  * @return Szerokość planszy, liczba dodatnia.
  */
-uint32_t get_width(gamma_t* g);
+static inline uint32_t get_width(gamma_t* g) {
+  return (*(const struct gamma_info*)g).width;
+}
 
 /** @brief Podaje wysokość planszy.
  * Podaje wysokość planszy w grze wskazywanej przez @p g.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
  * @return Wysokość planszy, liczba dodatnia.
  */
-uint32_t get_height(gamma_t* g);
+static inline uint32_t get_height(gamma_t* g) {
+  return (*(const struct gamma_info*)g).height;
+}
 
 /** @brief Podaje liczbę graczy.
  * Podaje liczbę graczy w grze wskazywanej przez @p g.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
  * @return Liczba graczy, liczba dodatnia.
  */
-uint32_t get_players(gamma_t* g);
+static inline uint32_t get_players(gamma_t* g) {
+  return (*(const struct gamma_info*)g).players;
+}
 
 /** @brief Podaje numer gracza na danej pozycji.
  * Podaje numer gracza, którego pionek stoi na polu (@p x, @p y) lub wartość 
@@ -158,4 +685,21 @@ uint32_t get_players(gamma_t* g);
  */
 uint32_t player_on_position(gamma_t* g, int x, int y);
 
+/** @brief Podaje numery graczy na kolejnych polach wiersza.
+ * Zapisuje w tablicy @p players numery graczy, których pionki stoją na polach
+ * (@p x, @p y), (@p x + 1, @p y), ..., lub wartość @p 0 dla pól wolnych.
+ * Odczytuje co najwyżej @p count pól, nie wychodząc poza planszę. Jedno
+ * wywołanie zastępuje wywołania funkcji @ref player_on_position dla
+ * wszystkich tych pól.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny pierwszego pola,
+ * @param[in] y       – numer wiersza,
+ * @param[in] count   – liczba pól do odczytania,
+ * @param[out] players – wskaźnik na tablicę co najmniej @p count liczb.
+ * @return Liczba odczytanych pól lub @p 0, jeśli któryś z parametrów jest
+ * niepoprawny.
+ */
+uint32_t gamma_cells(gamma_t *g, uint32_t x, uint32_t y, uint32_t count,
+                     uint32_t *players);
+
 #endif /* GAMMA_H */
@@ -0,0 +1,488 @@
+/** @file
+ * Zestaw testów wydajności silnika gry gamma.
+ * Program uruchamia nazwane, syntetyczne obciążenia korzystające z interfejsu
+ * @ref gamma.h, mierzy czas każdej operacji i wypisuje wyniki w formacie JSON:
+ * liczbę operacji na sekundę, percentyle czasu operacji w nanosekundach
+ * oraz maksymalny rozmiar pamięci rezydentnej. Każde obciążenie jest
+ * wykonywane w osobnym procesie potomnym, więc rozmiar pamięci dotyczy tylko
+ * tego obciążenia. Czasy trafiają do histogramu o stałym rozmiarze, więc
+ * pomiary nie zajmują pamięci, a od każdego czasu jest odejmowany zmierzony
+ * na początku koszt odczytu zegara.
+ *
+ * Opcje: @p -s ziarno, liczba nieujemna, @p -w nazwa jedynego uruchamianego
+ * obciążenia, @p -o plik, do którego zostaną zapisane wyniki (domyślnie
+ * standardowe wyjście).
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gamma.h"
+#include "latency.h"
+#include "random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/**
+ * Liczba pustych pomiarów, z których wyznaczany jest koszt odczytu zegara.
+ */
+#define CALIBRATION 100000
+
+/**
+ * Struktura przechowująca zmierzone czasy operacji jednego obciążenia.
+ */
+struct samples {
+  struct latency_histogram times; ///<histogram czasów operacji
+  uint64_t total; ///<suma czasów operacji w nanosekundach
+  uint64_t overhead; ///<koszt pomiaru odejmowany od czasu operacji
+};
+
+/**
+ * Struktura opisująca obciążenie.
+ */
+struct workload {
+  const char* name; ///<nazwa obciążenia
+  bool (*run)(struct samples* s, uint64_t seed); ///<funkcja wykonująca
+};
+
+/** @brief Zapamiętuje czas operacji.
+ * Od zmierzonego czasu odejmuje koszt samego pomiaru.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] start    – czas rozpoczęcia operacji.
+ */
+static void record(struct samples* s, uint64_t start) {
+  uint64_t ns = latency_now() - start;
+  ns = ns > (*s).overhead ? ns - (*s).overhead : 0;
+  latency_add(&((*s).times), ns);
+  (*s).total += ns;
+}
+
+/** @brief Mierzy koszt pomiaru.
+ * Mierzy wiele razy pustą operację tak samo, jak funkcja @ref record mierzy
+ * operacje, i zapisuje medianę tych czasów jako koszt pomiaru.
+ * @param[out] s       – wskaźnik na zmierzone czasy.
+ */
+static void calibrate(struct samples* s) {
+  struct latency_histogram empty = {{0}, 0, 0};
+  for (uint32_t i = 0; i < CALIBRATION; i++) {
+    uint64_t start = latency_now();
+    latency_add(&empty, latency_now() - start);
+  }
+  (*s).overhead = latency_percentile(&empty, 0.5);
+}
+
+/** @brief Wykonuje mierzony ruch.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player   – numer gracza,
+ * @param[in] x        – numer kolumny,
+ * @param[in] y        – numer wiersza.
+ * @return Wynik funkcji @ref gamma_move.
+ */
+static bool timed_move(struct samples* s, gamma_t* g, uint32_t player,
+                       uint32_t x, uint32_t y) {
+  uint64_t start = latency_now();
+  bool result = gamma_move(g, player, x, y);
+  record(s, start);
+  return result;
+}
+
+/** @brief Wykonuje mierzony złoty ruch.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player   – numer gracza,
+ * @param[in] x        – numer kolumny,
+ * @param[in] y        – numer wiersza.
+ * @return Wynik funkcji @ref gamma_golden_move.
+ */
+static bool timed_golden_move(struct samples* s, gamma_t* g, uint32_t player,
+                              uint32_t x, uint32_t y) {
+  uint64_t start = latency_now();
+  bool result = gamma_golden_move(g, player, x, y);
+  record(s, start);
+  return result;
+}
+
+/** @brief Wykonuje mierzone sprawdzenie złotego ruchu.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player   – numer gracza.
+ * @return Wynik funkcji @ref gamma_golden_possible.
+ */
+static bool timed_golden_possible(struct samples* s, gamma_t* g,
+                                  uint32_t player) {
+  uint64_t start = latency_now();
+  bool result = gamma_golden_possible(g, player);
+  record(s, start);
+  return result;
+}
+
+/** @brief Losowo zapełnia dużą planszę.
+ * Gracze na zmianę wykonują ruchy na losowe pola planszy 512x512.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno,
+ * @param[in] concurrent – informacja, czy pozwolić na odczyty z innych
+ *                       wątków, patrz @ref gamma_concurrent.
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool fill(struct samples* s, uint64_t seed, bool concurrent) {
+  const uint32_t size = 512, players = 8;
+  gamma_t* g = gamma_new(size, size, players, 64);
+  if (g == NULL) return false;
+  if (gamma_concurrent(g, concurrent) == false) {
+    gamma_delete(g);
+    return false;
+  }
+  for (uint32_t i = 0; i < 1000000; i++) {
+    timed_move(s, g, i % players + 1, random_below(&seed, size),
+               random_below(&seed, size));
+  }
+  gamma_delete(g);
+  return true;
+}
+
+/** @brief Losowo zapełnia dużą planszę.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool random_fill(struct samples* s, uint64_t seed) {
+  return fill(s, seed, false);
+}
+
+/** @brief Losowo zapełnia dużą planszę, pozwalając na odczyty z innych
+ * wątków.
+ * Mierzy koszt licznika zmian i znaczników wierszy w wątku wykonującym ruchy.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool concurrent_fill(struct samples* s, uint64_t seed) {
+  return fill(s, seed, true);
+}
+
+/** @brief Wykonuje serię złotych ruchów przy wyczerpanym limicie obszarów.
+ * W wielu grach z małym limitem obszarów zapełnia planszę, a następnie
+ * każdy gracz sprawdza możliwość złotego ruchu i próbuje go wykonać na
+ * losowych polach.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć gry.
+ */
+static bool golden_storm(struct samples* s, uint64_t seed) {
+  const uint32_t size = 64, players = 16;
+  for (uint32_t game = 0; game < 50; game++) {
+    gamma_t* g = gamma_new(size, size, players, 3);
+    if (g == NULL) return false;
+    for (uint32_t i = 0; i < 4 * size * size; i++) {
+      gamma_move(g, i % players + 1, random_below(&seed, size),
+                 random_below(&seed, size));
+    }
+    for (uint32_t player = 1; player <= players; player++) {
+      if (timed_golden_possible(s, g, player) == false) continue;
+      for (uint32_t i = 0; i < 256; i++) {
+        if (timed_golden_move(s, g, player, random_below(&seed, size),
+                              random_below(&seed, size)) == true) break;
+      }
+    }
+    gamma_delete(g);
+  }
+  return true;
+}
+
+/** @brief Buduje długie obszary w kształcie węża i próbuje je rozcinać.
+ * Gracz 1 buduje jeden obszar przechodzący przez wszystkie parzyste wiersze
+ * planszy 256x256, a gracz 2 zajmuje wiersz 1. Następnie gracz 2 próbuje
+ * złotych ruchów w wierszach 0 i 2, które rozcięłyby obszar gracza 1 na dwa,
+ * więc każdy z nich wymaga przejścia całego obszaru.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool snake(struct samples* s, uint64_t seed) {
+  const uint32_t size = 256;
+  gamma_t* g = gamma_new(size, size, 2, 1);
+  if (g == NULL) return false;
+  for (uint32_t y = 0; y < size; y++) {
+    if (y % 2 == 0) {
+      for (uint32_t i = 0; i < size; i++) {
+        timed_move(s, g, 1, (y / 2) % 2 == 0 ? i : size - 1 - i, y);
+      }
+    }
+    else timed_move(s, g, 1, (y / 2) % 2 == 0 ? size - 1 : 0, y);
+  }
+  for (uint32_t x = 1; x + 1 < size; x++) timed_move(s, g, 2, x, 1);
+  for (uint32_t i = 0; i < 500; i++) {
+    timed_golden_move(s, g, 2, 1 + random_below(&seed, size - 2),
+                      2 * random_below(&seed, 2));
+  }
+  gamma_delete(g);
+  return true;
+}
+
+/** @brief Wykonuje ruchy wielu graczy na zatłoczonej planszy.
+ * Dwa tysiące graczy wykonuje ruchy na planszy 128x128, sprawdzając
+ * liczbę wolnych pól i możliwość złotego ruchu.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool crowding(struct samples* s, uint64_t seed) {
+  const uint32_t size = 128, players = 2000;
+  gamma_t* g = gamma_new(size, size, players, 4);
+  if (g == NULL) return false;
+  for (uint32_t i = 0; i < 200000; i++) {
+    uint32_t player = random_below(&seed, players) + 1;
+    timed_move(s, g, player, random_below(&seed, size),
+               random_below(&seed, size));
+    uint64_t start = latency_now();
+    gamma_free_fields(g, player);
+    record(s, start);
+    if (i % 16 == 0) timed_golden_possible(s, g, player);
+  }
+  gamma_delete(g);
+  return true;
+}
+
+/** @brief Wypisuje dużą planszę.
+ * Zapełnia połowę planszy 1000x1000 ruchami dwunastu graczy, a następnie
+ * wielokrotnie tworzy napis opisujący planszę.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool board(struct samples* s, uint64_t seed) {
+  const uint32_t size = 1000, players = 12;
+  gamma_t* g = gamma_new(size, size, players, size * size);
+  if (g == NULL) return false;
+  for (uint32_t i = 0; i < size * size / 2; i++) {
+    gamma_move(g, i % players + 1, random_below(&seed, size),
+               random_below(&seed, size));
+  }
+  for (uint32_t i = 0; i < 30; i++) {
+    uint64_t start = latency_now();
+    char* p = gamma_board(g);
+    record(s, start);
+    if (p == NULL) {
+      gamma_delete(g);
+      return false;
+    }
+    free(p);
+  }
+  gamma_delete(g);
+  return true;
+}
+
+/** @brief Rozgrywa krótką partię.
+ * Wykonuje kilkanaście losowych ruchów w grze na planszy 19x19.
+ * @param[in, out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] seed – wskaźnik na stan generatora.
+ */
+static void short_game(gamma_t* g, uint64_t* seed) {
+  for (uint32_t i = 0; i < 16; i++) {
+    gamma_move(g, i % 4 + 1, random_below(seed, 19), random_below(seed, 19));
+  }
+}
+
+/** @brief Tworzy i usuwa wiele małych gier.
+ * Mierzy czas utworzenia gry funkcją @ref gamma_new, krótkiej partii
+ * i usunięcia gry.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć gry.
+ */
+static bool churn_new(struct samples* s, uint64_t seed) {
+  for (uint32_t i = 0; i < 200000; i++) {
+    uint64_t start = latency_now();
+    gamma_t* g = gamma_new(19, 19, 4, 8);
+    if (g == NULL) return false;
+    short_game(g, &seed);
+    gamma_delete(g);
+    record(s, start);
+  }
+  return true;
+}
+
+/** @brief Pobiera i oddaje wiele małych gier z puli.
+ * Działa jak @ref churn_new, ale gry pochodzą z puli @ref gamma_pool_new.
+ * @param[in, out] s   – wskaźnik na zmierzone czasy,
+ * @param[in] seed     – niezerowe ziarno.
+ * @return Wartość @p true, jeśli udało się utworzyć gry.
+ */
+static bool churn_pool(struct samples* s, uint64_t seed) {
+  gamma_pool_t* pool = gamma_pool_new(19, 19, 4, 8, 4);
+  if (pool == NULL) return false;
+  for (uint32_t i = 0; i < 200000; i++) {
+    uint64_t start = latency_now();
+    gamma_t* g = gamma_pool_get(pool, 19, 19, 4, 8);
+    if (g == NULL) {
+      gamma_pool_delete(pool);
+      return false;
+    }
+    short_game(g, &seed);
+    gamma_pool_put(pool, g);
+    record(s, start);
+  }
+  gamma_pool_delete(pool);
+  return true;
+}
+
+/**
+ * Lista obciążeń w kolejności uruchamiania.
+ */
+static const struct workload workloads[] = {
+  {"random_fill", random_fill},
+  {"concurrent_fill", concurrent_fill},
+  {"golden_storm", golden_storm},
+  {"snake", snake},
+  {"crowding", crowding},
+  {"board", board},
+  {"churn_new", churn_new},
+  {"churn_pool", churn_pool}
+};
+
+/** @brief Podaje maksymalny rozmiar pamięci rezydentnej procesu.
+ * Wywoływana w procesie potomnym, który wykonał jedno obciążenie.
+ * @return Rozmiar w kilobajtach.
+ */
+static long peak_rss() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  return usage.ru_maxrss;
+}
+
+/** @brief Uruchamia obciążenie i wypisuje jego wyniki.
+ * @param[in] w      – wskaźnik na obciążenie,
+ * @param[in] seed   – ziarno,
+ * @param[in] out    – plik wyjściowy,
+ * @param[in] first  – informacja, czy jest to pierwszy wypisywany wynik.
+ * @return Wartość @p true, jeśli obciążenie zostało wykonane.
+ */
+static bool run(const struct workload* w, uint64_t seed, FILE* out,
+                bool first) {
+  struct samples s = {{{0}, 0, 0}, 0, 0};
+  calibrate(&s);
+  bool result = (*w).run(&s, seed * 2 + 1);
+  if (result == true) {
+    const struct latency_histogram* h = &(s.times);
+    double seconds = (double)s.total / 1e9;
+    fprintf(out, "%s    {\"name\": \"%s\", \"ops\": %" PRIu64 ", "
+            "\"seconds\": %.6f, \"ops_per_second\": %.1f, "
+            "\"ns_per_op\": {\"mean\": %.1f, \"p50\": %" PRIu64 ", "
+            "\"p90\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"p999\": %" PRIu64
+            ", \"max\": %" PRIu64 "}, \"timer_overhead_ns\": %" PRIu64 ", "
+            "\"peak_rss_kb\": %ld}",
+            first == true ? "" : ",\n", (*w).name, (*h).count, seconds,
+            seconds > 0 ? (double)(*h).count / seconds : 0,
+            (*h).count > 0 ? (double)s.total / (double)(*h).count : 0,
+            latency_percentile(h, 0.5), latency_percentile(h, 0.9),
+            latency_percentile(h, 0.99), latency_percentile(h, 0.999),
+            (*h).max, s.overhead, peak_rss());
+  }
+  return result;
+}
+
+/** @brief Uruchamia obciążenie w procesie potomnym.
+ * Proces potomny wykonuje funkcję @ref run i wypisuje wyniki do pliku
+ * @p out, więc pomiar pamięci nie obejmuje wcześniejszych obciążeń.
+ * @param[in] w      – wskaźnik na obciążenie,
+ * @param[in] seed   – ziarno,
+ * @param[in] out    – plik wyjściowy,
+ * @param[in] first  – informacja, czy jest to pierwszy wypisywany wynik.
+ * @return Wartość @p true, jeśli obciążenie zostało wykonane.
+ */
+static bool run_child(const struct workload* w, uint64_t seed, FILE* out,
+                      bool first) {
+  // Bufor opróżniony przed fork nie zostanie wypisany dwukrotnie.
+  fflush(out);
+  pid_t pid = fork();
+  if (pid < 0) return false;
+  if (pid == 0) {
+    bool result = run(w, seed, out, first);
+    if (fflush(out) != 0) result = false;
+    _exit(result == true ? 0 : 1);
+  }
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) return false;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/** @brief Wczytuje ziarno.
+ * @param[in] text    – napis z liczbą dziesiętną,
+ * @param[out] seed   – wskaźnik na wczytane ziarno.
+ * @return Wartość @p true, jeśli napis jest poprawną liczbą nieujemną
+ * mieszczącą się w 64 bitach, a @p false w przeciwnym przypadku.
+ */
+static bool parse_seed(const char* text, uint64_t* seed) {
+  if (text[0] < '0' || text[0] > '9') return false;
+  char* end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (*end != '\0' || errno != 0) return false;
+  *seed = value;
+  return true;
+}
+
+/** @brief Uruchamia testy wydajności.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty programu.
+ * @return Zero, gdy wszystkie obciążenia zostały wykonane, a @p 1
+ * w przeciwnym przypadku.
+ */
+int main(int argc, char* argv[]) {
+  uint64_t seed = 1;
+  const char* only = NULL;
+  const char* path = NULL;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-s") == 0) {
+      if (parse_seed(argv[i + 1], &seed) == false) argc = -1;
+    }
+    else if (strcmp(argv[i], "-w") == 0) only = argv[i + 1];
+    else if (strcmp(argv[i], "-o") == 0) path = argv[i + 1];
+    else argc = -1;
+  }
+  if (argc < 0 || argc % 2 == 0) {
+    fprintf(stderr, "usage: %s [-s seed] [-w workload] [-o file]\n", argv[0]);
+    return 1;
+  }
+
+  FILE* out = path == NULL ? stdout : fopen(path, "w");
+  if (out == NULL) {
+    fprintf(stderr, "ERROR %s\n", path);
+    return 1;
+  }
+
+  bool result = true, first = true;
+  fprintf(out, "{\n  \"seed\": %" PRIu64 ",\n  \"workloads\": [\n", seed);
+  for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+    if (only != NULL && strcmp(only, workloads[i].name) != 0) continue;
+    if (run_child(&(workloads[i]), seed, out, first) == false) {
+      fprintf(stderr, "ERROR %s\n", workloads[i].name);
+      result = false;
+    }
+    else first = false;
+  }
+  fprintf(out, "\n  ]\n}\n");
+
+  if (out != stdout) fclose(out);
+  if (first == true && only != NULL) {
+    fprintf(stderr, "ERROR %s\n", only);
+    result = false;
+  }
+  return result == true ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+/** @file
+ * Generator danych wejściowych dla trybu wsadowego programu gamma.
+ * Program na podstawie ziarna i profilu wypisuje na standardowe wyjście
+ * deterministyczny ciąg poleceń: wiersz @p B, a po nim polecenia
+ * @p m, @p g, @p b, @p f, @p q, @p p przeplatane komentarzami, pustymi
+ * wierszami i celowo niepoprawnymi wierszami. Te same parametry dają zawsze
+ * ten sam ciąg znaków.
+ *
+ * Opcje:
+ * @p -s ziarno,
+ * @p -w szerokość planszy,
+ * @p -h wysokość planszy,
+ * @p -p liczba graczy,
+ * @p -a maksymalna liczba obszarów,
+ * @p -n liczba wierszy po wierszu @p B,
+ * @p -m wagi poleceń @p m, @p g, @p b, @p f, @p q, @p p oddzielone
+ *       przecinkami,
+ * @p -c liczba komentarzy i pustych wierszy na tysiąc wierszy,
+ * @p -e liczba niepoprawnych wierszy na tysiąc wierszy,
+ * @p -S kształt ruchów: @p random, @p spiral lub @p snake.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#include "random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** Liczba rodzajów poleceń trybu wsadowego. */
+#define COMMANDS 6
+
+/** Rozmiar bufora standardowego wyjścia. */
+#define BUFFER_SIZE (1 << 20)
+
+/**
+ * Litery poleceń w kolejności wag podawanych opcją @p -m.
+ */
+static const char commands[COMMANDS] = {'m', 'g', 'b', 'f', 'q', 'p'};
+
+/** @brief Kształt ruchów.
+ * Typ wyliczeniowy reprezentujący kolejność pól, na które są wykonywane
+ * ruchy @p m.
+ */
+enum shape {
+  shape_random, ///<losowe pola
+  shape_spiral, ///<spirala od brzegu do środka, każde okrążenie innego gracza
+  shape_snake   ///<kolejne wiersze na przemian w obu kierunkach
+};
+
+/**
+ * Struktura przechowująca profil generowanych danych.
+ */
+struct profile {
+  uint64_t seed; ///<ziarno generatora liczb losowych
+  uint32_t width; ///<szerokość planszy
+  uint32_t height; ///<wysokość planszy
+  uint32_t players; ///<liczba graczy
+  uint32_t areas; ///<maksymalna liczba obszarów
+  uint64_t lines; ///<liczba wierszy po wierszu B
+  uint32_t weights[COMMANDS]; ///<wagi poleceń
+  uint32_t comments; ///<liczba komentarzy na tysiąc wierszy
+  uint32_t errors; ///<liczba niepoprawnych wierszy na tysiąc wierszy
+  enum shape shape; ///<kształt ruchów
+};
+
+/**
+ * Struktura przechowująca stan przechodzenia planszy po spirali lub wężu.
+ */
+struct walker {
+  uint32_t x; ///<numer kolumny bieżącego pola
+  uint32_t y; ///<numer wiersza bieżącego pola
+  uint32_t left; ///<numer najmniejszej kolumny bieżącego okrążenia
+  uint32_t right; ///<numer największej kolumny bieżącego okrążenia
+  uint32_t top; ///<numer najmniejszego wiersza bieżącego okrążenia
+  uint32_t bottom; ///<numer największego wiersza bieżącego okrążenia
+  uint32_t direction; ///<kierunek ruchu: prawo, dół, lewo, góra
+  uint32_t lap; ///<numer okrążenia lub wiersza
+};
+
+/** @brief Ustawia początek przechodzenia planszy.
+ * @param[out] w      – wskaźnik na stan przechodzenia,
+ * @param[in] p       – wskaźnik na profil.
+ */
+static void walker_reset(struct walker* w, const struct profile* p) {
+  (*w).x = 0;
+  (*w).y = 0;
+  (*w).left = 0;
+  (*w).top = 0;
+  (*w).right = (*p).width - 1;
+  (*w).bottom = (*p).height - 1;
+  (*w).direction = 0;
+  (*w).lap = 0;
+}
+
+/** @brief Przechodzi do następnego pola spirali.
+ * Po przejściu wszystkich pól zaczyna od początku.
+ * @param[in, out] w  – wskaźnik na stan przechodzenia,
+ * @param[in] p       – wskaźnik na profil.
+ */
+static void spiral_step(struct walker* w, const struct profile* p) {
+  if ((*w).left == (*w).right && (*w).top == (*w).bottom) {
+    walker_reset(w, p);
+    return;
+  }
+  for (int turns = 0; turns < 4; turns++) {
+    if ((*w).direction == 0 && (*w).x < (*w).right) {
+      (*w).x++;
+      return;
+    }
+    if ((*w).direction == 1 && (*w).y < (*w).bottom) {
+      (*w).y++;
+      return;
+    }
+    if ((*w).direction == 2 && (*w).top < (*w).bottom
+        && (*w).x > (*w).left) {
+      (*w).x--;
+      return;
+    }
+    if ((*w).direction == 3 && (*w).left < (*w).right
+        && (*w).y > (*w).top + 1) {
+      (*w).y--;
+      return;
+    }
+    if ((*w).direction == 3) {
+      (*w).left++;
+      (*w).right--;
+      (*w).top++;
+      (*w).bottom--;
+      (*w).lap++;
+      if ((*w).left > (*w).right || (*w).top > (*w).bottom) {
+        walker_reset(w, p);
+        return;
+      }
+      (*w).x = (*w).left;
+      (*w).y = (*w).top;
+      (*w).direction = 0;
+      return;
+    }
+    (*w).direction++;
+  }
+  walker_reset(w, p);
+}
+
+/** @brief Przechodzi do następnego pola węża.
+ * Po przejściu wszystkich pól zaczyna od początku.
+ * @param[in, out] w  – wskaźnik na stan przechodzenia,
+ * @param[in] p       – wskaźnik na profil.
+ */
+static void snake_step(struct walker* w, const struct profile* p) {
+  bool forward = (*w).y % 2 == 0;
+  if (forward == true && (*w).x + 1 < (*p).width) (*w).x++;
+  else if (forward == false && (*w).x > 0) (*w).x--;
+  else if ((*w).y + 1 < (*p).height) {
+    (*w).y++;
+    (*w).lap++;
+  }
+  else walker_reset(w, p);
+}
+
+/** @brief Wypisuje separator parametrów.
+ * Zwykle jest to jedna spacja, czasem kilka spacji lub tabulacja.
+ * @param[in, out] state – wskaźnik na stan generatora.
+ */
+static void separator(uint64_t* state) {
+  uint32_t r = random_below(state, 16);
+  if (r == 0) fputs("\t", stdout);
+  else if (r == 1) fputs("  ", stdout);
+  else fputc(' ', stdout);
+}
+
+/** @brief Wypisuje niepoprawny wiersz.
+ * @param[in, out] state – wskaźnik na stan generatora,
+ * @param[in] p          – wskaźnik na profil.
+ */
+static void error_line(uint64_t* state, const struct profile* p) {
+  uint32_t player = random_below(state, (*p).players) + 1;
+  switch (random_below(state, 8)) {
+    case 0:
+      printf("x %" PRIu32 " 0 0\n", player);
+      break;
+    case 1:
+      printf("m %" PRIu32 " 0\n", player);
+      break;
+    case 2:
+      printf("b %" PRIu32 " 1\n", player);
+      break;
+    case 3:
+      printf("m 4294967296 0 0\n");
+      break;
+    case 4:
+      printf("f %" PRIu32 "a\n", player);
+      break;
+    case 5:
+      printf(" p\n");
+      break;
+    case 6:
+      printf("g -%" PRIu32 " 0 0\n", player);
+      break;
+    default:
+      printf("q%" PRIu32 "\n", player);
+      break;
+  }
+}
+
+/** @brief Wypisuje komentarz lub pusty wiersz.
+ * @param[in, out] state – wskaźnik na stan generatora,
+ * @param[in] line       – numer wiersza.
+ */
+static void comment_line(uint64_t* state, uint64_t line) {
+  if (random_below(state, 4) == 0) printf("\n");
+  else printf("# line %" PRIu64 " m 1 1 1\n", line);
+}
+
+/** @brief Wypisuje poprawne polecenie.
+ * @param[in, out] state – wskaźnik na stan generatora,
+ * @param[in] p          – wskaźnik na profil,
+ * @param[in, out] w     – wskaźnik na stan przechodzenia planszy,
+ * @param[in] total      – suma wag poleceń.
+ */
+static void command_line(uint64_t* state, const struct profile* p,
+                         struct walker* w, uint32_t total) {
+  uint32_t r = random_below(state, total);
+  int c = 0;
+  while (r >= (*p).weights[c]) r -= (*p).weights[c++];
+
+  uint32_t player = random_below(state, (*p).players) + 1;
+  uint32_t x = random_below(state, (*p).width);
+  uint32_t y = random_below(state, (*p).height);
+  if (commands[c] == 'm' && (*p).shape != shape_random) {
+    player = (*w).lap % (*p).players + 1;
+    x = (*w).x;
+    y = (*w).y;
+    if ((*p).shape == shape_spiral) spiral_step(w, p);
+    else snake_step(w, p);
+  }
+
+  fputc(commands[c], stdout);
+  if (commands[c] != 'p') {
+    separator(state);
+    printf("%" PRIu32, player);
+  }
+  if (commands[c] == 'm' || commands[c] == 'g') {
+    separator(state);
+    printf("%" PRIu32, x);
+    separator(state);
+    printf("%" PRIu32, y);
+  }
+  fputc('\n', stdout);
+}
+
+/** @brief Wczytuje liczbę z argumentu programu.
+ * @param[in] text     – tekst argumentu,
+ * @param[in] max      – największa dopuszczalna wartość,
+ * @param[out] target  – wskaźnik na liczbę, do której zostanie zapisany wynik.
+ * @return Wskaźnik na pierwszy znak za liczbą lub @p NULL, jeśli argument
+ * nie zaczyna się poprawną liczbą nie większą niż @p max.
+ */
+static const char* parse_number(const char* text, uint64_t max,
+                                uint64_t* target) {
+  if (*text < '0' || *text > '9') return NULL;
+  uint64_t value = 0;
+  for (; *text >= '0' && *text <= '9'; text++) {
+    if (value > (max - (uint64_t)(*text - '0')) / 10) return NULL;
+    value = value * 10 + (uint64_t)(*text - '0');
+  }
+  *target = value;
+  return text;
+}
+
+/** @brief Wczytuje opcję liczbową.
+ * @param[in] text     – tekst argumentu,
+ * @param[in] max      – największa dopuszczalna wartość,
+ * @param[out] target  – wskaźnik na liczbę, do której zostanie zapisany wynik.
+ * @return Wartość @p true, jeśli argument jest poprawną liczbą.
+ */
+static bool parse_option(const char* text, uint64_t max, uint64_t* target) {
+  const char* end = parse_number(text, max, target);
+  return end != NULL && *end == '\0';
+}
+
+/** @brief Wczytuje wagi poleceń.
+ * @param[in] text     – wagi oddzielone przecinkami,
+ * @param[out] p       – wskaźnik na profil.
+ * @return Wartość @p true, jeśli podano poprawne wagi o dodatniej sumie.
+ */
+static bool parse_weights(const char* text, struct profile* p) {
+  uint64_t total = 0;
+  for (int i = 0; i < COMMANDS; i++) {
+    uint64_t value;
+    text = parse_number(text, UINT16_MAX, &value);
+    if (text == NULL) return false;
+    if (*text != (i + 1 < COMMANDS ? ',' : '\0')) return false;
+    text++;
+    (*p).weights[i] = (uint32_t)value;
+    total += value;
+  }
+  return total > 0;
+}
+
+/** @brief Wczytuje opcje programu.
+ * @param[in] argc  – liczba argumentów,
+ * @param[in] argv  – argumenty programu,
+ * @param[out] p    – wskaźnik na profil.
+ * @return Wartość @p true, jeśli opcje są poprawne, a @p false w przeciwnym
+ * przypadku.
+ */
+static bool parse_options(int argc, char* argv[], struct profile* p) {
+  static const uint32_t weights[COMMANDS] = {70, 10, 5, 5, 5, 5};
+  (*p).seed = 1;
+  (*p).width = 100;
+  (*p).height = 100;
+  (*p).players = 4;
+  (*p).areas = 10;
+  (*p).lines = 100000;
+  memcpy((*p).weights, weights, sizeof(weights));
+  (*p).comments = 10;
+  (*p).errors = 10;
+  (*p).shape = shape_random;
+
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc || strlen(argv[i]) != 2 || argv[i][0] != '-')
+      return false;
+    const char* arg = argv[i + 1];
+    uint64_t value = 0;
+    bool valid = true;
+    switch (argv[i][1]) {
+      case 's':
+        valid = parse_option(arg, UINT64_MAX, &((*p).seed));
+        break;
+      case 'w':
+        valid = parse_option(arg, UINT32_MAX, &value) && value > 0;
+        (*p).width = (uint32_t)value;
+        break;
+      case 'h':
+        valid = parse_option(arg, UINT32_MAX, &value) && value > 0;
+        (*p).height = (uint32_t)value;
+        break;
+      case 'p':
+        valid = parse_option(arg, UINT32_MAX, &value) && value > 0;
+        (*p).players = (uint32_t)value;
+        break;
+      case 'a':
+        valid = parse_option(arg, UINT32_MAX, &value) && value > 0;
+        (*p).areas = (uint32_t)value;
+        break;
+      case 'n':
+        valid = parse_option(arg, UINT64_MAX, &((*p).lines));
+        break;
+      case 'm':
+        valid = parse_weights(arg, p);
+        break;
+      case 'c':
+        valid = parse_option(arg, 1000, &value);
+        (*p).comments = (uint32_t)value;
+        break;
+      case 'e':
+        valid = parse_option(arg, 1000, &value);
+        (*p).errors = (uint32_t)value;
+        break;
+      case 'S':
+        if (strcmp(arg, "random") == 0) (*p).shape = shape_random;
+        else if (strcmp(arg, "spiral") == 0) (*p).shape = shape_spiral;
+        else if (strcmp(arg, "snake") == 0) (*p).shape = shape_snake;
+        else valid = false;
+        break;
+      default:
+        valid = false;
+    }
+    if (valid == false) return false;
+  }
+  return (*p).comments + (*p).errors <= 1000;
+}
+
+/** @brief Generuje dane wejściowe.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty programu.
+ * @return Zero, gdy opcje są poprawne, a @p 1 w przeciwnym przypadku.
+ */
+int main(int argc, char* argv[]) {
+  struct profile p;
+  if (parse_options(argc, argv, &p) == false) {
+    fprintf(stderr, "usage: %s [-s seed] [-w width] [-h height] "
+                    "[-p players] [-a areas] [-n lines] [-m m,g,b,f,q,p] "
+                    "[-c comments] [-e errors] [-S random|spiral|snake]\n",
+                    argv[0]);
+    return 1;
+  }
+  setvbuf(stdout, NULL, _IOFBF, BUFFER_SIZE);
+
+  uint64_t state = p.seed * 2 + 1;
+  uint32_t total = 0;
+  for (int i = 0; i < COMMANDS; i++) total += p.weights[i];
+  struct walker w;
+  walker_reset(&w, &p);
+
+  // Wiersz B z zerowym wymiarem jest odrzucany przez tryb wsadowy jako
+  // ERROR 1, a kolejny poprawny wiersz B wybiera tryb.
+  if (p.errors > 0) printf("B 0 %" PRIu32 " 1 1\n", p.height);
+  printf("B %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+         p.width, p.height, p.players, p.areas);
+
+  for (uint64_t line = 0; line < p.lines; line++) {
+    uint32_t r = random_below(&state, 1000);
+    if (r < p.errors) error_line(&state, &p);
+    else if (r < p.errors + p.comments) comment_line(&state, line);
+    else command_line(&state, &p, &w, total);
+  }
+  return fflush(stdout) == 0 ? 0 : 1;
+}
@@ -12,17 +12,38 @@
 #include "mode.h"
 #include "batchmode.h"
 #include "interactivemode.h"
+#include "checkpoint.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /** @brief Przeprowadza rozgrywkę.
  * Wybiera tryb rozgrywki, a następnie przeprowadza grę w trybie wsadowym
  * lub interaktywnym. Na koniec usuwa strukturę przechowującą stan gry.
+ * Z opcją @p --resume wznawia rozgrywkę w trybie wsadowym z punktu
+ * kontrolnego, patrz @ref checkpoint_resume; jeśli się to nie uda, wypisuje
+ * na standardowe wyjście diagnostyczne komunikat @p "RESUME ERROR" i kończy
+ * działanie programu z kodem @p 1.
+ * @param[in] argc    – liczba argumentów programu,
+ * @param[in] argv    – argumenty programu.
+ * @return Kod zakończenia programu.
  */
-int main(){
+int main(int argc, char* argv[]){
   gamma_t* g = NULL;
   unsigned long long line = 0;
-  enum mode m = choose_mode(&line, &g);
+  enum mode m;
+  
+  if (argc > 1 && strcmp(argv[1], "--resume") == 0) {
+    g = checkpoint_resume(&line);
+    if (g == NULL) {
+      fprintf(stderr, "RESUME ERROR\n");
+      return 1;
+    }
+    m = batch_mode;
+  }
+  else {
+    m = choose_mode(&line, &g);
+  }
   
   if (m == batch_mode) { 
     batch(&line, &g);
@@ -11,11 +11,16 @@
 #undef NDEBUG
 #endif
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "gamma.h"
 #include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 /**
  * Tak ma wyglądać plansza po wykonaniu wszystkich testów.
@@ -32,6 +37,115 @@ static const char board[] =
   "1221......\n"
   "1.........\n";
 
+/**
+ * Plansza z graczami, którzy nie mają wolnych pól ani legalnego złotego
+ * ruchu: gracze @p 2, @p 4, @p 5, @p 7 i @p 9 sąsiadują tylko z polami,
+ * których zajęcie dzieli obszar innego gracza. Pierwszy wiersz jest górny.
+ */
+static const char stuck_board[] =
+  "11882888\n"
+  "13388858\n"
+  "13333338\n"
+  "11111738\n"
+  "41661338\n"
+  "11161388\n"
+  "16668388\n"
+  "66998888\n";
+
+/**
+ * Liczba kopii planszy @ref stuck_board w teście zablokowanych graczy.
+ */
+#define COPIES 4
+
+/**
+ * Długość boku planszy w teście odczytów z innych wątków.
+ */
+#define SIDE 48
+
+/**
+ * Liczba wątków czytających w teście odczytów z innych wątków.
+ */
+#define READERS 3
+
+/** @brief Podaje gracza pola w teście zablokowanych graczy.
+ * Kopie planszy @ref stuck_board mają własnych graczy i są oddzielone
+ * kolumnami kolejnych graczy, które zablokowani gracze dotykają tylko
+ * w środku.
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Numer gracza na polu (@p x, @p y).
+ */
+static uint32_t stuck_owner(uint32_t x, uint32_t y) {
+  uint32_t copy = x / 9;
+  if (x % 9 == 8) return 9 * COPIES + copy + 1;
+  return 9 * copy + (uint32_t)(stuck_board[(7 - y) * 9 + x % 9] - '0');
+}
+
+/** @brief Sprawdza, czy gracz jest zablokowany w teście zablokowanych graczy.
+ * @param[in] player  – numer gracza.
+ * @return Wartość @p true, jeśli gracz nie ma legalnego złotego ruchu,
+ * a @p false w przeciwnym przypadku.
+ */
+static bool stuck_player(uint32_t player) {
+  return player <= 9 * COPIES 
+         && strchr("24579", '0' + (int)((player - 1) % 9 + 1)) != NULL;
+}
+
+/** @brief Sprawdza stan gry odczytywany w trakcie ruchów.
+ * Gracz @p 1 zajmuje pola planszy o boku @ref SIDE wierszami, od wiersza
+ * @p 0, więc każdy spójny odczyt planszy pokazuje początek tej kolejności,
+ * a liczba pól gracza nie maleje i nie jest mniejsza od liczby pól
+ * odczytanych wcześniej z planszy. Czyta, dopóki gracz nie zajmie
+ * wszystkich pól.
+ * @param[in] arg     – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p NULL.
+ */
+static void* reader(void* arg) {
+  gamma_t *g = arg;
+  uint64_t busy = 0;
+  while (busy < SIDE * SIDE) {
+    char *p = gamma_board(g);
+    assert(p);
+    uint64_t taken = 0;
+    bool gap = false;
+    for (uint32_t y = 0; y < SIDE; y++) {
+      for (uint32_t x = 0; x < SIDE; x++) {
+        char c = p[(SIDE - 1 - y) * (SIDE + 1) + x];
+        assert(c == '1' || c == '.');
+        assert(c == '.' || !gap);
+        if (c == '1') taken++;
+        else gap = true;
+      }
+    }
+    free(p);
+    uint64_t now = gamma_busy_fields(g, 1);
+    assert(now >= busy && now >= taken);
+    busy = now;
+  }
+  return NULL;
+}
+
+/** @brief Liczy pola gracza w prostokącie po kolei.
+ * Wzorzec dla funkcji @ref gamma_count_in_rect.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza lub @p 0 dla wolnych pól,
+ * @param[in] x       – numer pierwszej kolumny prostokąta,
+ * @param[in] y       – numer pierwszego wiersza prostokąta,
+ * @param[in] width   – szerokość prostokąta,
+ * @param[in] height  – wysokość prostokąta.
+ * @return Liczba pól gracza @p player w prostokącie.
+ */
+static uint64_t count_slowly(gamma_t *g, uint32_t player, uint32_t x,
+                             uint32_t y, uint32_t width, uint32_t height) {
+  uint64_t count = 0;
+  for (uint32_t j = y; j < y + height; j++) {
+    for (uint32_t i = x; i < x + width; i++) {
+      if (player_on_position(g, i, j) == player) count++;
+    }
+  }
+  return count;
+}
+
 /** @brief Testuje silnik gry gamma.
  * Przeprowadza przykładowe testy silnika gry gamma.
  * @return Zero, gdy wszystkie testy przebiegły poprawnie,
@@ -93,6 +207,399 @@ int main() {
   printf("%s", p);
   free(p);
 
+  gamma_delete(g);
+
+  g = gamma_new(3, 3, 2, 1);
+  assert(g != NULL);
+  assert(!gamma_undo(g));
+  assert(gamma_journal(g, true));
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_move(g, 1, 2, 0));
+  assert(gamma_move(g, 2, 2, 1));
+  assert(gamma_golden_move(g, 2, 2, 0));
+  assert(gamma_busy_fields(g, 1) == 2);
+  assert(gamma_undo(g));
+  assert(gamma_busy_fields(g, 1) == 3);
+  assert(gamma_golden_possible(g, 2));
+  assert(gamma_undo(g));
+  assert(gamma_busy_fields(g, 2) == 0);
+  assert(gamma_free_fields(g, 1) == 3);
+  assert(gamma_redo(g));
+  assert(gamma_redo(g));
+  assert(!gamma_redo(g));
+  assert(!gamma_golden_possible(g, 2));
+  assert(gamma_busy_fields(g, 1) == 2);
+  assert(gamma_undo(g));
+  assert(gamma_move(g, 2, 2, 2));
+  assert(!gamma_redo(g));
+
+  gamma_t *c = gamma_clone(g);
+  assert(c != NULL);
+  assert(gamma_move(c, 1, 0, 1));
+  assert(gamma_busy_fields(c, 1) == 4);
+  assert(gamma_busy_fields(g, 1) == 3);
+  assert(gamma_golden_move(g, 2, 2, 0));
+  assert(gamma_busy_fields(c, 2) == 2);
+  assert(gamma_golden_possible(c, 2));
+  gamma_delete(g);
+
+  g = gamma_new(3, 3, 2, 1);
+  assert(g != NULL);
+  assert(gamma_hash(g) == 0);
+  assert(gamma_move(g, 2, 2, 1));
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_move(g, 2, 2, 2));
+  assert(gamma_move(g, 1, 0, 1));
+  assert(gamma_move(g, 1, 2, 0));
+  assert(gamma_hash(g) == gamma_hash(c));
+  assert(gamma_journal(g, true));
+  assert(gamma_golden_move(g, 1, 2, 1));
+  assert(gamma_hash(g) != gamma_hash(c));
+  assert(gamma_undo(g));
+  assert(gamma_hash(g) == gamma_hash(c));
+  uint64_t bitmap[1];
+  assert(gamma_bitmap_words(g) == 1);
+  assert(gamma_legal_moves(g, 2, bitmap) == gamma_free_fields(g, 2));
+  assert(bitmap[0] == ((1 << 4) | (1 << 7)));
+  assert(gamma_legal_golden_moves(g, 2, bitmap) == 1);
+  assert(bitmap[0] == (1 << 2));
+  assert(gamma_region_of(g, 0, 1) == gamma_region_of(g, 2, 0));
+  assert(gamma_region_of(g, 1, 1) == 0);
+  assert(gamma_region_size(g, 0, 1) == 4);
+  assert(gamma_region_boundary(g, 0, 1) == 3);
+  assert(gamma_region_boundary(g, 2, 2) == 2);
+  assert(gamma_region_count(g, 2) == 1);
+  assert(gamma_golden_move(g, 1, 2, 1));
+  assert(gamma_largest_region(g, 1) == 5);
+  assert(gamma_largest_region(g, 2) == 1);
+  assert(gamma_undo(g));
+  assert(gamma_largest_region(g, 2) == 2);
+  assert(gamma_count_in_rect(g, 1, 0, 0, 3, 3) == 4);
+  assert(gamma_count_in_rect(g, 2, 1, 1, 2, 2) == 2);
+  assert(gamma_count_in_rect(g, 0, 0, 0, 3, 3) == 3);
+  assert(gamma_count_in_rect(g, 1, 1, 1, 3, 1) == 0);
+
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  assert(gamma_save(g, fileno(f)));
+  rewind(f);
+  gamma_t *l = gamma_load(fileno(f));
+  assert(l != NULL);
+  assert(gamma_hash(l) == gamma_hash(g));
+  assert(gamma_largest_region(l, 2) == 2);
+  assert(gamma_golden_move(l, 1, 2, 1));
+  assert(gamma_busy_fields(g, 2) == 2);
+  assert(gamma_busy_fields(l, 2) == 1);
+  gamma_delete(l);
+  fclose(f);
+  gamma_delete(g);
+
+  // Kafelki mają 16 na 16 pól. W pierwszym są pola dwóch graczy, w dwóch
+  // następnych pola wszystkich 24 graczy, więc nie wszyscy są w nich liczeni.
+  g = gamma_new(200, 20, 24, 4000);
+  assert(g != NULL);
+  for (uint32_t y = 0; y < 16; y++) {
+    for (uint32_t x = 0; x < 16; x++)
+      assert(gamma_move(g, (x + y) % 2 + 1, x, y));
+  }
+  for (uint32_t y = 0; y < 20; y++) {
+    for (uint32_t x = 16; x < 48; x++)
+      assert(gamma_move(g, (3 * x + 5 * y) % 24 + 1, x, y));
+  }
+  uint64_t seed = 1;
+  for (int i = 0; i < 3000; i++) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t player = (seed >> 33) % 24 + 1;
+    uint32_t x = (seed >> 17) % 200, y = (seed >> 9) % 20;
+    if (i % 10 == 0) gamma_golden_move(g, player, x, y);
+    else gamma_move(g, player, x, y);
+  }
+  for (uint32_t player = 0; player <= 24; player++) {
+    assert(gamma_count_in_rect(g, player, 0, 0, 200, 20)
+           == count_slowly(g, player, 0, 0, 200, 20));
+    assert(gamma_count_in_rect(g, player, 0, 0, 48, 16)
+           == count_slowly(g, player, 0, 0, 48, 16));
+    assert(gamma_count_in_rect(g, player, 5, 3, 40, 17)
+           == count_slowly(g, player, 5, 3, 40, 17));
+  }
+  for (int i = 0; i < 200; i++) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t x = (seed >> 40) % 200, y = (seed >> 20) % 20;
+    uint32_t width = (seed >> 8) % (200 - x) + 1;
+    uint32_t height = (seed >> 2) % (20 - y) + 1;
+    uint32_t player = i % 25;
+    assert(gamma_count_in_rect(g, player, x, y, width, height)
+           == count_slowly(g, player, x, y, width, height));
+  }
+  gamma_delete(g);
+
+  g = gamma_new(200, 200, 2, 4);
+  assert(g != NULL);
+  assert(gamma_move(g, 1, 199, 199));
+  assert(gamma_move(g, 2, 0, 0));
+  f = tmpfile();
+  assert(f != NULL);
+  assert(gamma_save(g, fileno(f)));
+  off_t size = lseek(fileno(f), 0, SEEK_END);
+  rewind(f);
+  l = gamma_load(fileno(f));
+  assert(l != NULL);
+  assert(player_on_position(l, 199, 199) == 1);
+  // Wczytana gra zmienia prywatne odwzorowanie pliku, a nie sam plik.
+  assert(gamma_move(l, 2, 100, 100));
+  assert(gamma_golden_move(l, 2, 199, 199));
+  gamma_delete(l);
+  rewind(f);
+  l = gamma_load(fileno(f));
+  assert(l != NULL);
+  assert(player_on_position(l, 100, 100) == 0);
+  assert(player_on_position(l, 199, 199) == 1);
+  gamma_delete(l);
+  char byte = 7;
+  assert(pwrite(fileno(f), &byte, 1, size - 1000) == 1);
+  rewind(f);
+  assert(gamma_load(fileno(f)) == NULL);
+  assert(ftruncate(fileno(f), size - 70000) == 0);
+  rewind(f);
+  assert(gamma_load(fileno(f)) == NULL);
+  fclose(f);
+  gamma_delete(g);
+
+  f = tmpfile();
+  assert(f != NULL);
+  g = gamma_new_file(3, 3, 2, 1, fileno(f));
+  assert(g != NULL);
+  fclose(f);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 2, 1, 0));
+  gamma_t *c2 = gamma_clone(g);
+  assert(c2 != NULL);
+  assert(gamma_golden_move(g, 1, 1, 0));
+  assert(gamma_busy_fields(g, 1) == 2);
+  assert(gamma_busy_fields(c2, 1) == 1);
+  gamma_delete(g);
+  assert(gamma_move(c2, 2, 2, 0));
+  p = gamma_board(c2);
+  assert(p);
+  assert(strcmp(p, "...\n...\n122\n") == 0);
+  free(p);
+  assert(!gamma_reset(c2, 2, 2, 3, 1));
+  assert(gamma_concurrent(c2, true));
+  assert(gamma_reset(c2, 2, 2, 2, 1));
+  assert(gamma_busy_fields(c2, 1) == 0);
+  assert(gamma_free_fields(c2, 2) == 4);
+  assert(gamma_move(c2, 2, 1, 1));
+  assert(gamma_hash(c2) != 0);
+  p = gamma_board(c2);
+  assert(p);
+  assert(strcmp(p, ".2\n..\n") == 0);
+  free(p);
+  assert(gamma_concurrent(c2, true));
+  assert(gamma_move(c2, 1, 0, 1));
+  assert(gamma_busy_fields(c2, 1) == 1);
+  assert(gamma_free_fields(c2, 1) == 1);
+  assert(gamma_golden_possible(c2, 1));
+  assert(gamma_golden_move(c2, 1, 1, 1));
+  assert(gamma_free_fields(c2, 2) == 2);
+  p = gamma_board(c2);
+  assert(p);
+  assert(strcmp(p, "11\n..\n") == 0);
+  free(p);
+  assert(gamma_concurrent(c2, false));
+  gamma_delete(c2);
+
+  // Kopie współdzielą tablicę kafelków, dopóki nie zmienią planszy.
+  g = gamma_new(64, 64, 2, 100);
+  assert(g != NULL);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 2, 63, 63));
+  gamma_t *c3 = gamma_clone(g);
+  assert(c3 != NULL);
+  gamma_t *c4 = gamma_clone(c3);
+  assert(c4 != NULL);
+  uint64_t hash = gamma_hash(g);
+  assert(gamma_move(c4, 1, 40, 40));
+  assert(gamma_hash(c3) == hash && gamma_hash(g) == hash);
+  assert(player_on_position(c3, 40, 40) == 0);
+  gamma_delete(c3);
+  assert(gamma_move(g, 2, 40, 40));
+  assert(player_on_position(c4, 40, 40) == 1);
+  assert(gamma_golden_move(c4, 2, 0, 0));
+  assert(player_on_position(g, 0, 0) == 1);
+  gamma_delete(g);
+  assert(gamma_busy_fields(c4, 2) == 2);
+  f = tmpfile();
+  assert(f != NULL);
+  assert(gamma_save(c4, fileno(f)));
+  rewind(f);
+  l = gamma_load(fileno(f));
+  assert(l != NULL);
+  c3 = gamma_clone(l);
+  assert(c3 != NULL);
+  assert(gamma_move(c3, 1, 10, 10));
+  assert(player_on_position(l, 10, 10) == 0);
+  assert(gamma_hash(l) == gamma_hash(c4));
+  gamma_delete(l);
+  assert(gamma_move(c3, 1, 30, 10));
+  assert(gamma_busy_fields(c3, 1) == 3);
+  gamma_delete(c3);
+  fclose(f);
+  gamma_delete(c4);
+
+  g = gamma_new(40, 40, 3, 100);
+  l = gamma_new(40, 40, 3, 100);
+  assert(g != NULL && l != NULL);
+  struct gamma_move_args moves[300];
+  bool results[300];
+  for (uint32_t i = 0; i < 300; i++)
+    moves[i] = (struct gamma_move_args){i % 4, i * 7 % 41, i * 13 % 40};
+  // Drugie wywołanie korzysta z klas kafelków pozostawionych przez pierwsze.
+  assert(gamma_moves(g, moves, 150, results, 3));
+  assert(gamma_moves(g, moves + 150, 150, results + 150, 3));
+  for (uint32_t i = 0; i < 300; i++) {
+    assert(gamma_move(l, moves[i].player, moves[i].x, moves[i].y)
+           == results[i]);
+  }
+  assert(gamma_hash(g) == gamma_hash(l));
+  assert(gamma_busy_fields(g, 2) == gamma_busy_fields(l, 2));
+  assert(gamma_free_fields(g, 3) == gamma_free_fields(l, 3));
+  assert(gamma_region_count(g, 1) == gamma_region_count(l, 1));
+  gamma_delete(l);
+  gamma_delete(g);
+
+  g = gamma_new(40, 40, 3, 1600);
+  assert(g != NULL);
+  assert(gamma_replay(g, 0) == NULL);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_history(g, true));
+  assert(gamma_journal(g, true));
+  uint64_t hashes[1600];
+  uint64_t n = 0;
+  hashes[0] = gamma_hash(g);
+  for (uint32_t i = 0; i < 1600; i++) {
+    if (gamma_move(g, i % 3 + 1, i * 7 % 40, i / 40))
+      hashes[++n] = gamma_hash(g);
+  }
+  assert(gamma_golden_move(g, 1, 39, 39));
+  assert(gamma_history_length(g) == n + 1);
+  assert(gamma_undo(g));
+  assert(gamma_history_length(g) == n);
+  assert(n > 1024);
+  for (uint64_t m = 0; m <= n; m += n / 7) {
+    l = gamma_replay(g, m);
+    assert(l != NULL);
+    assert(gamma_hash(l) == hashes[m]);
+    gamma_delete(l);
+  }
+  l = gamma_replay(g, n);
+  assert(l != NULL);
+  assert(gamma_busy_fields(l, 1) == gamma_busy_fields(g, 1));
+  assert(gamma_golden_possible(l, 1));
+  assert(gamma_replay(g, n + 1) == NULL);
+  gamma_delete(l);
+  gamma_delete(g);
+
+  g = gamma_new(1, 1, 2, 1);
+  assert(g != NULL);
+  assert(gamma_next_player(g, 0) == 1);
+  assert(gamma_next_player(g, 2) == 1);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_next_player(g, 1) == 2);
+  assert(gamma_next_player(g, 2) == 2);
+  assert(gamma_golden_move(g, 2, 0, 0));
+  assert(gamma_next_player(g, 2) == 1);
+  assert(gamma_golden_move(g, 1, 0, 0));
+  assert(gamma_next_player(g, 0) == 0);
+  assert(gamma_next_player(g, 3) == 0);
+  uint64_t value = 1;
+  assert(strcmp(gamma_api_name(gamma_api_move), "gamma_move") == 0);
+  assert(gamma_api_name(gamma_api_legal_golden_moves + 1) == NULL);
+  assert(!gamma_counter(g, gamma_api_legal_golden_moves + 1,
+                        gamma_counter_calls, &value));
+  assert(value == 0);
+#ifdef GAMMA_STATS
+  assert(gamma_counter(g, gamma_api_golden_move, gamma_counter_calls, &value));
+  assert(value == 2);
+  assert(!gamma_counter(g, gamma_api_move, gamma_counter_trial_moves + 1,
+                        &value));
+#else
+  assert(!gamma_counter(g, gamma_api_move, gamma_counter_calls, &value));
+#endif
+  gamma_delete(g);
+
+  p = gamma_board(c);
+  assert(p);
+  assert(strcmp(p, "..2\n1.2\n111\n") == 0);
+  free(p);
+  assert(get_width(c) == 3 && get_height(c) == 3);
+  uint32_t cells[4] = {9, 9, 9, 9};
+  assert(gamma_cells(c, 0, 1, 3, cells) == 3);
+  assert(cells[0] == 1 && cells[1] == 0 && cells[2] == 2);
+  assert(gamma_cells(c, 1, 2, 4, cells) == 2);
+  assert(cells[0] == 0 && cells[1] == 2);
+  assert(gamma_cells(c, 3, 0, 1, cells) == 0);
+  assert(gamma_cells(c, 0, 3, 1, cells) == 0);
+  gamma_delete(c);
+
+  uint32_t width = 9 * COPIES - 1, players = 10 * COPIES - 1;
+  g = gamma_new(width, 8, players, 1);
+  assert(g != NULL);
+  // Gracz może dodać pole dopiero obok swojego obszaru.
+  for (uint64_t placed = 1; placed > 0;) {
+    placed = 0;
+    for (uint32_t x = 0; x < width; x++) {
+      for (uint32_t y = 0; y < 8; y++) 
+        placed += gamma_move(g, stuck_owner(x, y), x, y);
+    }
+  }
+  assert(gamma_free_fields(g, 1) == 0);
+  // Za drugim razem zablokowani gracze są zapamiętani.
+  for (int round = 0; round < 2; round++) {
+    for (uint32_t i = 1; i <= players; i++) {
+      uint32_t next = i % players + 1;
+      while (stuck_player(next)) next = next % players + 1;
+      assert(gamma_next_player(g, i) == next);
+      assert(gamma_golden_possible(g, i) == !stuck_player(i));
+    }
+  }
+  // Złote ruchy mogą odblokować graczy, wczytana gra sprawdza od nowa.
+  for (uint32_t i = 1, moves = 0; i <= players && moves < 8; i++) {
+    bool done = false;
+    for (uint32_t x = 0; x < width && !done; x++) {
+      for (uint32_t y = 0; y < 8 && !done; y++) 
+        done = gamma_golden_move(g, i, x, y);
+    }
+    if (!done) continue;
+    moves++;
+    f = tmpfile();
+    assert(f != NULL);
+    assert(gamma_save(g, fileno(f)));
+    rewind(f);
+    l = gamma_load(fileno(f));
+    assert(l != NULL);
+    fclose(f);
+    for (uint32_t j = 1; j <= players; j++) {
+      assert(gamma_golden_possible(g, j) == gamma_golden_possible(l, j));
+      assert(gamma_next_player(g, j) == gamma_next_player(l, j));
+    }
+    gamma_delete(l);
+  }
+  gamma_delete(g);
+
+  g = gamma_new(SIDE, SIDE, 1, 1);
+  assert(g != NULL);
+  assert(gamma_concurrent(g, true));
+  pthread_t readers[READERS];
+  for (int i = 0; i < READERS; i++)
+    assert(pthread_create(&readers[i], NULL, reader, g) == 0);
+  for (uint32_t y = 0; y < SIDE; y++) {
+    for (uint32_t x = 0; x < SIDE; x++) assert(gamma_move(g, 1, x, y));
+  }
+  for (int i = 0; i < READERS; i++)
+    assert(pthread_join(readers[i], NULL) == 0);
+  assert(gamma_concurrent(g, false));
   gamma_delete(g);
   return 0;
 }
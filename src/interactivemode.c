@@ -6,136 +6,254 @@
  * @date 17.05.2020
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "gamma.h"
+#include "screen.h"
+#include "latency.h"
+#include "session.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <assert.h>
+#include <errno.h>
+#include <signal.h>
 #include <termios.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 
+/**
+ * Rozmiar bufora wczytywanych znaków, równy największej porcji nagrania.
+ */
+#define KEYS_SIZE SESSION_CHUNK
+
+/**
+ * Najkrótszy odstęp między kolejnymi wyświetleniami ekranu w milisekundach.
+ */
+#define FRAME_MS 16
+
 /** @brief Działanie gracza.
  * Typ wyliczeniowy reprezentujący możliwe działania gracza.
  */
-enum action {up, down, right, left, normal, golden, skip, quit};
+enum action {up, down, right, left, normal, golden, skip, quit, none};
 
-/** @brief Czeka na poprawny znak.
- * Wczytuje kolejne znaki, dopóki nie wczyta znaku oznaczającego akcję gracza
- * lub zakończenie gry.
- * @return Działanie gracza, któremu odpowiada wczytany znak.
+/**
+ * Informacja, czy zmienił się rozmiar okna terminala.
  */
-static enum action wait_for_sign() {
-  int prev = 0;
-  int prev_prev = 0;
-  while (1) {
-    int x = getchar();
+static volatile sig_atomic_t resized = 0;
+
+/**
+ * Łącze, do którego procedura obsługi sygnału @p SIGWINCH zapisuje bajt.
+ * Funkcja @ref read_keys czeka także na to łącze, więc sygnał, który
+ * przyjdzie po sprawdzeniu @ref resized, a przed rozpoczęciem oczekiwania,
+ * nie zostanie przeoczony.
+ */
+static int wakeup[2] = {-1, -1};
+
+/** @brief Obsługuje sygnał @p SIGWINCH.
+ * Zapamiętuje, że zmienił się rozmiar okna terminala, i przerywa
+ * oczekiwanie na znaki.
+ * @param[in] signal – numer sygnału.
+ */
+static void on_resize(int signal) {
+  (void)signal;
+  int saved = errno;
+  resized = 1;
+  // Pełne łącze i tak przerwie oczekiwanie, więc wynik jest nieistotny.
+  ssize_t written = write(wakeup[1], "", 1);
+  (void)written;
+  errno = saved;
+}
+
+/** @brief Tworzy łącze przerywające oczekiwanie na znaki.
+ * Oba końce łącza nie blokują, żeby procedura obsługi sygnału nigdy nie
+ * czekała, a opróżnianie łącza kończyło się, gdy nie ma w nim bajtów.
+ * @return Wartość @p true, jeśli operacja się powiedzie, w przeciwnym razie
+ * wartość @p false.
+ */
+static bool wakeup_open() {
+  if (pipe(wakeup) == -1) return false;
+  for (int i = 0; i < 2; i++) {
+    int flags = fcntl(wakeup[i], F_GETFL);
+    if (flags == -1 || fcntl(wakeup[i], F_SETFL, flags | O_NONBLOCK) == -1)
+      return false;
+  }
+  return true;
+}
+
+/** @brief Zamyka łącze przerywające oczekiwanie na znaki.
+ * Wywoływana po przywróceniu domyślnej obsługi sygnału @p SIGWINCH.
+ */
+static void wakeup_close() {
+  for (int i = 0; i < 2; i++) {
+    if (wakeup[i] >= 0) close(wakeup[i]);
+    wakeup[i] = -1;
+  }
+}
+
+/** @brief Struktura przechowująca wczytane, nieprzetworzone znaki.
+ * Znaki są wczytywane z terminala hurtowo, wszystkie dostępne naraz,
+ * i przetwarzane pojedynczo. Dwa ostatnie przetworzone znaki pozwalają
+ * rozpoznać strzałkę, także rozdzieloną między dwa odczyty.
+ */
+struct keys {
+  unsigned char data[KEYS_SIZE]; ///<wczytane znaki
+  size_t begin; ///<indeks pierwszego nieprzetworzonego znaku
+  size_t end; ///<liczba wczytanych znaków
+  int prev; ///<ostatni przetworzony znak
+  int prev_prev; ///<przedostatni przetworzony znak
+  session_t* session; ///<nagrywana lub odtwarzana sesja lub @p NULL
+};
+
+/** @brief Wczytuje dostępne znaki.
+ * Czeka co najwyżej @p timeout milisekund, aż na standardowym wejściu pojawią
+ * się znaki, i wczytuje wszystkie, które się zmieszczą. Wymaga, by wszystkie
+ * wcześniej wczytane znaki były przetworzone. Odtwarzana sesja zastępuje
+ * standardowe wejście, a nagrywana zapamiętuje wczytane znaki.
+ * @param[in, out] k  – wskaźnik na wczytane znaki,
+ * @param[in] timeout – czas oczekiwania w milisekundach, lub @p -1, by czekać
+ *                      bez ograniczenia.
+ * @return Wartość @p false, jeśli wejście zostało zamknięte, a @p true
+ * w przeciwnym przypadku, także gdy minął czas lub przyszedł sygnał.
+ */
+static bool read_keys(struct keys* k, int timeout) {
+  if (session_replaying((*k).session) == true) {
+    int length = session_replay((*k).session, (*k).data, timeout);
+    if (length < 0) return false;
+    (*k).begin = 0;
+    (*k).end = (size_t)length;
+    return true;
+  }
+  
+  struct pollfd p[2] = {{STDIN_FILENO, POLLIN, 0}, {wakeup[0], POLLIN, 0}};
+  int n = poll(p, 2, timeout);
+  if (n <= 0) return true;
+  if (p[1].revents != 0) { // Zmienił się rozmiar okna.
+    char drain[16];
+    while (read(wakeup[0], drain, sizeof(drain)) > 0) {}
+  }
+  if (p[0].revents == 0) return true;
+  ssize_t length = read(STDIN_FILENO, (*k).data, KEYS_SIZE);
+  if (length < 0) return errno == EINTR || errno == EAGAIN;
+  if (length == 0) return (p[0].revents & POLLHUP) == 0;
+  session_record((*k).session, (*k).data, (size_t)length);
+  (*k).begin = 0;
+  (*k).end = (size_t)length;
+  return true;
+}
+
+/** @brief Podaje działanie gracza.
+ * Zapomina dwa ostatnie przetworzone znaki, tak by następna strzałka musiała
+ * zostać wczytana w całości.
+ * @param[in, out] k  – wskaźnik na wczytane znaki,
+ * @param[in] c       – działanie gracza.
+ * @return Działanie gracza @p c.
+ */
+static enum action found(struct keys* k, enum action c) {
+  (*k).prev = 0;
+  (*k).prev_prev = 0;
+  return c;
+}
+
+/** @brief Rozpoznaje kolejne działanie gracza.
+ * Przetwarza wczytane znaki, dopóki nie trafi na znak oznaczający akcję
+ * gracza lub zakończenie gry.
+ * @param[in, out] k  – wskaźnik na wczytane znaki.
+ * @return Działanie gracza, któremu odpowiada przetworzony znak, lub
+ * @p none, jeśli przetworzono wszystkie wczytane znaki.
+ */
+static enum action next_action(struct keys* k) {
+  while ((*k).begin < (*k).end) {
+    int x = (*k).data[(*k).begin++];
+    int prev = (*k).prev;
+    int prev_prev = (*k).prev_prev;
+    (*k).prev_prev = prev;
+    (*k).prev = x;
     
     // Najpierw sprawdź czy strzałka.
     if (prev_prev == '\e' && prev == '[') {
-      if (x == 'A') return up; // W górę.
-      if (x == 'B') return down; // W dół.
-      if (x == 'C') return right; // W prawo.
-      if (x == 'D') return left; // W lewo.
+      if (x == 'A') return found(k, up); // W górę.
+      if (x == 'B') return found(k, down); // W dół.
+      if (x == 'C') return found(k, right); // W prawo.
+      if (x == 'D') return found(k, left); // W lewo.
     }
     
     if (x == ' ') { // Spacja - zwykły ruch.
-      return normal;
+      return found(k, normal);
     }
     if (x == 'G' || x == 'g') { // G - złoty ruch.
-      return golden;
+      return found(k, golden);
     }
     if (x == 'C' || x == 'c') { // C - pomiń ruch.
-      return skip;
+      return found(k, skip);
     }
     if (x == CEOT) { // Koniec gry.
-      return quit;
+      return found(k, quit);
     }
-    
-    prev_prev = prev;
-    prev = x;
   }
+  return none;
 }
 
-/** @brief Wypisuje komunikat zachęcający gracza do wykonania ruchu.
- * Czyści wiersz.
- * Wypisuje komunikat @p "PLAYER i", gdzie @p i jest numerem gracza, liczbę
- * pól zajętych przez tego gracza, liczbę wolnych pól, które może zająć
- * oraz znak @p G, jeśli gracz może wykonać złoty ruch, po czym ustawia kursor
- * na początku wiersza.
- * @param[in] g – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] i – numer gracza, liczba dodatnia.
- */
-static void comunicate(gamma_t* g, int i) {
-  printf("\033[K"); // Czyści linię.
-  printf("PLAYER %u %lu %lu", i, 
-          gamma_busy_fields(g, i), gamma_free_fields(g, i));
-          
-  if (gamma_golden_possible(g, i) == true) printf(" G");
-  printf("\033[0G"); // Ustaw kursor w kolumnie 0.
-}
-
-/** @brief Ustawia kursor pod planszą.
- * Ustawia kursor znajdujący się na polu planszy (@p x, @p y) pod planszą,
- * w pierwszej kolumnie.
- * @param[in] x              – numer kolumny, liczba nieujemna,
- * @param[in] y              – numer wiersza, liczba nieujemna,
- * @param[in] width_of_field – szerokość pojedynczego pola planszy, liczba dodatnia.
+/** @brief Ustawia komunikat zachęcający gracza do wykonania ruchu.
+ * Komunikat ma postać @p "PLAYER i", gdzie @p i jest numerem gracza, po
+ * której następuje liczba pól zajętych przez tego gracza, liczba wolnych pól,
+ * które może zająć, oraz znak @p G, jeśli gracz może wykonać złoty ruch.
+ * @param[in, out] s – wskaźnik na bufory ekranu,
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] i      – numer gracza, liczba dodatnia.
  */
-static void cursor_under_board(uint32_t x, uint32_t y, uint32_t width_of_field) {
-  printf("\033[%uB", y + 1);// Ustaw kursor na wysokość.
-  if (x > 0) 
-    printf("\033[%uD", x * width_of_field); // Ustaw kursor na szerokość.
+static void comunicate(screen_t* s, gamma_t* g, uint32_t i) {
+  char text[96];
+  snprintf(text, sizeof(text), "PLAYER %u %lu %lu%s", i,
+           gamma_busy_fields(g, i), gamma_free_fields(g, i),
+           gamma_golden_possible(g, i) == true ? " G" : "");
+  screen_status(s, text);
 }
 
-/** @brief Ustawia kursor z powrotem na planszy.
- * Ustawia kursor znajdujący się w pierwszej kolumnie pod planszą na polu
- * planszy (@p x, @p y).
- * @param[in] x              – numer kolumny, liczba nieujemna,
- * @param[in] y              – numer wiersza, liczba nieujemna,
- * @param[in] width_of_field – szerokość pojedynczego pola planszy, liczba dodatnia.
+/** @brief Podaje rozmiar okna terminala.
+ * Rozmiar okna odtwarzanej sesji pochodzi z nagrania, a w przeciwnym
+ * przypadku z terminala; nagrywana sesja go zapamiętuje.
+ * @param[in, out] r     – wskaźnik na stan sesji lub @p NULL,
+ * @param[out] rows      – wskaźnik na liczbę wierszy okna,
+ * @param[out] columns   – wskaźnik na liczbę kolumn okna.
+ * @return Wartość @p true, jeśli udało się pobrać rozmiar okna, a @p false
+ * w przeciwnym przypadku.
  */
-static void cusor_back_to_board(uint32_t x, uint32_t y, uint32_t width_of_field) {
-  printf("\033[%uA", y + 1); // Ustaw kursor na wysokość
-  if (x > 0) 
-    printf("\033[%uC", x * width_of_field); // Ustaw kursor na szerokość.
+static bool window_size(session_t* r, uint32_t* rows, uint32_t* columns) {
+  if (session_size(r, rows, columns) == true) return true;
+  struct winsize w;
+  if (ioctl(0, TIOCGWINSZ, &w) == -1) return false;
+  *rows = w.ws_row;
+  *columns = w.ws_col;
+  session_record_size(r, *rows, *columns);
+  return true;
 }
 
-/** @brief Wypisuje pole planszy.
- * Wypisuje reprezentację pola (@p x, @p y) o odpowiedniej szerokości,
- * wskazanej przez funkcję @ref get_width_of_field.
- * Jeśli pole jest zajęte przez jakiegoś gracza, wypisuje numer tego gracza,
- * w przeciwnym wypadku wypisuje kropkę.
- * @param[in] g – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] x – numer kolumny, liczba nieujemna,
- * @param[in] y – numer wiersza, liczba nieujemna.
+/** @brief Dopasowuje ekran do rozmiaru okna terminala.
+ * @param[in, out] s – wskaźnik na bufory ekranu,
+ * @param[in, out] r – wskaźnik na stan sesji lub @p NULL.
+ * @return Wartość @p true, jeśli udało się pobrać rozmiar okna i zmienić
+ * bufory ekranu, a @p false w przeciwnym przypadku.
  */
-static void print_normal(gamma_t* g, uint32_t x, uint32_t y) {
-  printf("\033[0m");                     
-  if (player_on_position(g, x, y) != 0)
-    printf("%*d", get_width_of_field(g), player_on_position(g, x, y));
-  else 
-    printf("%*c", get_width_of_field(g), '.');
-  printf("\033[%uD", get_width_of_field(g));
+static bool fit(screen_t* s, session_t* r) {
+  uint32_t rows, columns;
+  if (window_size(r, &rows, &columns) == false) return false;
+  return screen_resize(s, rows, columns);
 }
 
-/** @brief Wypisuje pole planszy w negatywie.
- * Wypisuje w negatywie reprezentację pola (@p x, @p y) o odpowiedniej
- * szerokości, wskazanej przez funkcję @ref get_width_of_field.
- * Jeśli pole jest zajęte przez jakiegoś gracza, wypisuje numer tego gracza,
- * w przeciwnym wypadku wypisuje kropkę.
- * @param[in] g – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] x – numer kolumny, liczba nieujemna,
- * @param[in] y – numer wiersza, liczba nieujemna.
+/** @brief Wyświetla zmiany ekranu.
+ * Mierzy czas wyświetlenia i liczbę bajtów wysłanych do terminala.
+ * @param[in, out] s – wskaźnik na bufory ekranu,
+ * @param[in, out] r – wskaźnik na stan sesji lub @p NULL.
  */
-static void print_highlighted(gamma_t* g, uint32_t x, uint32_t y) {
-  printf("\033[7m");                     
-  if (player_on_position(g, x, y) != 0)
-    printf("%*d", get_width_of_field(g), player_on_position(g, x, y));
-  else 
-    printf("%*c", get_width_of_field(g), '.');
-  printf("\033[%uD", get_width_of_field(g));
+static void draw(screen_t* s, session_t* r) {
+  uint64_t start = latency_now();
+  uint64_t written = screen_written(s);
+  screen_draw(s);
+  session_frame(r, latency_now() - start, screen_written(s) - written);
 }
 
 /** @brief Przesuwa kursor po planszy.
@@ -148,35 +266,72 @@ static void print_highlighted(gamma_t* g, uint32_t x, uint32_t y) {
  * @param[in] c              – działanie gracza,
  * @param[in, out] x         – wskaźnik na numer kolumny, liczbę nieujemną,
  * @param[in, out] y         – wskaźnik na numer wiersza, liczbę nieujemną,
- * @param[in] width_of_field – szerokość pojedynczego pola planszy, liczba dodatnia,
  * @param[in] width          – liczba kolumn planszy, liczba dotatnia,
  * @param[in] height         – liczba wierszy planszy, liczba dodatnia.
  */
 static void move_cursor(enum action c, uint32_t* x, uint32_t* y,
-                     uint32_t width_of_field, uint32_t width, uint32_t height) {                    
-  if (c == up) {
-    if (*y + 1 < height) {
-      printf("\033[1A");
-      (*y)++;
+                        uint32_t width, uint32_t height) {
+  if (c == up && *y + 1 < height) (*y)++;
+  if (c == down && *y >= 1) (*y)--;
+  if (c == right && *x + 1 < width) (*x)++;
+  if (c == left && *x >= 1) (*x)--;
+}
+
+/** @brief Czeka na działanie gracza.
+ * Wyświetla planszę z wyróżnionym polem (@p *x, @p *y) i przetwarza wczytane
+ * znaki. Strzałki przesuwają tylko pozycję kursora, a ekran jest wyświetlany
+ * dopiero po przetworzeniu wszystkich dostępnych znaków, nie częściej niż co
+ * @ref FRAME_MS milisekund, więc kilka wciśnięć daje jedno przesunięcie.
+ * Po zmianie rozmiaru okna terminala ekran jest wyświetlany od nowa.
+ * @param[in, out] s – wskaźnik na bufory ekranu,
+ * @param[in, out] k – wskaźnik na wczytane znaki,
+ * @param[in, out] x – wskaźnik na numer kolumny, liczbę nieujemną,
+ * @param[in, out] y – wskaźnik na numer wiersza, liczbę nieujemną,
+ * @param[in] width  – liczba kolumn planszy, liczba dotatnia,
+ * @param[in] height – liczba wierszy planszy, liczba dodatnia.
+ * @return Działanie gracza inne niż przesunięcie kursora. Wartość @p quit
+ * także wtedy, gdy wejście zostało zamknięte.
+ */
+static enum action choose(screen_t* s, struct keys* k, uint32_t* x,
+                          uint32_t* y, uint32_t width, uint32_t height) {
+  session_t* r = (*k).session;
+  screen_focus(s, *x, *y, true);
+  draw(s, r);
+  uint64_t drawn = session_now(r);
+  bool pending = false;
+  
+  while (1) {
+    enum action c = next_action(k);
+    if (c != none) session_key(r);
+    if (c == up || c == down || c == left || c == right) {
+      move_cursor(c, x, y, width, height);
+      pending = true;
+      continue;
     }
-  }
-  if (c == down) {
-    if (*y >= 1) {
-      printf("\033[1B");
-      (*y)--;
+    if (c != none) {
+      screen_focus(s, *x, *y, true);
+      return c;
     }
-  }
-  if (c == right) {
-    if (*x + 1 < width) {
-      printf("\033[%uC", width_of_field);
-      (*x)++;
+    
+    if (resized == 1 || session_resized(r) == true) {
+      resized = 0;
+      fit(s, r); // Za małe okno - zostaje stary rozmiar.
+      pending = true;
     }
-  }
-  if (c == left) {
-    if (*x >= 1) {
-      printf("\033[%uD", width_of_field);
-      (*x)--;
+    int timeout = -1;
+    if (pending == true) {
+      uint64_t elapsed = (session_now(r) - drawn) / 1000000;
+      if (elapsed >= FRAME_MS) {
+        screen_focus(s, *x, *y, true);
+        draw(s, r);
+        drawn = session_now(r);
+        pending = false;
+      }
+      else {
+        timeout = (int)(FRAME_MS - elapsed);
+      }
     }
+    if (read_keys(k, timeout) == false) return quit;
   }
 }
 
@@ -200,6 +355,8 @@ static bool setup_console() {
   }
   newattr = oldattr;
   newattr.c_lflag &= ~(ICANON | ECHO);
+  newattr.c_cc[VMIN] = 0; // Odczyt nie czeka na znaki.
+  newattr.c_cc[VTIME] = 0;
   if (tcsetattr(STDIN_FILENO, TCSANOW, &newattr) == -1) {
     return false;
   }
@@ -220,110 +377,79 @@ static bool restore_console() {
 }
 
 void interactive(gamma_t** g) {
-  bool end = false;
-    
-  printf("\e[1;1H\e[2J");
-  
   uint32_t x = 0;
   uint32_t y = 0;
   
-  uint32_t last_possible = 0;
+  session_t* r = session_start();
+  bool replaying = session_replaying(r);
+  struct keys keys = {.begin = 0, .end = 0, .prev = 0, .prev_prev = 0,
+                      .session = r};
   
   uint32_t players = get_players(*g);
-  uint32_t width_of_field = get_width_of_field(*g);
   uint32_t width = get_width(*g);
   uint32_t height = get_height(*g);
   
-  struct winsize w;
-  if (ioctl(0, TIOCGWINSZ, &w) == -1) {
+  uint32_t rows, columns;
+  if (window_size(r, &rows, &columns) == false) {
     fprintf(stderr, "TERMINAL ERROR\n");
+    session_finish(r);
     gamma_delete(*g);
     exit(1);
   }
   
-  if ((uint64_t)(w.ws_col) < (uint64_t)(width) * (uint64_t)(width_of_field)
-      || (uint32_t)(w.ws_row) < height + 1) {
-    fprintf(stderr, "BOARD TOO BIG\n");
+  if (columns < get_width_of_field(*g) || rows < 2) {
+    fprintf(stderr, "TERMINAL TOO SMALL\n");
+    session_finish(r);
     gamma_delete(*g);
     exit(1);
   }
   
-  char* p = gamma_board(*g);
-  
-  if (p == NULL) {
+  // Bez SA_RESTART, żeby sygnał przerywał oczekiwanie na znak.
+  struct sigaction action = {0};
+  action.sa_handler = on_resize;
+  sigemptyset(&action.sa_mask);
+  screen_t* s = screen_new(*g, rows, columns);
+  // Odtwarzana sesja nie potrzebuje terminala.
+  bool console = s != NULL && replaying == false && setup_console() == true;
+  if (s == NULL || (replaying == false && console == false)
+      || wakeup_open() == false || sigaction(SIGWINCH, &action, NULL) == -1) {
+    wakeup_close();
+    screen_delete(s);
+    printf("\e[?25h"); // Przywraca kursor ukryty przez ekran.
+    fflush(stdout);
+    if (console == true) restore_console();
+    session_finish(r);
     gamma_delete(*g);
     exit(1);
   }
   
-  printf("%s", p);
-  free(p);
-  
-  if (setup_console() == false) {
-    gamma_delete(*g);
-    exit(1);
-  }
-  
-  printf("\e[?25l"); // Chowa kursor.
-  
-  while (end == false) {
- 
-    for (uint32_t j = 0; j < players; j++) { // Dla każdego gracza.
-      uint32_t i = j + 1;
-      
-      // Jeśli nie pomijam gracza.
-      if ((gamma_free_fields(*g, i) > 0 || 
-          gamma_golden_possible(*g, i) == true) && end == false) { 
-          
-        comunicate(*g, i);
-        cusor_back_to_board(x, y, width_of_field);
-        print_highlighted(*g, x, y);
-        
-        enum action c = wait_for_sign();
-        while (c == up || c == down || c == left || c == right) {
-          print_normal(*g, x, y);
-          move_cursor(c, &x, &y, width_of_field, width, height);
-          print_highlighted(*g, x, y);
-          c = wait_for_sign();
-        }
-        
-        if (c == quit) {
-          end = true;
-          print_normal(*g, x, y);
-          cursor_under_board(x, y, width_of_field);
-        }
-        
-        else {
-          if (c == normal) {
-            if(gamma_move(*g, i, x, y) == true) 
-              printf("%*u\033[%uD", width_of_field, i, width_of_field);
-          }
-          if (c == golden) {
-            if (gamma_golden_move(*g, i, x, y) == true) 
-              printf("%*u\033[%uD", width_of_field, i, width_of_field);
-          }
-          print_normal(*g, x, y);
-          cursor_under_board(x, y, width_of_field);
-        }
-        last_possible = i;
-      }
-      else {
-        if (last_possible == i) {
-          end = true;
-          print_normal(*g, x, y);
-        }
-      }
-    }
+  // Gracze, którzy nie mogą wykonać ruchu, są pomijani.
+  uint32_t i = gamma_next_player(*g, 0);
+  while (i != 0) {
+    comunicate(s, *g, i);
+    enum action c = choose(s, &keys, &x, &y, width, height);
+    
+    if (c == normal) gamma_move(*g, i, x, y);
+    if (c == golden) gamma_golden_move(*g, i, x, y);
+    screen_focus(s, x, y, false);
+    if (c == quit) break;
+    i = gamma_next_player(*g, i);
   }
   
-  printf("\033[K"); // Czyści linię.
+  screen_status(s, ""); // Czyści wiersz komunikatu.
+  screen_delete(s);
+  signal(SIGWINCH, SIG_DFL);
+  wakeup_close();
   for (uint32_t j = 0; j < players; j++) {
-    int i = j + 1;
+    uint32_t i = j + 1;
     printf("PLAYER %u %lu\n", i, gamma_busy_fields(*g, i));
   }
   printf("\e[?25h"); // Przywraca kursor.
+  fflush(stdout);
+  session_finish(r);
   
-  if (restore_console() == false) {
+  if (replaying == false && restore_console() == false) {
     gamma_delete(*g);
     exit(1);
   }
-}
\ No newline at end of file
+}
@@ -14,14 +14,19 @@
  * wypisuje na standardowe wyjście diagnostyczne komunikat @p "TERMINAL ERROR",
  * usuwa z pamięci strukturę przechowującą stan gry i kończy działanie programu
  * z kodem @p 0.
- * Jeśli okno terminala jest za małe, by wyświetlić planszę, wypisuje na
- * standardowe wyjście diagnostyczne komunikat @p "BOARD TOO BIG",
+ * Jeśli w oknie terminala nie mieści się jedno pole planszy i wiersz pod nim,
+ * wypisuje na standardowe wyjście diagnostyczne komunikat
+ * @p "TERMINAL TOO SMALL",
  * usuwa z pamięci strukturę przechowującą stan gry i kończy działanie programu
  * z kodem @p 0.
  * W przeciwnym razie wyświetla planszę, a pod planszą wiersz
- * zachęcający gracza do wykonania ruchu. Prosi o wykonanie ruchu kolejnych
- * graczy, przy czym pomija graczy, dla których funkcja @ref gamma_free_fields
- * zwróciła @p 0 i funkcja @ref gamma_golden_possible zwróciła @p false. 
+ * zachęcający gracza do wykonania ruchu. Jeśli plansza nie mieści się w oknie,
+ * wyświetlany jest tylko jej fragment, przesuwany razem z kursorem. Po zmianie
+ * rozmiaru okna (sygnał @p SIGWINCH) ekran jest wyświetlany od nowa.
+ * Prosi o wykonanie ruchu kolejnych graczy, przy czym pomija graczy, dla
+ * których funkcja @ref gamma_free_fields zwróciła @p 0 i funkcja
+ * @ref gamma_golden_possible zwróciła @p false, patrz
+ * @ref gamma_next_player.
  * Ruch wykonuje się, przesuwając kursor na wybrane pole za pomocą klawiszy ze
  * strzałkami, a następnie wciskając klawisz @p spacja, aby wykonać zwykły ruch, 
  * lub klawisz @p G, aby wykonać złoty ruch. Gracz może zrezygnować z ruchu,
@@ -29,6 +34,7 @@
  * Gra kończy się, kiedy żaden z graczy nie może wykonać ruchu lub w momencie
  * wciśnięcia kombinacji klawiszy @p Ctrl-D. Wtedy pod planszą wypisywane jest
  * podsumowanie, ile pól zajął każdy z graczy.
+ * Sesję można nagrać i odtworzyć bez terminala, patrz @ref session.h.
  * @param[in, out] g – wskaźnik na wskaźnik na strukturę przechowującą stan gry.
  */
 void interactive(gamma_t** g);
@@ -0,0 +1,135 @@
+/** @file
+ * Implementacja modułu mierzącego czasy wykonania poleceń trybu wsadowego.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+/**
+ * Liczba bitów wyznaczających przedział wewnątrz potęgi dwójki.
+ */
+#define SUB_BITS LATENCY_SUB_BITS
+
+/**
+ * Liczba przedziałów, na które dzielona jest każda potęga dwójki.
+ */
+#define SUB ((uint64_t)1 << SUB_BITS)
+
+/**
+ * Polecenia, których czasy są mierzone; ostatni histogram zawiera czasy
+ * wczytania poleceń.
+ */
+static const char commands[] = "mgbfqps";
+
+/**
+ * Liczba histogramów.
+ */
+#define HISTOGRAMS (sizeof(commands))
+
+/**
+ * Struktura przechowująca histogramy czasów wykonania poleceń.
+ */
+struct latency {
+  struct latency_histogram of[HISTOGRAMS]; ///<histogramy kolejnych poleceń
+  const char* path; ///<nazwa pliku wyjściowego lub @p NULL
+};
+
+/** @brief Podaje numer przedziału.
+ * @param[in] ns      – czas w nanosekundach.
+ * @return Numer przedziału histogramu zawierającego czas @p ns.
+ */
+static uint64_t bucket(uint64_t ns) {
+  if (ns < SUB) return ns;
+  uint64_t e = 63 - (uint64_t)__builtin_clzll(ns);
+  uint64_t mantissa = (ns >> (e - SUB_BITS)) & (SUB - 1);
+  return (e - SUB_BITS + 1) * SUB + mantissa;
+}
+
+/** @brief Podaje największy czas należący do przedziału.
+ * @param[in] index   – numer przedziału.
+ * @return Największy czas w nanosekundach należący do przedziału.
+ */
+static uint64_t bucket_high(uint64_t index) {
+  if (index < SUB) return index;
+  uint64_t shift = index / SUB - 1;
+  uint64_t low = (SUB + index % SUB) << shift;
+  return low + (((uint64_t)1 << shift) - 1);
+}
+
+void latency_add(struct latency_histogram* h, uint64_t ns) {
+  (*h).counts[bucket(ns)]++;
+  (*h).count++;
+  if (ns > (*h).max) (*h).max = ns;
+}
+
+uint64_t latency_percentile(const struct latency_histogram* h, double q) {
+  if ((*h).count == 0) return 0;
+  double exact = q * (double)(*h).count;
+  uint64_t rank = (uint64_t)exact;
+  if ((double)rank < exact || rank == 0) rank++;
+
+  uint64_t seen = 0;
+  for (uint64_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += (*h).counts[i];
+    if (seen >= rank) {
+      uint64_t high = bucket_high(i);
+      return high < (*h).max ? high : (*h).max;
+    }
+  }
+  return (*h).max;
+}
+
+latency_t* latency_start() {
+  const char* path = getenv("GAMMA_LATENCY");
+  if (path == NULL) return NULL;
+
+  latency_t* l = calloc(1, sizeof(latency_t));
+  if (l == NULL) return NULL;
+  if (strcmp(path, "") != 0 && strcmp(path, "-") != 0) (*l).path = path;
+  return l;
+}
+
+uint64_t latency_now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+void latency_record(latency_t* l, int command, uint64_t ns) {
+  if (l == NULL) return;
+  const char* p = command != 0 ? strchr(commands, command) : NULL;
+  uint64_t i = p != NULL ? (uint64_t)(p - commands) : HISTOGRAMS - 1;
+  latency_add(&((*l).of[i]), ns);
+}
+
+void latency_finish(latency_t* l) {
+  if (l == NULL) return;
+  FILE* out = (*l).path != NULL ? fopen((*l).path, "w") : stderr;
+
+  if (out != NULL) {
+    fprintf(out, "LATENCY command count p50 p99 p999 max\n");
+    for (uint64_t i = 0; i < HISTOGRAMS; i++) {
+      struct latency_histogram* h = &((*l).of[i]);
+      if (i + 1 < HISTOGRAMS) fprintf(out, "%c", commands[i]);
+      else fprintf(out, "parse");
+      fprintf(out, " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+              " %" PRIu64 "\n", (*h).count, latency_percentile(h, 0.5),
+              latency_percentile(h, 0.99), latency_percentile(h, 0.999),
+              (*h).max);
+    }
+    if (out != stderr) fclose(out);
+  }
+  free(l);
+}
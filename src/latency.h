@@ -0,0 +1,88 @@
+/** @file
+ * Interfejs modułu mierzącego czasy wykonania poleceń trybu wsadowego.
+ * Pomiary są włączane zmienną środowiskową @p GAMMA_LATENCY: wartość pusta
+ * lub @p "-" oznacza wypisanie wyników na standardowe wyjście diagnostyczne,
+ * a każda inna wartość jest nazwą pliku, do którego zostaną zapisane.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+/**
+ * Liczba bitów wyznaczających przedział wewnątrz potęgi dwójki.
+ */
+#define LATENCY_SUB_BITS 4
+
+/**
+ * Liczba przedziałów histogramu obejmujących wszystkie liczby 64-bitowe.
+ */
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+/** @brief Struktura przechowująca histogram czasów.
+ * Histogram ma logarytmiczne przedziały: każda potęga dwójki jest dzielona
+ * na 16 równych przedziałów, więc błąd względny nie przekracza 1/16, a rozmiar
+ * histogramu nie zależy od liczby pomiarów. Pusty histogram to struktura
+ * wypełniona zerami.
+ */
+struct latency_histogram {
+  uint64_t counts[LATENCY_BUCKETS]; ///<liczba pomiarów w kolejnych przedziałach
+  uint64_t count; ///<liczba pomiarów
+  uint64_t max; ///<największy zmierzony czas
+};
+
+/**
+ * Typ przechowujący histogramy czasów wykonania poleceń.
+ */
+typedef struct latency latency_t;
+
+/** @brief Dodaje pomiar do histogramu.
+ * @param[in, out] h   – wskaźnik na histogram,
+ * @param[in] ns       – czas w nanosekundach.
+ */
+void latency_add(struct latency_histogram* h, uint64_t ns);
+
+/** @brief Podaje percentyl.
+ * @param[in] h       – wskaźnik na histogram,
+ * @param[in] q       – percentyl jako ułamek z przedziału [0, 1].
+ * @return Górne ograniczenie czasu odpowiadającego percentylowi, nie większe
+ * od największego zmierzonego czasu, lub zero dla pustego histogramu.
+ */
+uint64_t latency_percentile(const struct latency_histogram* h, double q);
+
+/** @brief Rozpoczyna pomiary.
+ * Jeśli ustawiono zmienną środowiskową @p GAMMA_LATENCY, tworzy puste
+ * histogramy czasów wykonania.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, gdy pomiary są
+ * wyłączone lub nie udało się zaalokować pamięci.
+ */
+latency_t* latency_start();
+
+/** @brief Podaje bieżący czas.
+ * @return Czas zegara monotonicznego w nanosekundach.
+ */
+uint64_t latency_now();
+
+/** @brief Zapisuje czas wykonania polecenia.
+ * Dodaje czas @p ns do histogramu polecenia @p command, patrz
+ * @ref latency_histogram.
+ * @param[in, out] l   – wskaźnik na strukturę przechowującą histogramy,
+ * @param[in] command  – znak polecenia lub @p 0 dla czasu wczytania polecenia,
+ * @param[in] ns       – czas w nanosekundach.
+ */
+void latency_record(latency_t* l, int command, uint64_t ns);
+
+/** @brief Kończy pomiary.
+ * Wypisuje dla każdego polecenia liczbę pomiarów, percentyle p50, p99, p999
+ * oraz maksymalny czas w nanosekundach i usuwa strukturę wskazywaną przez
+ * @p l. Nic nie robi, jeśli wskaźnik ten ma wartość @p NULL.
+ * @param[in] l        – wskaźnik na strukturę przechowującą histogramy.
+ */
+void latency_finish(latency_t* l);
+
+#endif /* LATENCY_H */
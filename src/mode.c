@@ -29,7 +29,7 @@ enum mode choose_mode(unsigned long long* line, gamma_t** g) {
     if (c == 'B' || c == 'I') {
       bool eol = false;
       bool valid = true;
-      uint32_t width, height, players, areas;
+      uint32_t width = 0, height = 0, players = 0, areas = 0;
       
       int next_int = getchar();
       next_int = read_parameter(&eof, &eol, &valid,
@@ -0,0 +1,289 @@
+/** @file
+ * Implementacja modułu symulacji losowych rozgrywek (metoda Monte Carlo).
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#include "gamma.h"
+#include "playout.h"
+#include "random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * Liczba losowanych pól, spośród których strategia @p playout_greedy szuka
+ * pola sąsiadującego z polem gracza.
+ */
+#define GREEDY_SAMPLES 8
+
+/**
+ * Struktura przechowująca stan wątku wykonującego symulacje.
+ */
+struct worker {
+  pthread_mutex_t lock; ///<blokada chroniąca przedział rozgrywek
+  uint64_t next; ///<numer następnej rozgrywki do wykonania
+  uint64_t end; ///<numer za ostatnią rozgrywką przydzieloną wątkowi
+
+  gamma_t* base; ///<prywatna kopia stanu początkowego
+  uint64_t* normal_bitmap; ///<bitmapa legalnych ruchów
+  uint64_t* golden_bitmap; ///<bitmapa legalnych złotych ruchów
+  uint64_t* sums; ///<sumy pól zajętych przez graczy na koniec rozgrywek
+
+  struct pool* pool; ///<wskaźnik na pulę wątków
+  uint32_t id; ///<numer wątku
+};
+
+/**
+ * Struktura przechowująca pulę wątków.
+ */
+struct pool {
+  struct worker* workers; ///<tablica wątków
+  uint32_t count; ///<liczba wątków
+  const struct playout_options* options; ///<parametry symulacji
+  atomic_bool failed; ///<informacja, czy nie udało się zaalokować pamięci
+};
+
+/** @brief Podaje numer ustawionego bitu.
+ * Podaje numer @p k-tego (licząc od zera) ustawionego bitu bitmapy.
+ * @param[in] bitmap  – bitmapa,
+ * @param[in] k       – liczba mniejsza od liczby ustawionych bitów.
+ * @return Numer bitu.
+ */
+static uint64_t select_bit(const uint64_t* bitmap, uint64_t k) {
+  uint64_t word = 0;
+  uint64_t count = (uint64_t)__builtin_popcountll(bitmap[word]);
+  while (k >= count) {
+    k -= count;
+    word++;
+    count = (uint64_t)__builtin_popcountll(bitmap[word]);
+  }
+  uint64_t v = bitmap[word];
+  for (uint64_t i = 0; i < k; i++) v &= v - 1;
+  return (word << 6) + (uint64_t)__builtin_ctzll(v);
+}
+
+/** @brief Sprawdza, czy pole sąsiaduje z polem gracza.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Wartość @p true, jeśli tak, @p false w przeciwnym wypadku.
+ */
+static bool touches(gamma_t* g, uint32_t player, uint32_t x, uint32_t y) {
+  if (x > 0 && player_on_position(g, x - 1, y) == player) return true;
+  if (x + 1 < get_width(g) && player_on_position(g, x + 1, y) == player)
+    return true;
+  if (y > 0 && player_on_position(g, x, y - 1) == player) return true;
+  if (y + 1 < get_height(g) && player_on_position(g, x, y + 1) == player)
+    return true;
+  return false;
+}
+
+/** @brief Wykonuje ruch gracza w symulowanej rozgrywce.
+ * Wybiera zgodnie ze strategią @p policy i wykonuje ruch lub złoty ruch gracza
+ * @p player.
+ * @param[in, out] g     – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza,
+ * @param[in] policy     – strategia wyboru ruchu,
+ * @param[in, out] state – wskaźnik na stan generatora liczb losowych,
+ * @param[out] normal_bitmap – bitmapa pomocnicza na zwykłe ruchy,
+ * @param[out] golden_bitmap – bitmapa pomocnicza na złote ruchy.
+ * @return Wartość @p true, jeśli gracz wykonał ruch, a @p false, jeśli nie
+ * mógł go wykonać.
+ */
+static bool turn(gamma_t* g, uint32_t player, enum playout_policy policy,
+                 uint64_t* state, uint64_t* normal_bitmap,
+                 uint64_t* golden_bitmap) {
+  uint32_t width = get_width(g);
+  uint64_t normal = gamma_legal_moves(g, player, normal_bitmap);
+  uint64_t golden = 0;
+  // Strategia zachłanna używa złotego ruchu tylko wtedy, gdy nie ma innego.
+  if (policy == playout_random || normal == 0)
+    golden = gamma_legal_golden_moves(g, player, golden_bitmap);
+  if (normal + golden == 0) return false;
+
+  uint64_t k = random_below(state, normal + golden);
+  if (k >= normal) {
+    uint64_t chosen = select_bit(golden_bitmap, k - normal);
+    return gamma_golden_move(g, player, chosen % width, chosen / width);
+  }
+
+  uint64_t chosen = select_bit(normal_bitmap, k);
+  if (policy == playout_greedy) {
+    for (uint32_t i = 1; i < GREEDY_SAMPLES; i++) {
+      if (touches(g, player, chosen % width, chosen / width) == true) break;
+      chosen = select_bit(normal_bitmap, random_below(state, normal));
+    }
+  }
+  return gamma_move(g, player, chosen % width, chosen / width);
+}
+
+/** @brief Rozgrywa symulowaną rozgrywkę do końca.
+ * @param[in, out] w  – wskaźnik na wątek,
+ * @param[in] number  – numer rozgrywki.
+ * @return Wartość @p true, jeśli rozgrywka została wykonana, a @p false,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static bool playout(struct worker* w, uint64_t number) {
+  const struct playout_options* options = (*(*w).pool).options;
+  gamma_t* g = gamma_clone((*w).base);
+  if (g == NULL) return false;
+
+  uint64_t state = mix((*options).seed ^ mix(number)) | 1;
+  uint32_t players = get_players(g);
+  uint32_t player = (*options).first_player;
+  uint32_t passes = 0;
+
+  while (passes < players) { // Ktoś jeszcze może wykonać ruch.
+    if (turn(g, player, (*options).policy, &state,
+             (*w).normal_bitmap, (*w).golden_bitmap) == true)
+      passes = 0;
+    else
+      passes++;
+    player = player % players + 1;
+  }
+
+  for (uint32_t i = 1; i <= players; i++) {
+    (*w).sums[i] += gamma_busy_fields(g, i);
+  }
+  gamma_delete(g);
+  return true;
+}
+
+/** @brief Przejmuje pracę innego wątku.
+ * Przegląda pozostałe wątki i zabiera pierwszemu, który ma niewykonane
+ * rozgrywki, drugą połowę jego przedziału.
+ * @param[in, out] w  – wskaźnik na wątek.
+ * @return Wartość @p true, jeśli udało się przejąć pracę, @p false, jeśli
+ * żaden wątek nie ma już pracy.
+ */
+static bool steal(struct worker* w) {
+  struct pool* pool = (*w).pool;
+  for (uint32_t i = 1; i < (*pool).count; i++) {
+    struct worker* victim = &((*pool).workers[((*w).id + i) % (*pool).count]);
+
+    pthread_mutex_lock(&((*victim).lock));
+    uint64_t left = (*victim).end - (*victim).next;
+    if (left > 0) {
+      uint64_t end = (*victim).end;
+      uint64_t mid = end - (left + 1) / 2;
+      (*victim).end = mid;
+      pthread_mutex_unlock(&((*victim).lock));
+      
+      pthread_mutex_lock(&((*w).lock));
+      (*w).next = mid;
+      (*w).end = end;
+      pthread_mutex_unlock(&((*w).lock));
+      return true;
+    }
+    pthread_mutex_unlock(&((*victim).lock));
+  }
+  return false;
+}
+
+/** @brief Wykonuje pracę wątku.
+ * Wykonuje kolejne rozgrywki ze swojego przedziału, a po jego wyczerpaniu
+ * przejmuje pracę innych wątków.
+ * @param[in, out] arg – wskaźnik na wątek.
+ * @return Wartość @p NULL.
+ */
+static void* work(void* arg) {
+  struct worker* w = arg;
+
+  while (atomic_load(&((*(*w).pool).failed)) == false) {
+    pthread_mutex_lock(&((*w).lock));
+    bool has = (*w).next < (*w).end;
+    uint64_t number = (*w).next;
+    if (has == true) (*w).next++;
+    pthread_mutex_unlock(&((*w).lock));
+
+    if (has == false) {
+      if (steal(w) == false) break;
+      continue;
+    }
+    if (playout(w, number) == false) atomic_store(&((*(*w).pool).failed), true);
+  }
+  return NULL;
+}
+
+bool gamma_playouts(gamma_t *g, const struct playout_options *options,
+                    double *expected) {
+  if (g == NULL || options == NULL || expected == NULL) return false;
+  uint32_t players = get_players(g);
+  if ((*options).first_player <= 0 || (*options).first_player > players)
+    return false;
+
+  struct pool pool;
+  pool.count = (*options).threads > 0 ? (*options).threads : 1;
+  pool.options = options;
+  atomic_init(&(pool.failed), false);
+  pool.workers = calloc(pool.count, sizeof(struct worker));
+  if (pool.workers == NULL) return false;
+
+  uint64_t words = gamma_bitmap_words(g);
+  uint32_t ready = 0;
+  for (; ready < pool.count; ready++) {
+    struct worker* w = &(pool.workers[ready]);
+    (*w).pool = &pool;
+    (*w).id = ready;
+    (*w).next = (*options).playouts * ready / pool.count;
+    (*w).end = (*options).playouts * (ready + 1) / pool.count;
+    (*w).base = gamma_clone(g);
+    (*w).normal_bitmap = malloc(sizeof(uint64_t) * words);
+    (*w).golden_bitmap = malloc(sizeof(uint64_t) * words);
+    (*w).sums = calloc((uint64_t)players + 1, sizeof(uint64_t));
+    if ((*w).base == NULL || (*w).normal_bitmap == NULL 
+        || (*w).golden_bitmap == NULL || (*w).sums == NULL
+        || pthread_mutex_init(&((*w).lock), NULL) != 0) {
+      gamma_delete((*w).base);
+      free((*w).normal_bitmap);
+      free((*w).golden_bitmap);
+      free((*w).sums);
+      atomic_store(&(pool.failed), true);
+      break;
+    }
+  }
+
+  pthread_t* threads = calloc(pool.count, sizeof(pthread_t));
+  bool* started = calloc(pool.count, sizeof(bool));
+  if (threads == NULL || started == NULL) atomic_store(&(pool.failed), true);
+
+  if (atomic_load(&(pool.failed)) == false) {
+    // Wątek wywołujący jest wątkiem numer 0; pracę wątków, których nie udało
+    // się uruchomić, przejmą pozostałe.
+    for (uint32_t i = 1; i < pool.count; i++) {
+      started[i] = pthread_create(&(threads[i]), NULL, work,
+                                  &(pool.workers[i])) == 0;
+    }
+    work(&(pool.workers[0]));
+    for (uint32_t i = 1; i < pool.count; i++) {
+      if (started[i] == true) pthread_join(threads[i], NULL);
+    }
+  }
+
+  bool result = atomic_load(&(pool.failed)) == false;
+  for (uint32_t i = 1; i <= players && result == true; i++) {
+    uint64_t sum = 0;
+    for (uint32_t j = 0; j < pool.count; j++) sum += pool.workers[j].sums[i];
+    expected[i] = (*options).playouts > 0 ?
+                  (double)sum / (double)(*options).playouts : 0;
+  }
+
+  for (uint32_t i = 0; i < ready; i++) {
+    gamma_delete(pool.workers[i].base);
+    free(pool.workers[i].normal_bitmap);
+    free(pool.workers[i].golden_bitmap);
+    free(pool.workers[i].sums);
+    pthread_mutex_destroy(&(pool.workers[i].lock));
+  }
+  free(pool.workers);
+  free(threads);
+  free(started);
+  return result;
+}
@@ -0,0 +1,58 @@
+/** @file
+ * Interfejs modułu symulacji losowych rozgrywek (metoda Monte Carlo).
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef PLAYOUT_H
+#define PLAYOUT_H
+
+#include "gamma.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Strategia wyboru ruchu.
+ * Typ wyliczeniowy reprezentujący sposób wybierania ruchów w symulowanej
+ * rozgrywce.
+ */
+enum playout_policy {
+  playout_random, ///<jednostajnie losowy legalny ruch lub złoty ruch
+  playout_greedy  ///<preferuje pola sąsiadujące z własnymi, złoty ruch na końcu
+};
+
+/** @brief Parametry symulacji.
+ * Struktura przechowująca parametry funkcji @ref gamma_playouts.
+ */
+struct playout_options {
+  uint64_t playouts; ///<liczba symulowanych rozgrywek
+  uint32_t threads; ///<liczba wątków, wartość @p 0 oznacza jeden wątek
+  uint64_t seed; ///<ziarno generatora liczb losowych
+  enum playout_policy policy; ///<strategia wyboru ruchów
+  uint32_t first_player; ///<numer gracza wykonującego pierwszy ruch
+};
+
+/** @brief Szacuje wynik gry metodą Monte Carlo.
+ * Rozgrywa do końca @p playouts symulowanych rozgrywek, zaczynając od stanu
+ * gry @p g. Gracze wykonują ruchy kolejno, zaczynając od gracza
+ * @p first_player; gracz, który nie może wykonać ani ruchu, ani złotego ruchu,
+ * jest pomijany, a rozgrywka kończy się, gdy żaden gracz nie może wykonać
+ * ruchu. Rozgrywki są rozdzielane między wątki, które po wyczerpaniu swojej
+ * pracy przejmują połowę pozostałej pracy innych wątków. Każda rozgrywka
+ * działa na kopii gry utworzonej funkcją @ref gamma_clone i korzysta z własnego
+ * ziarna, więc wynik zależy tylko od parametrów, a nie od liczby wątków.
+ * Stan gry @p g nie jest zmieniany.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] options    – wskaźnik na parametry symulacji,
+ * @param[out] expected  – wskaźnik na tablicę o rozmiarze @p players + 1,
+ *                         w której pod indeksem @p i zostanie zapisana średnia
+ *                         liczba pól zajętych na koniec gry przez gracza @p i.
+ * @return Wartość @p true, jeśli symulacje zostały wykonane, a @p false,
+ * gdy któryś z parametrów jest niepoprawny lub nie udało się zaalokować
+ * pamięci.
+ */
+bool gamma_playouts(gamma_t *g, const struct playout_options *options,
+                    double *expected);
+
+#endif /* PLAYOUT_H */
@@ -0,0 +1,157 @@
+/** @file
+ * Implementacja programu szacującego wynik gry gamma metodą Monte Carlo.
+ * Program wczytuje ze standardowego wejścia pozycję w formacie trybu
+ * wsadowego: wiersz @p "B width height players areas", a następnie wiersze
+ * @p "m player x y" i @p "g player x y" opisujące wykonane ruchy. Wiersze
+ * puste i zaczynające się znakiem @p '#' są pomijane. Dla każdego gracza
+ * wypisuje wiersz @p "PLAYER i expected".
+ *
+ * Opcje: @p -n liczba rozgrywek, @p -t liczba wątków, @p -s ziarno,
+ * @p -p numer gracza wykonującego pierwszy ruch, @p -g strategia zachłanna.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#include "gamma.h"
+#include "playout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** Maksymalna długość wczytywanego wiersza. */
+#define LINE_SIZE 256
+
+/** @brief Wczytuje liczbę z argumentu programu.
+ * @param[in] text     – tekst argumentu,
+ * @param[in] max      – największa dopuszczalna wartość,
+ * @param[out] target  – wskaźnik na liczbę, do której zostanie zapisany wynik.
+ * @return Wartość @p true, jeśli argument jest poprawną liczbą nie większą
+ * niż @p max, a @p false w przeciwnym przypadku.
+ */
+static bool parse_number(const char* text, uint64_t max, uint64_t* target) {
+  if (text == NULL || *text == '\0') return false;
+  uint64_t value = 0;
+  for (; *text != '\0'; text++) {
+    if (*text < '0' || *text > '9') return false;
+    if (value > (max - (uint64_t)(*text - '0')) / 10) return false;
+    value = value * 10 + (uint64_t)(*text - '0');
+  }
+  *target = value;
+  return true;
+}
+
+/** @brief Wczytuje opcje programu.
+ * @param[in] argc      – liczba argumentów,
+ * @param[in] argv      – argumenty programu,
+ * @param[out] options  – wskaźnik na parametry symulacji.
+ * @return Wartość @p true, jeśli opcje są poprawne, a @p false w przeciwnym
+ * przypadku.
+ */
+static bool parse_options(int argc, char* argv[],
+                          struct playout_options* options) {
+  (*options).playouts = 1000;
+  (*options).threads = 1;
+  (*options).seed = 1;
+  (*options).policy = playout_random;
+  (*options).first_player = 1;
+
+  for (int i = 1; i < argc; i++) {
+    uint64_t value;
+    if (strcmp(argv[i], "-g") == 0) {
+      (*options).policy = playout_greedy;
+      continue;
+    }
+    if (i + 1 >= argc) return false;
+    if (strcmp(argv[i], "-n") == 0) {
+      if (parse_number(argv[++i], UINT64_MAX, &value) == false) return false;
+      (*options).playouts = value;
+    }
+    else if (strcmp(argv[i], "-t") == 0) {
+      if (parse_number(argv[++i], UINT32_MAX, &value) == false) return false;
+      (*options).threads = (uint32_t)value;
+    }
+    else if (strcmp(argv[i], "-s") == 0) {
+      if (parse_number(argv[++i], UINT64_MAX, &value) == false) return false;
+      (*options).seed = value;
+    }
+    else if (strcmp(argv[i], "-p") == 0) {
+      if (parse_number(argv[++i], UINT32_MAX, &value) == false) return false;
+      (*options).first_player = (uint32_t)value;
+    }
+    else return false;
+  }
+  return true;
+}
+
+/** @brief Wczytuje pozycję.
+ * Tworzy grę opisaną pierwszym poleceniem @p B i wykonuje na niej kolejne
+ * ruchy. Każdy ruch musi się udać.
+ * @return Wskaźnik na strukturę przechowującą stan gry lub @p NULL, gdy
+ * wejście jest niepoprawne.
+ */
+static gamma_t* read_position() {
+  char line[LINE_SIZE];
+  gamma_t* g = NULL;
+
+  while (fgets(line, LINE_SIZE, stdin) != NULL) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+    char c = 0;
+    uint32_t a, b, d, e;
+    int n = sscanf(line, " %c %" SCNu32 " %" SCNu32 " %" SCNu32 " %" SCNu32,
+                   &c, &a, &b, &d, &e);
+    bool valid = false;
+    if (g == NULL && c == 'B' && n == 5) {
+      g = gamma_new(a, b, d, e);
+      valid = g != NULL;
+    }
+    else if (g != NULL && c == 'm' && n == 4) {
+      valid = gamma_move(g, a, b, d);
+    }
+    else if (g != NULL && c == 'g' && n == 4) {
+      valid = gamma_golden_move(g, a, b, d);
+    }
+    if (valid == false) {
+      gamma_delete(g);
+      return NULL;
+    }
+  }
+  return g;
+}
+
+/** @brief Szacuje wynik gry.
+ * Wczytuje opcje i pozycję, przeprowadza symulacje i wypisuje ich wynik.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty programu.
+ * @return Zero, gdy symulacje się powiodły, a @p 1 w przeciwnym przypadku.
+ */
+int main(int argc, char* argv[]) {
+  struct playout_options options;
+  if (parse_options(argc, argv, &options) == false) {
+    fprintf(stderr, "usage: %s [-n playouts] [-t threads] [-s seed] "
+                    "[-p first_player] [-g]\n", argv[0]);
+    return 1;
+  }
+
+  gamma_t* g = read_position();
+  if (g == NULL) {
+    fprintf(stderr, "ERROR position\n");
+    return 1;
+  }
+
+  uint32_t players = get_players(g);
+  double* expected = malloc(sizeof(double) * ((uint64_t)players + 1));
+  bool result = expected != NULL && gamma_playouts(g, &options, expected);
+  if (result == true) {
+    for (uint32_t i = 1; i <= players; i++) {
+      printf("PLAYER %" PRIu32 " %.6f\n", i, expected[i]);
+    }
+  }
+  else fprintf(stderr, "ERROR playouts\n");
+
+  free(expected);
+  gamma_delete(g);
+  return result == true ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+/** @file
+ * Generatory liczb pseudolosowych wspólne dla silnika i programów
+ * pomocniczych. Funkcje są zdefiniowane w pliku nagłówkowym, żeby mogły
+ * z nich korzystać również programy, które nie są łączone z biblioteką.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/** @brief Miesza bity liczby.
+ * Funkcja mieszająca z generatora SplitMix64.
+ * @param[in] x       – liczba.
+ * @return Liczba o wymieszanych bitach.
+ */
+static inline uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/** @brief Losuje liczbę.
+ * Generator xorshift64*.
+ * @param[in, out] state – wskaźnik na niezerowy stan generatora.
+ * @return Liczba pseudolosowa.
+ */
+static inline uint64_t next_random(uint64_t* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545f4914f6cdd1dULL;
+}
+
+/** @brief Losuje liczbę z przedziału.
+ * @param[in, out] state – wskaźnik na niezerowy stan generatora,
+ * @param[in] n          – liczba dodatnia.
+ * @return Liczba pseudolosowa z przedziału [0, @p n).
+ */
+static inline uint64_t random_below(uint64_t* state, uint64_t n) {
+  return next_random(state) % n;
+}
+
+#endif /* RANDOM_H */
@@ -0,0 +1,379 @@
+/** @file
+ * Implementacja modułu wyświetlającego planszę w trybie interaktywnym.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#include "screen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+/**
+ * Rozmiar bufora komunikatu razem z kończącym znakiem @p '\0'.
+ */
+#define STATUS_SIZE 96
+
+/**
+ * Wygląd pola, które nie jest jeszcze wyświetlone.
+ */
+#define NOT_SHOWN 2
+
+/**
+ * Struktura przechowująca stan wyświetlanego pola.
+ */
+struct cell {
+  uint32_t player; ///<numer gracza na polu lub @p 0
+  uint8_t look;
+  ///<@p 1 dla negatywu, @p 0 dla zwykłego pola, @ref NOT_SHOWN dla pustego
+};
+
+/** @brief Struktura przechowująca bufory ekranu.
+ * Bufory opisują widoczny fragment planszy: @p view_width kolumn od kolumny
+ * @p left i @p view_height wierszy od wiersza @p bottom, wierszami terminala
+ * od górnego. Pod nim leży wiersz komunikatu.
+ */
+struct screen {
+  gamma_t* g; ///<wskaźnik na strukturę przechowującą stan gry
+  uint32_t width; ///<szerokość planszy
+  uint32_t height; ///<wysokość planszy
+  uint32_t field; ///<szerokość jednego pola w znakach
+  uint32_t columns; ///<liczba kolumn terminala
+  uint32_t view_width; ///<liczba widocznych kolumn planszy
+  uint32_t view_height; ///<liczba widocznych wierszy planszy
+  uint32_t left; ///<numer pierwszej widocznej kolumny planszy
+  uint32_t bottom; ///<numer pierwszego widocznego wiersza planszy
+  uint32_t focus_x; ///<numer kolumny wyróżnionego pola
+  uint32_t focus_y; ///<numer wiersza wyróżnionego pola
+  bool highlighted; ///<informacja, czy pole jest wyświetlane w negatywie
+
+  struct cell* front; ///<pola wyświetlone w terminalu
+  struct cell* back; ///<pola do wyświetlenia
+  uint64_t* dirty; ///<indeksy pól zmienionych w tylnym buforze
+  uint64_t dirty_count; ///<liczba pól zmienionych w tylnym buforze
+  bool* queued; ///<informacja, czy pole jest w tablicy @p dirty
+  uint32_t* line; ///<numery graczy na widocznych polach wiersza planszy
+  char front_status[STATUS_SIZE]; ///<wyświetlony komunikat
+  char back_status[STATUS_SIZE]; ///<komunikat do wyświetlenia
+
+  char* out; ///<dane do wysłania do terminala
+  size_t out_length; ///<liczba bajtów w @p out
+  size_t out_size; ///<rozmiar @p out
+  bool failed; ///<informacja, czy nie udało się zaalokować pamięci
+  uint64_t written; ///<liczba bajtów wysłanych do terminala
+  uint32_t row; ///<wiersz kursora w terminalu, od @p 1, lub @p 0
+  uint32_t column; ///<kolumna kursora w terminalu, od @p 1
+  bool reverse; ///<informacja, czy włączony jest atrybut negatywu
+};
+
+/** @brief Dopisuje dane do wysłania do terminala.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] format  – format napisu jak dla funkcji @p printf,
+ * @param[in] ...     – argumenty formatu.
+ */
+static void emit(screen_t* s, const char* format, ...) {
+  char text[128];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (n < 0 || (*s).failed == true) return;
+  size_t length = (size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1;
+
+  if ((*s).out_length + length > (*s).out_size) {
+    size_t size = 2 * (*s).out_size + length + 256;
+    char* temp = realloc((*s).out, size);
+    if (temp == NULL) {
+      (*s).failed = true;
+      return;
+    }
+    (*s).out = temp;
+    (*s).out_size = size;
+  }
+  memcpy((*s).out + (*s).out_length, text, length);
+  (*s).out_length += length;
+}
+
+/** @brief Ustawia kursor terminala.
+ * Wysyła sekwencję sterującą tylko wtedy, gdy kursor jest gdzie indziej.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] row     – numer wiersza terminala, od @p 1,
+ * @param[in] column  – numer kolumny terminala, od @p 1.
+ */
+static void go_to(screen_t* s, uint32_t row, uint32_t column) {
+  if ((*s).row == row && (*s).column == column) return;
+  emit(s, "\033[%u;%uH", row, column);
+  (*s).row = row;
+  (*s).column = column;
+}
+
+/** @brief Ustawia atrybut negatywu.
+ * Wysyła sekwencję sterującą tylko wtedy, gdy atrybut się zmienia.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] reverse – informacja, czy atrybut ma być włączony.
+ */
+static void set_reverse(screen_t* s, bool reverse) {
+  if ((*s).reverse == reverse) return;
+  emit(s, reverse == true ? "\033[7m" : "\033[0m");
+  (*s).reverse = reverse;
+}
+
+/** @brief Podaje indeks widocznego pola w buforach.
+ * @param[in] s       – wskaźnik na bufory ekranu,
+ * @param[in] x       – numer kolumny planszy,
+ * @param[in] y       – numer wiersza planszy,
+ * @param[out] i      – wskaźnik na indeks pola.
+ * @return Wartość @p true, jeśli pole (@p x, @p y) jest widoczne, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool visible(screen_t* s, uint32_t x, uint32_t y, uint64_t* i) {
+  if (x < (*s).left || x - (*s).left >= (*s).view_width
+      || y < (*s).bottom || y - (*s).bottom >= (*s).view_height) return false;
+  uint64_t row = (*s).view_height - 1 - (y - (*s).bottom);
+  *i = row * (*s).view_width + (x - (*s).left);
+  return true;
+}
+
+/** @brief Zapisuje pole w tylnym buforze.
+ * Zapisuje numer gracza na widocznym polu (@p x, @p y) i dodaje je
+ * do zmienionych.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] i       – indeks pola w buforze,
+ * @param[in] x       – numer kolumny planszy,
+ * @param[in] y       – numer wiersza planszy,
+ * @param[in] player  – numer gracza na polu lub @p 0.
+ */
+static void store(screen_t* s, uint64_t i, uint32_t x, uint32_t y,
+                  uint32_t player) {
+  bool focused = x == (*s).focus_x && y == (*s).focus_y;
+  (*s).back[i] = (struct cell){player,
+                               focused == true && (*s).highlighted == true};
+  if ((*s).queued[i] == false) {
+    (*s).queued[i] = true;
+    (*s).dirty[(*s).dirty_count++] = i;
+  }
+}
+
+/** @brief Zmienia pole w tylnym buforze.
+ * Odczytuje numer gracza na polu (@p x, @p y) i dodaje je do zmienionych.
+ * Nic nie robi, jeśli pole nie jest widoczne.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] x       – numer kolumny planszy,
+ * @param[in] y       – numer wiersza planszy.
+ */
+static void put(screen_t* s, uint32_t x, uint32_t y) {
+  uint64_t i;
+  if (visible(s, x, y, &i) == false) return;
+  store(s, i, x, y, player_on_position((*s).g, x, y));
+}
+
+/** @brief Wypełnia tylny bufor.
+ * Odczytuje wszystkie widoczne pola planszy, w kolejności wyświetlania,
+ * po jednym wierszu planszy na wywołanie funkcji @ref gamma_cells.
+ * @param[in, out] s  – wskaźnik na bufory ekranu.
+ */
+static void fill(screen_t* s) {
+  for (uint32_t r = (*s).view_height; r-- > 0;) {
+    uint32_t y = (*s).bottom + r;
+    uint64_t i = (uint64_t)((*s).view_height - 1 - r) * (*s).view_width;
+    gamma_cells((*s).g, (*s).left, y, (*s).view_width, (*s).line);
+    for (uint32_t c = 0; c < (*s).view_width; c++)
+      store(s, i + c, (*s).left + c, y, (*s).line[c]);
+  }
+}
+
+/** @brief Podaje początek widocznego przedziału.
+ * @param[in] start   – dotychczasowy początek przedziału,
+ * @param[in] length  – długość przedziału, liczba dodatnia,
+ * @param[in] total   – długość całego zakresu, niemniejsza od @p length,
+ * @param[in] p       – pozycja, która ma być widoczna.
+ * @return Nowy początek przedziału: dotychczasowy, jeśli zawiera on @p p,
+ * a w przeciwnym przypadku taki, że @p p leży w środku przedziału.
+ */
+static uint32_t follow(uint32_t start, uint32_t length, uint32_t total,
+                       uint32_t p) {
+  if (start > total - length) start = total - length;
+  if (p >= start && p - start < length) return start;
+  start = p > length / 2 ? p - length / 2 : 0;
+  return start > total - length ? total - length : start;
+}
+
+/** @brief Przesuwa widoczny fragment planszy do wyróżnionego pola.
+ * Jeśli wyróżnione pole nie jest widoczne, przesuwa fragment tak, by leżało
+ * w jego środku, i wypełnia tylny bufor na nowo.
+ * @param[in, out] s  – wskaźnik na bufory ekranu.
+ */
+static void scroll(screen_t* s) {
+  uint32_t left = follow((*s).left, (*s).view_width, (*s).width,
+                         (*s).focus_x);
+  uint32_t bottom = follow((*s).bottom, (*s).view_height, (*s).height,
+                           (*s).focus_y);
+  if (left == (*s).left && bottom == (*s).bottom) return;
+  (*s).left = left;
+  (*s).bottom = bottom;
+  fill(s);
+}
+
+screen_t* screen_new(gamma_t* g, uint32_t rows, uint32_t columns) {
+  screen_t* s = calloc(1, sizeof(screen_t));
+  if (s == NULL) return NULL;
+  (*s).g = g;
+  (*s).width = get_width(g);
+  (*s).height = get_height(g);
+  (*s).field = get_width_of_field(g);
+  fflush(stdout);
+  if (screen_resize(s, rows, columns) == false) {
+    screen_delete(s);
+    return NULL;
+  }
+  return s;
+}
+
+bool screen_resize(screen_t* s, uint32_t rows, uint32_t columns) {
+  uint32_t view_width = columns / (*s).field;
+  uint32_t view_height = rows > 0 ? rows - 1 : 0;
+  if (view_width == 0 || view_height == 0) return false;
+  if (view_width > (*s).width) view_width = (*s).width;
+  if (view_height > (*s).height) view_height = (*s).height;
+
+  uint64_t cells = (uint64_t)view_width * view_height;
+  struct cell* front = malloc(sizeof(struct cell) * cells);
+  struct cell* back = malloc(sizeof(struct cell) * cells);
+  uint64_t* dirty = malloc(sizeof(uint64_t) * cells);
+  bool* queued = calloc(cells, sizeof(bool));
+  uint32_t* line = malloc(sizeof(uint32_t) * view_width);
+  if (front == NULL || back == NULL || dirty == NULL || queued == NULL
+      || line == NULL) {
+    free(front);
+    free(back);
+    free(dirty);
+    free(queued);
+    free(line);
+    return false;
+  }
+  free((*s).front);
+  free((*s).back);
+  free((*s).dirty);
+  free((*s).queued);
+  free((*s).line);
+  (*s).front = front;
+  (*s).back = back;
+  (*s).dirty = dirty;
+  (*s).queued = queued;
+  (*s).line = line;
+  (*s).dirty_count = 0;
+  for (uint64_t i = 0; i < cells; i++)
+    (*s).front[i] = (struct cell){0, NOT_SHOWN};
+  (*s).columns = columns;
+  (*s).view_width = view_width;
+  (*s).view_height = view_height;
+
+  // Czyszczę ekran, więc wszystko trzeba wyświetlić od nowa.
+  (*s).reverse = false;
+  emit(s, "\033[0m\033[1;1H\033[2J\033[?25l");
+  (*s).row = 1;
+  (*s).column = 1;
+  (*s).front_status[0] = '\0';
+  (*s).left = follow((*s).left, view_width, (*s).width, (*s).focus_x);
+  (*s).bottom = follow((*s).bottom, view_height, (*s).height, (*s).focus_y);
+  fill(s);
+  return true;
+}
+
+void screen_focus(screen_t* s, uint32_t x, uint32_t y, bool highlighted) {
+  uint32_t old_x = (*s).focus_x, old_y = (*s).focus_y;
+  (*s).focus_x = x;
+  (*s).focus_y = y;
+  (*s).highlighted = highlighted;
+  put(s, old_x, old_y);
+  scroll(s);
+  put(s, x, y);
+}
+
+void screen_refresh(screen_t* s, uint32_t x, uint32_t y) {
+  put(s, x, y);
+}
+
+void screen_status(screen_t* s, const char* text) {
+  snprintf((*s).back_status, STATUS_SIZE, "%s", text);
+}
+
+/** @brief Wysyła dane do terminala.
+ * @param[in, out] s  – wskaźnik na bufory ekranu.
+ * @return Wartość @p true, jeśli wszystkie dane zostały zapisane, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool send(screen_t* s) {
+  size_t done = 0;
+  while (done < (*s).out_length) {
+    ssize_t n = write(STDOUT_FILENO, (*s).out + done, (*s).out_length - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    done += (size_t)n;
+  }
+  (*s).written += done;
+  bool result = done == (*s).out_length && (*s).failed == false;
+  (*s).out_length = 0;
+  (*s).failed = false;
+  return result;
+}
+
+bool screen_draw(screen_t* s) {
+  for (uint64_t k = 0; k < (*s).dirty_count; k++) {
+    uint64_t i = (*s).dirty[k];
+    (*s).queued[i] = false;
+    struct cell* f = &((*s).front[i]);
+    struct cell* b = &((*s).back[i]);
+    if ((*f).player == (*b).player && (*f).look == (*b).look) continue;
+
+    uint32_t column = (uint32_t)(i % (*s).view_width);
+    uint32_t row = (uint32_t)(i / (*s).view_width);
+    go_to(s, row + 1, column * (*s).field + 1);
+    set_reverse(s, (*b).look == 1);
+    if ((*b).player != 0) emit(s, "%*u", (int)(*s).field, (*b).player);
+    else emit(s, "%*c", (int)(*s).field, '.');
+    (*s).column += (*s).field;
+    *f = *b;
+  }
+  (*s).dirty_count = 0;
+
+  if (strcmp((*s).front_status, (*s).back_status) != 0) {
+    // Komunikat nie może być szerszy niż terminal.
+    int length = (int)strlen((*s).back_status);
+    if ((uint32_t)length >= (*s).columns) length = (int)(*s).columns - 1;
+    go_to(s, (*s).view_height + 1, 1);
+    set_reverse(s, false);
+    emit(s, "%.*s\033[K", length, (*s).back_status); // Czyści resztę wiersza.
+    (*s).column += (uint32_t)length;
+    memcpy((*s).front_status, (*s).back_status, STATUS_SIZE);
+  }
+  return send(s);
+}
+
+uint64_t screen_written(screen_t* s) {
+  return (*s).written;
+}
+
+void screen_delete(screen_t* s) {
+  if (s == NULL) return;
+  if ((*s).front != NULL) {
+    screen_draw(s);
+    go_to(s, (*s).view_height + 1, 1);
+    set_reverse(s, false);
+    send(s);
+  }
+  free((*s).front);
+  free((*s).back);
+  free((*s).dirty);
+  free((*s).queued);
+  free((*s).line);
+  free((*s).out);
+  free(s);
+}
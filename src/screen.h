@@ -0,0 +1,112 @@
+/** @file
+ * Interfejs modułu wyświetlającego planszę w trybie interaktywnym.
+ * Moduł przechowuje dwa bufory ekranu: przedni, opisujący to, co widać
+ * w terminalu, i tylny, opisujący to, co ma być widać. Zmiany są wprowadzane
+ * do tylnego bufora, a funkcja @ref screen_draw wysyła do terminala tylko
+ * sekwencje sterujące i znaki zmienionych pól, jednym wywołaniem funkcji
+ * @p write.
+ *
+ * Bufory obejmują tylko widoczny fragment planszy, mieszczący się w oknie
+ * terminala razem z wierszem komunikatu, więc koszt wyświetlania zależy od
+ * rozmiaru okna, a nie planszy. Fragment przesuwa się tak, by wyróżnione pole
+ * było zawsze widoczne.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "gamma.h"
+
+/**
+ * Typ przechowujący bufory ekranu.
+ */
+typedef struct screen screen_t;
+
+/** @brief Tworzy bufory ekranu.
+ * Czyści ekran terminala i chowa kursor. Tylny bufor opisuje widoczny
+ * fragment planszy gry @p g, zaczynający się w jej lewym dolnym rogu, i pusty
+ * wiersz komunikatu pod nim, a przedni pusty ekran, więc pierwsze wywołanie
+ * funkcji @ref screen_draw wyświetla cały fragment.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] rows    – liczba wierszy okna terminala,
+ * @param[in] columns – liczba kolumn okna terminala.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, jeśli w oknie nie
+ * mieści się jedno pole planszy i wiersz komunikatu lub nie udało się
+ * zaalokować pamięci.
+ */
+screen_t* screen_new(gamma_t* g, uint32_t rows, uint32_t columns);
+
+/** @brief Zmienia rozmiar okna terminala.
+ * Wywoływana po zmianie rozmiaru okna. Czyści ekran terminala i wypełnia tylny
+ * bufor na nowo, tak by wyróżnione pole pozostało widoczne. Następne wywołanie
+ * funkcji @ref screen_draw wyświetla cały fragment planszy i komunikat.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] rows    – liczba wierszy okna terminala,
+ * @param[in] columns – liczba kolumn okna terminala.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli w oknie nie
+ * mieści się jedno pole planszy i wiersz komunikatu lub nie udało się
+ * zaalokować pamięci. Wtedy bufory się nie zmieniają.
+ */
+bool screen_resize(screen_t* s, uint32_t rows, uint32_t columns);
+
+/** @brief Zmienia wyróżnione pole.
+ * Przywraca zwykły wygląd poprzednio wyróżnionego pola i ustawia w tylnym
+ * buforze pole (@p x, @p y). Jeśli nie jest ono widoczne, przesuwa widoczny
+ * fragment planszy tak, by leżało w jego środku.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] x       – numer kolumny pola, liczba mniejsza od szerokości
+ *                      planszy,
+ * @param[in] y       – numer wiersza pola, liczba mniejsza od wysokości
+ *                      planszy,
+ * @param[in] highlighted – informacja, czy pole jest wyświetlane w negatywie.
+ */
+void screen_focus(screen_t* s, uint32_t x, uint32_t y, bool highlighted);
+
+/** @brief Odczytuje pole planszy.
+ * Wywoływana po zmianie pola (@p x, @p y) w grze. Ustawia w tylnym buforze
+ * aktualny numer gracza na polu. Nic nie robi, jeśli pole nie jest widoczne.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] x       – numer kolumny pola,
+ * @param[in] y       – numer wiersza pola.
+ */
+void screen_refresh(screen_t* s, uint32_t x, uint32_t y);
+
+/** @brief Zmienia wiersz komunikatu w tylnym buforze.
+ * Dłuższe komunikaty są obcinane do 95 znaków, a przy wyświetlaniu do
+ * szerokości okna terminala.
+ * @param[in, out] s  – wskaźnik na bufory ekranu,
+ * @param[in] text    – komunikat wyświetlany pod planszą.
+ */
+void screen_status(screen_t* s, const char* text);
+
+/** @brief Wyświetla zmiany.
+ * Wysyła do terminala jednym wywołaniem funkcji @p write sekwencje sterujące
+ * i znaki pól oraz komunikatu, które różnią się w buforach, i kopiuje je do
+ * przedniego bufora. Kursor jest przesuwany tylko wtedy, gdy kolejne zmienione
+ * pole nie leży tuż za poprzednim, a atrybut negatywu jest zmieniany tylko
+ * wtedy, gdy się różni.
+ * @param[in, out] s  – wskaźnik na bufory ekranu.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli nie udało się
+ * zaalokować pamięci lub zapisać danych do terminala.
+ */
+bool screen_draw(screen_t* s);
+
+/** @brief Podaje liczbę bajtów wysłanych do terminala.
+ * @param[in] s       – wskaźnik na bufory ekranu.
+ * @return Liczba bajtów wysłanych do terminala od utworzenia buforów.
+ */
+uint64_t screen_written(screen_t* s);
+
+/** @brief Usuwa bufory ekranu.
+ * Wyświetla zmiany, ustawia kursor na początku wiersza komunikatu, przywraca
+ * zwykłe atrybuty i usuwa strukturę wskazywaną przez @p s. Nic nie robi,
+ * jeśli wskaźnik ten ma wartość @p NULL.
+ * @param[in] s       – wskaźnik na bufory ekranu.
+ */
+void screen_delete(screen_t* s);
+
+#endif /* SCREEN_H */
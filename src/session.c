@@ -0,0 +1,271 @@
+/** @file
+ * Implementacja modułu nagrywającego i odtwarzającego sesje trybu
+ * interaktywnego.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#include "session.h"
+#include "latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * Rozmiar bufora na jeden wiersz nagrania.
+ */
+#define LINE_SIZE (2 * SESSION_CHUNK + 64)
+
+/**
+ * Struktura przechowująca zdarzenie nagrania.
+ */
+struct event {
+  uint64_t at; ///<czas zdarzenia od rozpoczęcia sesji w nanosekundach
+  bool resize; ///<informacja, czy zdarzenie jest zmianą rozmiaru okna
+  uint32_t rows; ///<liczba wierszy okna
+  uint32_t columns; ///<liczba kolumn okna
+  unsigned char data[SESSION_CHUNK]; ///<porcja znaków
+  size_t length; ///<liczba znaków w porcji
+};
+
+/**
+ * Struktura przechowująca ustawienia i stan sesji.
+ */
+struct session {
+  FILE* record; ///<plik tworzonego nagrania lub @p NULL
+  FILE* replay; ///<plik odtwarzanego nagrania lub @p NULL
+  uint64_t start; ///<czas zegara monotonicznego na początku nagrywania
+  uint64_t clock; ///<czas odtwarzanej sesji w nanosekundach
+  struct event next; ///<następne zdarzenie odtwarzanego nagrania
+  bool has_next; ///<informacja, czy nagranie ma następne zdarzenie
+  bool fixed; ///<informacja, czy rozmiar okna ustala @p GAMMA_SIZE
+  bool resized; ///<informacja, czy zmienił się rozmiar okna
+  uint32_t rows; ///<liczba wierszy okna odtwarzanej sesji
+  uint32_t columns; ///<liczba kolumn okna odtwarzanej sesji
+
+  uint64_t keys; ///<liczba wciśniętych klawiszy
+  uint64_t frames; ///<liczba wyświetleń ekranu
+  uint64_t bytes; ///<liczba bajtów wysłanych do terminala
+  uint64_t* times; ///<czasy wyświetleń ekranu w nanosekundach
+  uint64_t times_size; ///<rozmiar tablicy @p times
+};
+
+/** @brief Podaje wartość cyfry szesnastkowej.
+ * @param[in] c       – znak.
+ * @return Wartość cyfry lub @p -1, jeśli znak nie jest cyfrą szesnastkową.
+ */
+static int hex_digit(int c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/** @brief Wczytuje następne zdarzenie nagrania.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji.
+ * @return Wartość @p true, jeśli wczytano poprawne zdarzenie, a @p false,
+ * jeśli nagranie się skończyło lub wiersz jest niepoprawny.
+ */
+static bool read_event(session_t* s) {
+  char line[LINE_SIZE];
+  if (fgets(line, LINE_SIZE, (*s).replay) == NULL) return false;
+  struct event* e = &((*s).next);
+  uint64_t us;
+  char kind;
+  int n = 0;
+  if (sscanf(line, "%" SCNu64 " %c %n", &us, &kind, &n) != 2) return false;
+  (*e).at = us * 1000;
+
+  if (kind == 'R') {
+    (*e).resize = true;
+    return sscanf(line + n, "%" SCNu32 " %" SCNu32, &((*e).rows),
+                  &((*e).columns)) == 2;
+  }
+  if (kind != 'K') return false;
+  (*e).resize = false;
+  (*e).length = 0;
+  const char* p = line + n;
+  while ((*e).length < SESSION_CHUNK && hex_digit(p[0]) >= 0
+         && hex_digit(p[1]) >= 0) {
+    (*e).data[(*e).length++] = (unsigned char)(16 * hex_digit(p[0])
+                                               + hex_digit(p[1]));
+    p += 2;
+  }
+  return (*e).length > 0;
+}
+
+/** @brief Usuwa strukturę sesji.
+ * @param[in] s       – wskaźnik na strukturę przechowującą stan sesji.
+ */
+static void session_free(session_t* s) {
+  if ((*s).record != NULL) fclose((*s).record);
+  if ((*s).replay != NULL) fclose((*s).replay);
+  free((*s).times);
+  free(s);
+}
+
+session_t* session_start() {
+  const char* replay = getenv("GAMMA_REPLAY");
+  const char* record = getenv("GAMMA_RECORD");
+  if (replay == NULL && record == NULL) return NULL;
+  session_t* s = calloc(1, sizeof(session_t));
+  if (s == NULL) return NULL;
+
+  if (replay != NULL) {
+    char line[LINE_SIZE];
+    (*s).replay = fopen(replay, "r");
+    // Nagranie zaczyna się rozmiarem okna.
+    if ((*s).replay == NULL || fgets(line, LINE_SIZE, (*s).replay) == NULL
+        || strcmp(line, "SESSION\n") != 0 || read_event(s) == false
+        || (*s).next.resize == false) {
+      session_free(s);
+      return NULL;
+    }
+    (*s).rows = (*s).next.rows;
+    (*s).columns = (*s).next.columns;
+    (*s).has_next = read_event(s);
+
+    const char* size = getenv("GAMMA_SIZE");
+    uint32_t rows, columns;
+    if (size != NULL
+        && sscanf(size, "%" SCNu32 "x%" SCNu32, &rows, &columns) == 2) {
+      (*s).fixed = true;
+      (*s).rows = rows;
+      (*s).columns = columns;
+    }
+    return s;
+  }
+
+  (*s).record = fopen(record, "w");
+  if ((*s).record == NULL) {
+    session_free(s);
+    return NULL;
+  }
+  fprintf((*s).record, "SESSION\n");
+  (*s).start = latency_now();
+  return s;
+}
+
+bool session_replaying(session_t* s) {
+  return s != NULL && (*s).replay != NULL;
+}
+
+bool session_size(session_t* s, uint32_t* rows, uint32_t* columns) {
+  if (session_replaying(s) == false) return false;
+  *rows = (*s).rows;
+  *columns = (*s).columns;
+  return true;
+}
+
+bool session_resized(session_t* s) {
+  if (s == NULL || (*s).resized == false) return false;
+  (*s).resized = false;
+  return true;
+}
+
+uint64_t session_now(session_t* s) {
+  if (session_replaying(s) == true) return (*s).clock;
+  return latency_now();
+}
+
+int session_replay(session_t* s, unsigned char* data, int timeout) {
+  if ((*s).has_next == false) return -1;
+  struct event* e = &((*s).next);
+  if (timeout >= 0 && (*e).at > (*s).clock + (uint64_t)timeout * 1000000) {
+    (*s).clock += (uint64_t)timeout * 1000000;
+    return 0;
+  }
+  if ((*e).at > (*s).clock) (*s).clock = (*e).at;
+
+  int result = 0;
+  if ((*e).resize == false) {
+    memcpy(data, (*e).data, (*e).length);
+    result = (int)(*e).length;
+  }
+  else if ((*s).fixed == false) {
+    (*s).rows = (*e).rows;
+    (*s).columns = (*e).columns;
+    (*s).resized = true;
+  }
+  (*s).has_next = read_event(s);
+  return result;
+}
+
+void session_record(session_t* s, const unsigned char* data, size_t length) {
+  if (s == NULL || (*s).record == NULL) return;
+  fprintf((*s).record, "%" PRIu64 " K ",
+          (latency_now() - (*s).start) / 1000);
+  for (size_t i = 0; i < length; i++) fprintf((*s).record, "%02x", data[i]);
+  fprintf((*s).record, "\n");
+}
+
+void session_record_size(session_t* s, uint32_t rows, uint32_t columns) {
+  if (s == NULL || (*s).record == NULL) return;
+  fprintf((*s).record, "%" PRIu64 " R %" PRIu32 " %" PRIu32 "\n",
+          (latency_now() - (*s).start) / 1000, rows, columns);
+}
+
+void session_key(session_t* s) {
+  if (s != NULL) (*s).keys++;
+}
+
+void session_frame(session_t* s, uint64_t ns, uint64_t bytes) {
+  if (s == NULL) return;
+  (*s).bytes += bytes;
+  if ((*s).frames == (*s).times_size) {
+    uint64_t size = 2 * (*s).times_size + 64;
+    uint64_t* temp = realloc((*s).times, sizeof(uint64_t) * size);
+    if (temp == NULL) return;
+    (*s).times = temp;
+    (*s).times_size = size;
+  }
+  (*s).times[(*s).frames++] = ns;
+}
+
+/** @brief Porównuje czasy.
+ * @param[in] a       – wskaźnik na pierwszy czas,
+ * @param[in] b       – wskaźnik na drugi czas.
+ * @return Liczba ujemna, zero lub dodatnia, gdy pierwszy czas jest
+ * odpowiednio mniejszy, równy lub większy od drugiego.
+ */
+static int compare_times(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+/** @brief Podaje percentyl czasów wyświetleń.
+ * @param[in] s       – wskaźnik na strukturę z posortowanymi czasami,
+ * @param[in] q       – percentyl jako ułamek z przedziału [0, 1].
+ * @return Najmniejszy czas, od którego nie jest większa część @p q czasów,
+ * lub @p 0, jeśli nie było wyświetleń.
+ */
+static uint64_t frame_percentile(session_t* s, double q) {
+  if ((*s).frames == 0) return 0;
+  double exact = q * (double)(*s).frames;
+  uint64_t rank = (uint64_t)exact;
+  if ((double)rank < exact || rank == 0) rank++;
+  return (*s).times[rank - 1];
+}
+
+void session_finish(session_t* s) {
+  if (s == NULL) return;
+  if (session_replaying(s) == true) {
+    if ((*s).frames > 0)
+      qsort((*s).times, (*s).frames, sizeof(uint64_t), compare_times);
+    double per_key = (*s).keys > 0 ? (double)(*s).bytes / (double)(*s).keys
+                                   : 0.0;
+    fprintf(stderr, "REPLAY keys frames bytes bytes_per_key\n");
+    fprintf(stderr, "%" PRIu64 " %" PRIu64 " %" PRIu64 " %.1f\n",
+            (*s).keys, (*s).frames, (*s).bytes, per_key);
+    fprintf(stderr, "FRAME p50 p99 max\n");
+    fprintf(stderr, "%" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+            frame_percentile(s, 0.5), frame_percentile(s, 0.99),
+            frame_percentile(s, 1.0));
+  }
+  session_free(s);
+}
@@ -0,0 +1,145 @@
+/** @file
+ * Interfejs modułu nagrywającego i odtwarzającego sesje trybu
+ * interaktywnego.
+ * Nagrywanie jest włączane zmienną środowiskową @p GAMMA_RECORD, której
+ * wartością jest nazwa pliku. Zapisywane są wczytane znaki, w takich
+ * porcjach, w jakich przyszły z terminala, i zmiany rozmiaru okna, razem
+ * z czasem od rozpoczęcia sesji.
+ *
+ * Zmienna środowiskowa @p GAMMA_REPLAY, której wartością jest nazwa pliku
+ * z nagraniem, włącza odtwarzanie: znaki są wczytywane z nagrania zamiast
+ * z terminala, a czas płynie według nagrania, więc sesja przebiega tak samo
+ * bez terminala i niezależnie od szybkości komputera. Zmienna środowiskowa
+ * @p GAMMA_SIZE o wartości @p "rowsxcolumns" ustala rozmiar okna, a zmiany
+ * rozmiaru z nagrania są wtedy pomijane. Po zakończeniu odtwarzania na
+ * standardowe wyjście diagnostyczne są wypisywane: liczba wciśniętych
+ * klawiszy, liczba wyświetleń ekranu, liczba bajtów wysłanych do terminala
+ * i średnia liczba bajtów na klawisz, a także percentyle p50, p99 i maksymalny
+ * czas wyświetlenia ekranu w nanosekundach.
+ *
+ * Nagranie jest plikiem tekstowym. Pierwszy wiersz to @p "SESSION", a każdy
+ * następny opisuje zdarzenie: @p "time K hex" dla porcji znaków zapisanych
+ * szesnastkowo lub @p "time R rows columns" dla rozmiaru okna, gdzie @p time
+ * jest czasem od rozpoczęcia sesji w mikrosekundach. Pierwsze zdarzenie podaje
+ * rozmiar okna na początku sesji.
+ *
+ * @author Karolina Drabik <kd417818@mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 17.05.2020
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Największa liczba znaków w jednej porcji nagrania.
+ */
+#define SESSION_CHUNK 256
+
+/**
+ * Typ przechowujący ustawienia i stan nagrywania lub odtwarzania sesji.
+ */
+typedef struct session session_t;
+
+/** @brief Rozpoczyna nagrywanie lub odtwarzanie sesji.
+ * Jeśli ustawiono zmienną środowiskową @p GAMMA_REPLAY, otwiera nagranie
+ * i wczytuje rozmiar okna, a w przeciwnym razie, jeśli ustawiono zmienną
+ * środowiskową @p GAMMA_RECORD, tworzy plik nagrania.
+ * @return Wskaźnik na utworzoną strukturę lub @p NULL, gdy obie zmienne nie są
+ * ustawione, nie udało się otworzyć pliku lub zaalokować pamięci albo
+ * nagranie jest niepoprawne.
+ */
+session_t* session_start();
+
+/** @brief Sprawdza, czy sesja jest odtwarzana.
+ * @param[in] s       – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL.
+ * @return Wartość @p true, jeśli sesja jest odtwarzana, a @p false
+ * w przeciwnym przypadku.
+ */
+bool session_replaying(session_t* s);
+
+/** @brief Podaje rozmiar okna odtwarzanej sesji.
+ * @param[in] s       – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL,
+ * @param[out] rows   – wskaźnik na liczbę wierszy okna,
+ * @param[out] columns – wskaźnik na liczbę kolumn okna.
+ * @return Wartość @p true, jeśli sesja jest odtwarzana, a @p false
+ * w przeciwnym przypadku; rozmiar trzeba wtedy pobrać z terminala.
+ */
+bool session_size(session_t* s, uint32_t* rows, uint32_t* columns);
+
+/** @brief Sprawdza, czy w odtwarzanej sesji zmienił się rozmiar okna.
+ * Informacja jest zapominana po odczytaniu.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL.
+ * @return Wartość @p true, jeśli w nagraniu wystąpiła zmiana rozmiaru okna,
+ * a @p false w przeciwnym przypadku.
+ */
+bool session_resized(session_t* s);
+
+/** @brief Podaje bieżący czas sesji.
+ * @param[in] s       – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL.
+ * @return Czas z nagrania dla odtwarzanej sesji, a w przeciwnym przypadku
+ * czas zegara monotonicznego, w nanosekundach.
+ */
+uint64_t session_now(session_t* s);
+
+/** @brief Wczytuje porcję znaków z nagrania.
+ * Czeka co najwyżej @p timeout milisekund czasu sesji na kolejne zdarzenie
+ * nagrania i przesuwa czas sesji.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji,
+ * @param[out] data   – wskaźnik na tablicę co najmniej @ref SESSION_CHUNK
+ *                      znaków,
+ * @param[in] timeout – czas oczekiwania w milisekundach, lub @p -1, by czekać
+ *                      bez ograniczenia.
+ * @return Liczba wczytanych znaków, @p 0, jeśli minął czas lub zmienił się
+ * rozmiar okna, albo @p -1, jeśli nagranie się skończyło.
+ */
+int session_replay(session_t* s, unsigned char* data, int timeout);
+
+/** @brief Zapisuje porcję znaków do nagrania.
+ * Nic nie robi, jeśli sesja nie jest nagrywana.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL,
+ * @param[in] data    – wskaźnik na tablicę znaków,
+ * @param[in] length  – liczba znaków, nie większa od @ref SESSION_CHUNK.
+ */
+void session_record(session_t* s, const unsigned char* data, size_t length);
+
+/** @brief Zapisuje rozmiar okna do nagrania.
+ * Nic nie robi, jeśli sesja nie jest nagrywana.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL,
+ * @param[in] rows    – liczba wierszy okna,
+ * @param[in] columns – liczba kolumn okna.
+ */
+void session_record_size(session_t* s, uint32_t rows, uint32_t columns);
+
+/** @brief Zlicza wciśnięty klawisz.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL.
+ */
+void session_key(session_t* s);
+
+/** @brief Zapisuje pomiar wyświetlenia ekranu.
+ * @param[in, out] s  – wskaźnik na strukturę przechowującą stan sesji lub
+ *                      @p NULL,
+ * @param[in] ns      – czas wyświetlenia w nanosekundach,
+ * @param[in] bytes   – liczba bajtów wysłanych do terminala.
+ */
+void session_frame(session_t* s, uint64_t ns, uint64_t bytes);
+
+/** @brief Kończy nagrywanie lub odtwarzanie sesji.
+ * Zamyka pliki, po odtwarzaniu wypisuje wyniki pomiarów i usuwa strukturę
+ * wskazywaną przez @p s. Nic nie robi, jeśli wskaźnik ten ma wartość @p NULL.
+ * @param[in] s       – wskaźnik na strukturę przechowującą stan sesji.
+ */
+void session_finish(session_t* s);
+
+#endif /* SESSION_H */